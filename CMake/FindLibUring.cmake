@@ -0,0 +1,18 @@
+find_path(_liburing_INCLUDE_DIR liburing.h
+  HINTS ${LIBURING_ROOT}/include
+  PATHS /usr/include /usr/local/include /opt/local/include)
+
+find_library(_liburing_LIBRARY NAMES uring
+  HINTS ${LIBURING_ROOT}/lib
+  PATHS /usr/lib /usr/local/lib /opt/local/lib)
+
+include(FindPackageHandleStandardArgs)
+FIND_PACKAGE_HANDLE_STANDARD_ARGS(LibUring DEFAULT_MSG
+  _liburing_INCLUDE_DIR _liburing_LIBRARY)
+
+set(LIBURING_INCLUDE_DIRS ${_liburing_INCLUDE_DIR})
+set(LIBURING_LIBRARIES ${_liburing_LIBRARY})
+
+if(LIBURING_FOUND)
+  message(STATUS "Found liburing in ${LIBURING_INCLUDE_DIRS};${LIBURING_LIBRARIES}")
+endif()
@@ -23,6 +23,7 @@
 
 #include "iCommand.h"
 #include "connection.h"
+#include "connectionDescription.h"
 #include "dataIStream.h"
 #include "dataOStream.h"
 #include "global.h"
@@ -33,8 +34,11 @@
 #include "exception.h"
 
 #include <lunchbox/monitor.h>
+#include <lunchbox/scopedMutex.h>
 #include <lunchbox/stdExt.h>
 
+#include <algorithm>
+
 namespace co
 {
 namespace
@@ -51,6 +55,19 @@ struct Request
 
 typedef stde::hash_map< uint128_t, Request > RequestMap;
 typedef RequestMap::iterator RequestMapIter;
+
+typedef std::vector< NodeID > NodeIDs;
+typedef NodeIDs::const_iterator NodeIDsCIter;
+
+struct TreeRequest
+{
+    TreeRequest() : entered( false ) {}
+    bool entered;     //!< the local participant has entered
+    NodeIDs children; //!< the children whose subtree has entered
+};
+
+typedef stde::hash_map< uint128_t, TreeRequest > TreeRequestMap;
+typedef TreeRequestMap::iterator TreeRequestMapIter;
 }
 
 namespace detail
@@ -58,13 +75,30 @@ namespace detail
 class Barrier
 {
 public:
-    Barrier() : height( 0 ) {}
+    Barrier()
+        : height( 0 )
+        , algorithm( co::Barrier::ALGORITHM_CENTRAL )
+        , fanout( 4 )
+        , treeReady( false )
+    {}
     Barrier( NodePtr m, const uint32_t h )
         : masterID( m ? m->getNodeID() : NodeID( ))
         , height( h )
         , master( m )
+        , algorithm( co::Barrier::ALGORITHM_CENTRAL )
+        , fanout( 4 )
+        , treeReady( false )
     {}
 
+    void resetTree()
+    {
+        lunchbox::ScopedMutex<> mutex( treeLock );
+        participants.clear();
+        parent = 0;
+        children.clear();
+        treeReady = false;
+    }
+
     /** The master barrier node. */
     NodeID   masterID;
 
@@ -79,6 +113,31 @@ public:
 
     /** The monitor used for barrier leave notification. */
     lunchbox::Monitor< uint32_t > leaveNotify;
+
+    /** The synchronization algorithm and tree fanout. */
+    uint32_t algorithm;
+    uint32_t fanout;
+
+    /**
+     * Protects the tree nodes below, which are set up by the application thread
+     * and used by the command thread.
+     */
+    lunchbox::Lock treeLock;
+
+    /** The participants of the last central round, master node first. */
+    NodeIDs participants;
+
+    /** The tree parent, invalid on the root node. */
+    NodePtr parent;
+
+    /** The tree children of this node. */
+    Nodes children;
+
+    /** The tree nodes have been set up from the participants. */
+    bool treeReady;
+
+    /** Combined tree entries, index per version. */
+    TreeRequestMap treeRequests;
 };
 }
 
@@ -99,39 +158,71 @@ Barrier::~Barrier()
 void Barrier::getInstanceData( DataOStream& os )
 {
     LBASSERT( _impl->masterID != NodeID( ));
-    os << _impl->height << _impl->masterID;
+    os << _impl->height << _impl->masterID << _impl->algorithm
+       << _impl->fanout;
     _impl->leaveNotify = 0;
 }
 
 void Barrier::applyInstanceData( DataIStream& is )
 {
-    is >> _impl->height >> _impl->masterID;
+    is >> _impl->height >> _impl->masterID >> _impl->algorithm
+       >> _impl->fanout;
+    _impl->resetTree();
     _impl->leaveNotify = 0;
 }
 
 void Barrier::pack( DataOStream& os )
 {
-    os << _impl->height;
+    os << _impl->height << _impl->algorithm << _impl->fanout;
     _impl->leaveNotify = 0;
 }
 
 void Barrier::unpack( DataIStream& is )
 {
-    is >> _impl->height;
+    uint32_t height, algorithm, fanout;
+    is >> height >> algorithm >> fanout;
+
+    if( height != _impl->height || algorithm != _impl->algorithm ||
+        fanout != _impl->fanout )
+    {
+        _impl->resetTree();
+    }
+    _impl->height = height;
+    _impl->algorithm = algorithm;
+    _impl->fanout = fanout;
     _impl->leaveNotify = 0;
 }
 
 //---------------------------------------------------------------------------
 void Barrier::setHeight( const uint32_t height )
 {
+    if( height != _impl->height )
+        _impl->resetTree();
     _impl->height = height;
 }
 
 void Barrier::increase()
 {
+    _impl->resetTree();
     ++_impl->height;
 }
 
+void Barrier::setAlgorithm( const Algorithm algorithm, const uint32_t fanout )
+{
+    LBASSERT( fanout > 0 );
+    if( uint32_t( algorithm ) == _impl->algorithm && fanout == _impl->fanout )
+        return;
+
+    _impl->resetTree();
+    _impl->algorithm = algorithm;
+    _impl->fanout = fanout;
+}
+
+Barrier::Algorithm Barrier::getAlgorithm() const
+{
+    return Algorithm( _impl->algorithm );
+}
+
 uint32_t Barrier::getHeight() const
 {
     return _impl->height;
@@ -148,6 +239,10 @@ void Barrier::attach( const UUID& id, const uint32_t instanceID )
                      CmdFunc( this, &Barrier::_cmdEnter ), queue );
     registerCommand( CMD_BARRIER_ENTER_REPLY,
                      CmdFunc( this, &Barrier::_cmdEnterReply ), queue );
+    registerCommand( CMD_BARRIER_ENTER_TREE,
+                     CmdFunc( this, &Barrier::_cmdEnterTree ), queue );
+    registerCommand( CMD_BARRIER_LEAVE_TREE,
+                     CmdFunc( this, &Barrier::_cmdLeaveTree ), queue );
 
     if( _impl->masterID == NodeID( ))
         _impl->masterID = node->getNodeID();
@@ -180,14 +275,24 @@ void Barrier::enter( const uint32_t timeout )
                          << ", height " << _impl->height << std::endl;
 
     const uint32_t leaveVal = _impl->leaveNotify.get() + 1;
+    const bool tree = _setupTree();
 
-    send( _impl->master, CMD_BARRIER_ENTER )
-        << getVersion() << _impl->leaveNotify.get() << timeout;
+    if( tree )
+        send( getLocalNode().get(), CMD_BARRIER_ENTER_TREE )
+            << getVersion() << true;
+    else
+        send( _impl->master, CMD_BARRIER_ENTER )
+            << getVersion() << _impl->leaveNotify.get() << timeout;
 
     if( timeout == LB_TIMEOUT_INDEFINITE )
         _impl->leaveNotify.waitEQ( leaveVal );
     else if( !_impl->leaveNotify.timedWaitEQ( leaveVal, timeout ))
+    {
+        if( tree ) // withdraw local entry, a retry enters the same round
+            send( getLocalNode().get(), CMD_BARRIER_ENTER_TREE )
+                << getVersion() << false;
         throw Exception( Exception::TIMEOUT_BARRIER );
+    }
 
     LBLOG( LOG_BARRIER ) << "left barrier " << getID() << " v" << getVersion()
                          << ", height " << _impl->height << std::endl;
@@ -274,8 +379,38 @@ bool Barrier::_cmdEnter( ICommand& cmd )
 
     stde::usort( nodes );
 
-    for( NodesIter i = nodes.begin(); i != nodes.end(); ++i )
-        _sendNotify( version, *i );
+    if( _impl->algorithm == ALGORITHM_TREE )
+    {
+        // distribute the participants for the tree used in the next rounds
+        lunchbox::ScopedMutex<> mutex( _impl->treeLock );
+        NodeIDs& participants = _impl->participants;
+        participants.clear();
+        participants.push_back( getLocalNode()->getNodeID( ));
+        for( NodesCIter i = nodes.begin(); i != nodes.end(); ++i )
+            if( !(*i)->isLocal( ))
+                participants.push_back( (*i)->getNodeID( ));
+        std::sort( participants.begin() + 1, participants.end( ));
+        _impl->treeReady = false;
+    }
+
+    ConnectionPtr multicast = _getMulticast( nodes );
+    if( multicast )
+    {
+        // one release for all remote participants, local ones unlock directly
+        LBLOG( LOG_BARRIER ) << "Unlock " << nodes.size() << " nodes using "
+                             << multicast->getDescription() << std::endl;
+        lunchbox::ScopedMutex<> mutex( _impl->treeLock );
+        ObjectOCommand( Connections( 1, multicast ), CMD_BARRIER_ENTER_REPLY,
+                        COMMANDTYPE_OBJECT, getID(), EQ_INSTANCE_NONE )
+            << version << _impl->participants;
+
+        for( NodesIter i = nodes.begin(); i != nodes.end(); ++i )
+            if( (*i)->isLocal( ))
+                _sendNotify( version, *i );
+    }
+    else
+        for( NodesIter i = nodes.begin(); i != nodes.end(); ++i )
+            _sendNotify( version, *i );
 
     // delete node vector for version
     RequestMapIter i = _impl->enteredNodes.find( version );
@@ -301,10 +436,35 @@ void Barrier::_sendNotify( const uint128_t& version, NodePtr node )
     else
     {
         LBLOG( LOG_BARRIER ) << "Unlock " << node << std::endl;
-        send( node, CMD_BARRIER_ENTER_REPLY ) << version;
+        lunchbox::ScopedMutex<> mutex( _impl->treeLock );
+        send( node, CMD_BARRIER_ENTER_REPLY ) << version
+                                              << _impl->participants;
     }
 }
 
+ConnectionPtr Barrier::_getMulticast( const Nodes& nodes )
+{
+    // usable if all remote participants share the same multicast group
+    ConnectionPtr multicast;
+    size_t nRemote = 0;
+    for( NodesCIter i = nodes.begin(); i != nodes.end(); ++i )
+    {
+        NodePtr node = *i;
+        if( node->isLocal( ))
+            continue;
+
+        ConnectionPtr connection = node->getConnection( true );
+        if( !connection || !connection->isMulticast( ))
+            return 0;
+        if( multicast && connection != multicast )
+            return 0;
+
+        multicast = connection;
+        ++nRemote;
+    }
+    return nRemote > 1 ? multicast : 0;
+}
+
 void Barrier::_cleanup( const uint64_t time )
 {
     LB_TS_THREAD( _thread );
@@ -338,12 +498,202 @@ bool Barrier::_cmdEnterReply( ICommand& cmd )
 {
     ObjectICommand command( cmd );
     LB_TS_THREAD( _thread );
+    // multicast releases may be received by the sending master as well
+    if( command.getNode()->isLocal( ))
+        return true;
+
     LBLOG( LOG_BARRIER ) << "Got ok, unlock local user(s)" << std::endl;
     const uint128_t version = command.get< uint128_t >();
+    NodeIDs participants;
+    command >> participants;
+
+    if( version == getVersion( ))
+    {
+        if( !participants.empty( ))
+        {
+            lunchbox::ScopedMutex<> mutex( _impl->treeLock );
+            _impl->participants.swap( participants );
+            _impl->treeReady = false;
+        }
+        ++_impl->leaveNotify;
+    }
+    return true;
+}
+
+//---------------------------------------------------------------------------
+// tree algorithm
+//---------------------------------------------------------------------------
+bool Barrier::_setupTree()
+{
+    if( _impl->algorithm != ALGORITHM_TREE )
+        return false;
+
+    // participants are known after the first central round
+    NodeIDs participants;
+    {
+        lunchbox::ScopedMutex<> mutex( _impl->treeLock );
+        if( _impl->treeReady )
+            return true;
+        participants = _impl->participants;
+    }
+    if( participants.empty( ))
+    {
+        LBLOG( LOG_BARRIER ) << "Barrier tree participants unknown, use central"
+                             << " algorithm" << std::endl;
+        return false;
+    }
+    if( participants.size() != _impl->height )
+    {
+        LBINFO << "Barrier tree has " << participants.size()
+               << " participants for height " << _impl->height
+               << ", falling back to central algorithm" << std::endl;
+        return false;
+    }
+
+    LocalNodePtr localNode = getLocalNode();
+    const NodeIDsCIter i = std::find( participants.begin(), participants.end(),
+                                      localNode->getNodeID( ));
+    if( i == participants.end( ))
+    {
+        LBINFO << "Local node is not a barrier tree participant, falling back"
+               << " to central algorithm" << std::endl;
+        return false;
+    }
+
+    const size_t index = i - participants.begin();
+    const size_t fanout = _impl->fanout > 0 ? _impl->fanout : 1;
+
+    // connect without holding the lock, the command thread handles the connect
+    NodePtr parent;
+    if( index > 0 )
+    {
+        parent = localNode->connect( participants[ (index - 1) / fanout ] );
+        if( !parent )
+        {
+            LBWARN << "Can't connect barrier tree parent, falling back to "
+                   << "central algorithm" << std::endl;
+            return false;
+        }
+    }
+
+    Nodes children;
+    const size_t first = index * fanout + 1;
+    for( size_t j = first; j < first + fanout && j < participants.size(); ++j )
+    {
+        NodePtr child = localNode->connect( participants[ j ] );
+        if( !child )
+        {
+            LBWARN << "Can't connect barrier tree child, falling back to "
+                   << "central algorithm" << std::endl;
+            return false;
+        }
+        children.push_back( child );
+    }
+
+    lunchbox::ScopedMutex<> mutex( _impl->treeLock );
+    if( _impl->participants != participants ) // changed while connecting
+    {
+        LBLOG( LOG_BARRIER ) << "Barrier tree participants changed, use "
+                             << "central algorithm" << std::endl;
+        return false;
+    }
+
+    _impl->parent = parent;
+    _impl->children.swap( children );
+    _impl->treeReady = true;
+
+    LBLOG( LOG_BARRIER ) << "barrier tree node " << index << " of "
+                         << participants.size() << ", "
+                         << _impl->children.size() << " children" << std::endl;
+    return true;
+}
+
+void Barrier::_checkTree( const uint128_t& version )
+{
+    LB_TS_THREAD( _thread );
+
+    TreeRequestMapIter i = _impl->treeRequests.find( version );
+    if( i == _impl->treeRequests.end( ))
+        return;
+
+    lunchbox::ScopedMutex<> mutex( _impl->treeLock );
+    const TreeRequest& request = i->second;
+    if( !request.entered || request.children.size() < _impl->children.size( ))
+        return;
+
+    _impl->treeRequests.erase( i );
+    if( _impl->parent )
+    {
+        LBLOG( LOG_BARRIER ) << "Subtree entered, notify " << _impl->parent
+                             << std::endl;
+        send( _impl->parent, CMD_BARRIER_ENTER_TREE ) << version << true;
+        return;
+    }
+
+    LBLOG( LOG_BARRIER ) << "Barrier reached" << std::endl;
+    _leaveTree( version );
+}
+
+// called with the tree lock held
+void Barrier::_leaveTree( const uint128_t& version )
+{
+    LB_TS_THREAD( _thread );
+
+    for( NodesCIter i = _impl->children.begin(); i != _impl->children.end();
+         ++i )
+    {
+        send( *i, CMD_BARRIER_LEAVE_TREE ) << version;
+    }
 
     if( version == getVersion( ))
         ++_impl->leaveNotify;
+}
+
+bool Barrier::_cmdEnterTree( ICommand& cmd )
+{
+    LB_TS_THREAD( _thread );
+
+    ObjectICommand command( cmd );
+    const uint128_t version = command.get< uint128_t >();
+    const bool enter = command.get< bool >();
+    NodePtr node = command.getNode();
+
+    LBLOG( LOG_BARRIER ) << "handle barrier tree enter " << command
+                         << " v" << version << " barrier v" << getVersion()
+                         << std::endl;
+
+    if( version < getVersion( ))
+    {
+        // a timeout has been handled, unblock the subtree directly
+        if( enter && !node->isLocal( ))
+            send( node, CMD_BARRIER_LEAVE_TREE ) << version;
+        return true;
+    }
+
+    TreeRequest& request = _impl->treeRequests[ version ];
+    if( node->isLocal( ))
+        request.entered = enter;
+    else if( std::find( request.children.begin(), request.children.end(),
+                        node->getNodeID( )) == request.children.end( ))
+    {
+        request.children.push_back( node->getNodeID( ));
+    }
+
+    _checkTree( version );
+    return true;
+}
+
+bool Barrier::_cmdLeaveTree( ICommand& cmd )
+{
+    LB_TS_THREAD( _thread );
+
+    ObjectICommand command( cmd );
+    const uint128_t version = command.get< uint128_t >();
 
+    LBLOG( LOG_BARRIER ) << "Got tree release, unlock local user(s)"
+                         << std::endl;
+    lunchbox::ScopedMutex<> mutex( _impl->treeLock );
+    _leaveTree( version );
     return true;
 }
 
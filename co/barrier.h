@@ -32,6 +32,24 @@ namespace detail { class Barrier; }
     class Barrier : public Object
     {
     public:
+        /** The algorithm used to synchronize the participants. @version 1.1 */
+        enum Algorithm
+        {
+            /** All participants enter and are released by the master node. */
+            ALGORITHM_CENTRAL,
+
+            /**
+             * Entries are combined and releases are forwarded along a k-ary
+             * tree of the participants, rooted at the master node.
+             *
+             * The tree is built from the participants of the first barrier
+             * round, which uses the central algorithm. It is rebuilt after the
+             * height or the algorithm changes. All later rounds have to be
+             * entered by the same set of nodes.
+             */
+            ALGORITHM_TREE
+        };
+
         /**
          * Construct a new barrier.
          *
@@ -68,6 +86,19 @@ namespace detail { class Barrier; }
 
         /** @return the number of participants. @version 1.0 */
         CO_API uint32_t getHeight() const;
+
+        /**
+         * Set the synchronization algorithm.
+         *
+         * @param algorithm the algorithm used by all participants.
+         * @param fanout the number of children per node for ALGORITHM_TREE.
+         * @version 1.1
+         */
+        CO_API void setAlgorithm( const Algorithm algorithm,
+                                  const uint32_t fanout = 4 );
+
+        /** @return the synchronization algorithm. @version 1.1 */
+        CO_API Algorithm getAlgorithm() const;
         //@}
 
         /** @name Operations */
@@ -101,10 +132,17 @@ namespace detail { class Barrier; }
 
         void _cleanup( const uint64_t time );
         void _sendNotify( const uint128_t& version, NodePtr node );
+        ConnectionPtr _getMulticast( const Nodes& nodes );
+
+        bool _setupTree();
+        void _checkTree( const uint128_t& version );
+        void _leaveTree( const uint128_t& version );
 
         /* The command handlers. */
         bool _cmdEnter( ICommand& command );
         bool _cmdEnterReply( ICommand& command );
+        bool _cmdEnterTree( ICommand& command );
+        bool _cmdLeaveTree( ICommand& command );
 
         LB_TS_VAR( _thread );
     };
@@ -0,0 +1,197 @@
+
+/* Copyright (c) 2026, The Collage Authors
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "byteRing.h"
+
+#include "log.h"
+
+#include <lunchbox/os.h>
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+namespace co
+{
+namespace
+{
+inline uint64_t _load( const uint64_t& value )
+{
+    return __atomic_load_n( &value, __ATOMIC_ACQUIRE );
+}
+
+inline void _store( uint64_t& value, const uint64_t newValue )
+{
+    __atomic_store_n( &value, newValue, __ATOMIC_RELEASE );
+}
+
+/** Publish a waiting flag before re-checking the ring. */
+inline void _setWaiting( uint32_t& flag )
+{
+    __atomic_store_n( &flag, 1, __ATOMIC_RELAXED );
+    __atomic_thread_fence( __ATOMIC_SEQ_CST );
+}
+
+inline void _signal( const int fd )
+{
+    const uint64_t one = 1;
+    if( ::write( fd, &one, sizeof( one )) != sizeof( one ))
+        LBWARN << "Can't signal eventfd: " << lunchbox::sysError << std::endl;
+}
+
+/** Wake the other side after updating the ring, if it waits. */
+inline void _wake( uint32_t& flag, const int fd )
+{
+    __atomic_thread_fence( __ATOMIC_SEQ_CST );
+    if( __atomic_load_n( &flag, __ATOMIC_RELAXED ) &&
+        __atomic_exchange_n( &flag, 0, __ATOMIC_SEQ_CST ))
+    {
+        _signal( fd );
+    }
+}
+
+inline void _reset( const int fd )
+{
+    uint64_t value;
+    if( ::read( fd, &value, sizeof( value )) < 0 && errno != EAGAIN )
+        LBWARN << "Can't reset eventfd: " << lunchbox::sysError << std::endl;
+}
+}
+
+ByteRing::ByteRing()
+    : _state( 0 )
+    , _data( 0 )
+    , _mask( 0 )
+    , _dataFD( -1 )
+    , _spaceFD( -1 )
+{}
+
+void ByteRing::init( State& state )
+{
+    state.readerWaiting = 1; // the new ring is empty
+}
+
+void ByteRing::setup( State* state, uint8_t* data, const uint64_t size,
+                      const int dataFD, const int spaceFD )
+{
+    LBASSERT( ( size & ( size - 1 )) == 0 );
+    _state = state;
+    _data = data;
+    _mask = size - 1;
+    _dataFD = dataFD;
+    _spaceFD = spaceFD;
+}
+
+uint64_t ByteRing::read( void* buffer, const uint64_t bytes )
+{
+    State& state = *_state;
+    for( ;; )
+    {
+        // The indices are shared with a process which may be broken or
+        // hostile, never copy more than the ring holds.
+        const uint64_t tail = state.tail;
+        const uint64_t head = _load( state.head );
+        const uint64_t available = head - tail;
+        if( available > _mask + 1 )
+            return _corrupted( head, tail );
+        if( available > 0 )
+        {
+            const uint64_t size = LB_MIN( bytes, available );
+            const uint64_t offset = tail & _mask;
+            const uint64_t first = LB_MIN( size, _mask + 1 - offset );
+            uint8_t* out = static_cast< uint8_t* >( buffer );
+
+            ::memcpy( out, _data + offset, first );
+            ::memcpy( out + first, _data, size - first );
+            _store( state.tail, tail + size );
+            _wake( state.writerWaiting, _spaceFD );
+
+            if( size == available ) // emptied, re-arm the data eventfd
+            {
+                _reset( _dataFD );
+                _setWaiting( state.readerWaiting );
+                if( _load( state.head ) != tail + size )
+                    _wake( state.readerWaiting, _dataFD );
+            }
+            return size;
+        }
+
+        _reset( _dataFD );
+        _setWaiting( state.readerWaiting );
+        if( _load( state.head ) == tail )
+            return 0;
+    }
+}
+
+uint64_t ByteRing::write( const void* buffer, const uint64_t bytes )
+{
+    State& state = *_state;
+    const uint64_t head = state.head;
+    for( ;; )
+    {
+        const uint64_t tail = _load( state.tail );
+        const uint64_t used = head - tail;
+        if( used > _mask + 1 )
+            return _corrupted( head, tail );
+
+        const uint64_t space = _mask + 1 - used;
+        if( space > 0 )
+        {
+            const uint64_t size = LB_MIN( bytes, space );
+            const uint64_t offset = head & _mask;
+            const uint64_t first = LB_MIN( size, _mask + 1 - offset );
+            const uint8_t* in = static_cast< const uint8_t* >( buffer );
+
+            ::memcpy( _data + offset, in, first );
+            ::memcpy( _data, in + first, size - first );
+            _store( state.head, head + size );
+            _wake( state.readerWaiting, _dataFD );
+            return size;
+        }
+
+        _reset( _spaceFD );
+        _setWaiting( state.writerWaiting );
+        if( head - _load( state.tail ) == _mask + 1 )
+            return 0;
+    }
+}
+
+uint64_t ByteRing::_corrupted( const uint64_t head, const uint64_t tail )
+{
+    LBWARN << "Inconsistent ring indices, head " << head << " tail " << tail
+           << " size " << _mask + 1 << ", closing ring" << std::endl;
+    close();
+    return CORRUPTED;
+}
+
+void ByteRing::close()
+{
+    if( !_state )
+        return;
+
+    __atomic_store_n( &_state->closed, 1, __ATOMIC_SEQ_CST );
+    _signal( _dataFD );
+    _signal( _spaceFD );
+}
+
+bool ByteRing::isClosed() const
+{
+    return _state && __atomic_load_n( &_state->closed, __ATOMIC_SEQ_CST );
+}
+}
@@ -0,0 +1,114 @@
+
+/* Copyright (c) 2026, The Collage Authors
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef CO_BYTERING_H
+#define CO_BYTERING_H
+
+#include <co/types.h>
+#include <lunchbox/nonCopyable.h>
+
+namespace co
+{
+#ifndef __linux__
+#  error ByteRing only supported on Linux
+#endif
+
+/**
+ * A lock-free, single-producer, single-consumer byte ring.
+ *
+ * The state and the data of the ring may be placed in shared memory. A reader
+ * finding the ring empty, or a writer finding it full, announces in the state
+ * that it waits. Only then the other side signals the data or space eventfd,
+ * so the ring costs no system calls while both sides are busy.
+ */
+class ByteRing : public lunchbox::NonCopyable
+{
+public:
+    /** The state of a ring, shared by both sides. */
+    struct State
+    {
+        uint64_t head; //!< bytes written, only advanced by the writer
+        uint8_t pad0[ 64 - sizeof( uint64_t ) ];
+        uint64_t tail; //!< bytes read, only advanced by the reader
+        uint8_t pad1[ 64 - sizeof( uint64_t ) ];
+        uint32_t readerWaiting; //!< signal the data eventfd on write
+        uint32_t writerWaiting; //!< signal the space eventfd on read
+        uint32_t closed;        //!< one side closed the ring
+        uint8_t pad2[ 64 - 3 * sizeof( uint32_t ) ];
+    };
+
+    ByteRing();
+
+    /** Returned by read() and write() if the peer corrupted the indices. */
+    static const uint64_t CORRUPTED = ~uint64_t( 0 );
+
+    /** Initialize the zeroed state of a new ring. */
+    static void init( State& state );
+
+    /**
+     * Set up one side of a ring. The memory and eventfds are not owned.
+     *
+     * @param size the size of the data, a power of two.
+     */
+    void setup( State* state, uint8_t* data, uint64_t size, int dataFD,
+                int spaceFD );
+
+    /**
+     * Read available data without blocking.
+     *
+     * @return the bytes read, or 0 if the ring is empty. The data eventfd is
+     *         then signalled by the next write. It stays signalled while data
+     *         is left in the ring. CORRUPTED if the indices are inconsistent,
+     *         the ring is then closed.
+     */
+    uint64_t read( void* buffer, uint64_t bytes );
+
+    /**
+     * Write data without blocking.
+     *
+     * @return the bytes written, or 0 if the ring is full. The space eventfd is
+     *         then signalled by the next read. CORRUPTED if the indices are
+     *         inconsistent, the ring is then closed.
+     */
+    uint64_t write( const void* buffer, uint64_t bytes );
+
+    /** Close the ring and wake both sides. */
+    void close();
+
+    /** @return true if one side closed the ring. */
+    bool isClosed() const;
+
+    /** @return the eventfd signalled when data is available. */
+    int getDataFD() const { return _dataFD; }
+
+    /** @return the eventfd signalled when space is available. */
+    int getSpaceFD() const { return _spaceFD; }
+
+private:
+    State* _state;
+    uint8_t* _data;
+    uint64_t _mask;
+    int _dataFD;
+    int _spaceFD;
+
+    uint64_t _corrupted( uint64_t head, uint64_t tail );
+};
+}
+
+#endif //CO_BYTERING_H
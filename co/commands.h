@@ -41,11 +41,26 @@ namespace co
         CMD_INVALID = 0xFFFFFFFFu //!< @internal
     };
 
+    /** @internal The send priority of a command, lower values go first. */
+    enum CommandPriority
+    {
+        COMMANDPRIORITY_CONTROL,  //!< Small commands, e.g., barriers and acks
+        COMMANDPRIORITY_DELTA,    //!< Object deltas of a commit
+        COMMANDPRIORITY_INSTANCE, //!< Object instance data, e.g., for a map
+        COMMANDPRIORITY_ALL
+    };
+
     /** @internal Minimal packet size sent by DataOStream / read by LocalNode */
     static const size_t COMMAND_MINSIZE = 256;
 
     /** @internal Minimal allocation size of a packet. */
     static const size_t COMMAND_ALLOCSIZE = 4096; // Bigger than minSize!
+
+    /** @internal Size of the reads of LocalNode, holding multiple packets. */
+    static const size_t COMMAND_RECVSIZE = 65536;
+
+    /** @internal Size field flag of a command sent without padding. */
+    static const uint64_t COMMAND_UNPADDED = 0x8000000000000000ull;
 }
 
 namespace lunchbox
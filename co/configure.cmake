@@ -36,6 +36,10 @@ if(UDT_FOUND)
   list(APPEND COLLAGE_DEFINES CO_USE_UDT)
 endif(UDT_FOUND)
 
+if(LIBURING_FOUND)
+  list(APPEND COLLAGE_DEFINES CO_USE_LIBURING)
+endif(LIBURING_FOUND)
+
 if(LUNCHBOX_USE_DNSSD)
   list(APPEND COLLAGE_DEFINES CO_USE_SERVUS)
 endif()
@@ -27,6 +27,10 @@
 #include "pipeConnection.h"
 #include "socketConnection.h"
 #include "rspConnection.h"
+#ifdef __linux__
+#  include "shmConnection.h"
+#  include "stripedConnection.h"
+#endif
 
 #ifdef _WIN32
 #  include "namedPipeConnection.h"
@@ -44,8 +48,10 @@
 #  include "udtConnection.h"
 #endif
 
+#include <lunchbox/monitor.h>
 #include <lunchbox/scopedMutex.h>
 #include <lunchbox/stdExt.h>
+#include <lunchbox/thread.h>
 
 //#define STATISTICS
 #ifdef STATISTICS
@@ -81,21 +87,55 @@ public:
     co::Connection::State state; //!< The connection state
     ConnectionDescriptionPtr description; //!< The connection parameters
 
-    /** The lock used to protect concurrent write calls. */
-    mutable lunchbox::Lock sendLock;
+    /** Protects the send lock state and the waiting senders. */
+    lunchbox::Lock sendLock;
+    bool sendLocked; //!< a thread holds the send lock
+
+    /** The number of threads waiting for the send lock, per priority. */
+    uint32_t waiting[ COMMANDPRIORITY_ALL ];
+
+    /**
+     * Incremented on unlock for the highest waiting priority only, waiting
+     * senders wait for a change of their priority.
+     */
+    lunchbox::Monitor< uint32_t > sendUnlocked[ COMMANDPRIORITY_ALL ];
 
     BufferPtr buffer; //!< Current async read buffer
     uint64_t bytes; //!< Current read request size
+    bool partial; //!< Current read completes with the first data received
 
     /** The listeners on state changes */
     ConnectionListeners listeners;
 
+    bool unpaddedCommands; //!< Peer reads commands without padding
+    bool fragmentedItems; //!< Peer reads items spanning data commands
+    bool batchedMapping; //!< Peer handles batched object mapping commands
+
     Connection()
             : state( co::Connection::STATE_CLOSED )
             , description( new ConnectionDescription )
+            , sendLocked( false )
             , bytes( 0 )
+            , partial( false )
+            , unpaddedCommands( false )
+            , fragmentedItems( false )
+            , batchedMapping( false )
     {
         description->type = CONNECTIONTYPE_NONE;
+        for( size_t i = 0; i < COMMANDPRIORITY_ALL; ++i )
+            waiting[ i ] = 0;
+    }
+
+    /**
+     * @return true if a sender of a higher priority waits for the lock.
+     * Called with the sendLock held.
+     */
+    bool hasWaiting( const CommandPriority priority ) const
+    {
+        for( int i = 0; i < priority; ++i )
+            if( waiting[ i ] > 0 )
+                return true;
+        return false;
     }
 
     ~Connection()
@@ -119,6 +159,30 @@ public:
 };
 }
 
+namespace
+{
+/** Holds the send lock of a connection with control priority, if given. */
+class ScopedSend
+{
+public:
+    explicit ScopedSend( const co::Connection* connection )
+        : _connection( connection )
+    {
+        if( _connection )
+            _connection->lockSend( COMMANDPRIORITY_CONTROL );
+    }
+
+    ~ScopedSend()
+    {
+        if( _connection )
+            _connection->unlockSend();
+    }
+
+private:
+    const co::Connection* const _connection;
+};
+}
+
 Connection::Connection()
         : _impl( new detail::Connection )
 {
@@ -181,6 +245,14 @@ ConnectionPtr Connection::create( ConnectionDescriptionPtr description )
             connection = new UDTConnection;
             break;
 #endif
+#ifdef __linux__
+        case CONNECTIONTYPE_SHM:
+            connection = new SHMConnection;
+            break;
+        case CONNECTIONTYPE_STRIPED:
+            connection = new StripedConnection;
+            break;
+#endif
 
         default:
             LBWARN << "Connection type " << description->type
@@ -217,14 +289,82 @@ void Connection::_setState( const State state )
     _impl->fireStateChanged( this );
 }
 
-void Connection::lockSend() const
+void Connection::lockSend( const CommandPriority priority ) const
 {
-    _impl->sendLock.set();
+    LBASSERT( priority < COMMANDPRIORITY_ALL );
+    // The lock is released between two commands, and large object data is
+    // sent as many commands. Let higher priorities take it first.
+    bool isWaiting = false;
+    for( ;; )
+    {
+        uint32_t unlocked;
+        {
+            lunchbox::ScopedMutex<> mutex( _impl->sendLock );
+            if( !_impl->sendLocked && !_impl->hasWaiting( priority ))
+            {
+                _impl->sendLocked = true;
+                if( isWaiting )
+                    --_impl->waiting[ priority ];
+                return;
+            }
+            if( !isWaiting )
+            {
+                ++_impl->waiting[ priority ];
+                isWaiting = true;
+            }
+            unlocked = _impl->sendUnlocked[ priority ].get();
+        }
+        _impl->sendUnlocked[ priority ].waitNE( unlocked );
+    }
 }
 
 void Connection::unlockSend() const
 {
-    _impl->sendLock.unset();
+    lunchbox::ScopedMutex<> mutex( _impl->sendLock );
+    LBASSERT( _impl->sendLocked );
+    _impl->sendLocked = false;
+
+    // wake the senders of the highest waiting priority only
+    for( size_t i = 0; i < COMMANDPRIORITY_ALL; ++i )
+    {
+        if( _impl->waiting[ i ] > 0 )
+        {
+            ++_impl->sendUnlocked[ i ];
+            return;
+        }
+    }
+}
+
+void Connection::setUnpaddedCommands( const bool enable )
+{
+    LBASSERT( !enable || !isMulticast( ));
+    _impl->unpaddedCommands = enable;
+}
+
+bool Connection::hasUnpaddedCommands() const
+{
+    return _impl->unpaddedCommands;
+}
+
+void Connection::setFragmentedItems( const bool enable )
+{
+    LBASSERT( !enable || !isMulticast( ));
+    _impl->fragmentedItems = enable;
+}
+
+bool Connection::hasFragmentedItems() const
+{
+    return _impl->fragmentedItems;
+}
+
+void Connection::setBatchedMapping( const bool enable )
+{
+    _impl->batchedMapping = enable;
+}
+
+bool Connection::hasBatchedMapping() const
+{
+    return _impl->batchedMapping;
 }
 
 void Connection::addListener( ConnectionListener* listener )
@@ -254,10 +394,17 @@ void Connection::recvNB( BufferPtr buffer, const uint64_t bytes )
 
     _impl->buffer = buffer;
     _impl->bytes = bytes;
+    _impl->partial = false;
     buffer->reserve( buffer->getSize() + bytes );
     readNB( buffer->getData() + buffer->getSize(), bytes );
 }
 
+void Connection::recvAvailableNB( BufferPtr buffer, const uint64_t bytes )
+{
+    recvNB( buffer, bytes );
+    _impl->partial = true;
+}
+
 bool Connection::recvSync( BufferPtr& outBuffer, const bool block )
 {
     LBASSERT( _impl->buffer );
@@ -265,8 +412,10 @@ bool Connection::recvSync( BufferPtr& outBuffer, const bool block )
     // reset async IO data
     outBuffer = _impl->buffer;
     const uint64_t bytes = _impl->bytes;
+    const bool partial = _impl->partial;
     _impl->buffer = 0;
     _impl->bytes = 0;
+    _impl->partial = false;
 
     if( _impl->state != STATE_CONNECTED || !outBuffer || bytes == 0 )
         return false;
@@ -287,6 +436,7 @@ bool Connection::recvSync( BufferPtr& outBuffer, const bool block )
     {
         _impl->buffer = outBuffer;
         _impl->bytes = bytes;
+        _impl->partial = partial;
         outBuffer = 0;
         return true;
     }
@@ -313,6 +463,11 @@ bool Connection::recvSync( BufferPtr& outBuffer, const bool block )
                 return false;
             LBVERB << "Zero bytes read" << std::endl;
         }
+        else if( partial ) // take what is available
+        {
+            outBuffer->resize( outBuffer->getSize() + got );
+            return true;
+        }
         if( bytesLeft > static_cast< uint64_t >( got )) // partial read
         {
             ptr += got;
@@ -360,6 +515,7 @@ BufferPtr Connection::resetRecvData()
     BufferPtr buffer = _impl->buffer;
     _impl->buffer = 0;
     _impl->bytes = 0;
+    _impl->partial = false;
     return buffer;
 }
 
@@ -381,7 +537,9 @@ bool Connection::send( const void* buffer, const uint64_t bytes,
     // 1) Disassemble buffer into 'small enough' pieces and use a header to
     //    reassemble correctly on the other side (aka reliable UDP)
     // 2) Introduce a send thread with a thread-safe task queue
-    lunchbox::ScopedMutex<> mutex( isLocked ? 0 : &_impl->sendLock );
+    // Unlocked sends are single commands, sent with control priority to hold
+    // back object data sent using lockSend().
+    ScopedSend mutex( isLocked ? 0 : this );
 
 #ifndef NDEBUG
     if( bytes <= 1024 && ( lunchbox::Log::topics & LOG_PACKETS ))
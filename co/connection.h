@@ -22,6 +22,7 @@
 #define CO_CONNECTION_H
 
 #include <co/api.h>
+#include <co/commands.h>  // CommandPriority
 #include <co/types.h>
 
 #include <lunchbox/referenced.h>   // base class
@@ -186,6 +187,14 @@ namespace detail { class Connection; }
          */
         CO_API void recvNB( BufferPtr buffer, const uint64_t bytes );
 
+        /**
+         * @internal Start a read of up to the given number of bytes.
+         *
+         * Like recvNB(), but recvSync() completes with the data received by a
+         * single read, which may be less than requested.
+         */
+        CO_API void recvAvailableNB( BufferPtr buffer, const uint64_t bytes );
+
         /**
          * Finish reading data from the connection.
          *
@@ -226,12 +235,55 @@ namespace detail { class Connection; }
         CO_API bool send( const void* buffer, const uint64_t bytes,
                           const bool isLocked = false );
 
-        /** Lock the connection, no other thread can send data. @version 1.0 */
-        CO_API void lockSend() const;
+        /**
+         * Lock the connection, no other thread can send data.
+         *
+         * Senders of a lower priority wait until no sender of a higher
+         * priority is waiting for the lock. Object data is sent in fragments,
+         * which allows small commands to overtake large object data.
+         *
+         * @param priority the priority of the commands sent.
+         * @version 1.0
+         */
+        CO_API void lockSend( const CommandPriority priority =
+                                  COMMANDPRIORITY_CONTROL ) const;
 
         /** Unlock the connection. @version 1.0 */
         CO_API void unlockSend() const;
 
+        /**
+         * @internal Send commands without padding them to COMMAND_MINSIZE.
+         *
+         * Only enabled after the peer announced that it reads the command size
+         * first.
+         */
+        CO_API void setUnpaddedCommands( const bool enable );
+
+        /** @internal @return true if commands are sent without padding. */
+        CO_API bool hasUnpaddedCommands() const;
+
+        /**
+         * @internal Split large data items over several object data commands.
+         *
+         * Only enabled after the peer announced that it reads items spanning
+         * multiple commands.
+         */
+        CO_API void setFragmentedItems( const bool enable );
+
+        /** @internal @return true if large data items may be split. */
+        CO_API bool hasFragmentedItems() const;
+
+        /**
+         * @internal Look up and map many objects with one command per node.
+         *
+         * Only enabled after the peer announced that it handles the batched
+         * mapping commands.
+         */
+        CO_API void setBatchedMapping( const bool enable );
+
+        /** @internal @return true if objects may be mapped in batches. */
+        CO_API bool hasBatchedMapping() const;
+
         /** @internal Finish all pending send operations. */
         virtual void finish() {}
         //@}
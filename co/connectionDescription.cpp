@@ -48,6 +48,10 @@ static ConnectionType _getConnectionType( const std::string& string )
         return CONNECTIONTYPE_RDMA;
     if( string == "UDT" )
         return CONNECTIONTYPE_UDT;
+    if( string == "SHM" )
+        return CONNECTIONTYPE_SHM;
+    if( string == "STRIPED" )
+        return CONNECTIONTYPE_STRIPED;
 
     LBWARN << "Unknown connection type: " << string;
     return CONNECTIONTYPE_NONE;
@@ -82,7 +86,7 @@ bool ConnectionDescription::fromString( std::string& data )
 {
     {
         size_t nextPos = data.find( SEPARATOR );
-        // assume hostname[:port][:type] or filename:PIPE format
+        // assume hostname[:port][:type] or filename:PIPE|SHM format
         if( nextPos == std::string::npos )
         {
             type     = CONNECTIONTYPE_TCPIP;
@@ -108,7 +112,8 @@ bool ConnectionDescription::fromString( std::string& data )
                 else
                 {
                     type = _getConnectionType( token );
-                    if( type == CONNECTIONTYPE_NAMEDPIPE )
+                    if( type == CONNECTIONTYPE_NAMEDPIPE ||
+                        type == CONNECTIONTYPE_SHM )
                     {
                         filename = hostname;
                         hostname.clear();
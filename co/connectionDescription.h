@@ -82,10 +82,10 @@ namespace co
          * formats are recognized, a human-readable and a machine-readable. The
          * human-readable version has the format
          * <code>hostname[:port][:type]</code> or
-         * <code>filename:PIPE</code>. The <code>type</code> parameter can be
-         * TCPIP, SDP, IB, MCIP, UDT or RSP. The machine-readable format
-         * contains all connection description parameters, is not documented and
-         * subject to change.
+         * <code>filename:PIPE|SHM</code>. The <code>type</code> parameter can
+         * be TCPIP, SDP, IB, MCIP, UDT, RSP or STRIPED. The machine-readable
+         * format contains all connection description parameters, is not
+         * documented and subject to change.
          *
          * @param data the string containing the connection description.
          * @return true if the information was read correctly, false if not.
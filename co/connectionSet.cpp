@@ -23,6 +23,10 @@
 #include "connection.h"
 #include "connectionListener.h"
 #include "eventConnection.h"
+#include "global.h"
+#ifndef _WIN32
+#  include "socketConnection.h"
+#endif
 
 #include <lunchbox/buffer.h>
 #include <lunchbox/os.h>
@@ -40,6 +44,10 @@
 #  define MAX_CONNECTIONS (MAXIMUM_WAIT_OBJECTS - 1)
 #else
 #  include <poll.h>
+#  include <sys/socket.h>
+#  ifdef CO_USE_LIBURING
+#    include "ioRing.h"
+#  endif
 #  define SELECT_TIMEOUT  0
 #  define SELECT_ERROR   -1
 #  define MAX_CONNECTIONS LB_100KB  // Arbitrary
@@ -102,6 +110,24 @@ union Result
 {
     Connection* connection;
 };
+
+/**
+ * Reap the zero copy completions of a socket connection signalled by POLLERR.
+ *
+ * @return true if POLLERR only signalled completed zero copy sends.
+ */
+bool _isZeroCopyCompletion( Connection* connection )
+{
+#ifdef __linux__
+    if( Global::getIAttribute( Global::IATTR_TCPIP_ZEROCOPY_SIZE ) <= 0 )
+        return false;
+
+    SocketConnection* socket = dynamic_cast< SocketConnection* >( connection );
+    return socket && socket->reapZeroCopy();
+#else
+    return false;
+#endif
+}
 #endif // _WIN32
 
 }
@@ -390,6 +416,9 @@ ConnectionSet::Event ConnectionSet::select( const uint32_t timeout )
                                                     _impl->fdSet.getData(),
                                                     FALSE, timeout, TRUE );
 #else
+#  ifdef CO_USE_LIBURING
+        IORing::flush(); // submit the reads re-armed since the last poll
+#  endif
         const int pollTimeout = timeout == LB_TIMEOUT_INDEFINITE ?
                                 -1 : int( timeout );
         const int ret = poll( _impl->fdSet.getData(), _impl->fdSet.getSize(),
@@ -481,9 +510,17 @@ ConnectionSet::Event ConnectionSet::_getSelectResult( const uint32_t )
         if( pollFD.revents == 0 )
             continue;
 
-        const int pollEvents = pollFD.revents;
+        int pollEvents = pollFD.revents;
         LBASSERT( pollFD.fd > 0 );
 
+        if(( pollEvents & POLLERR ) &&
+            _isZeroCopyCompletion( _impl->fdSetResult[i].connection ))
+        {
+            pollEvents &= ~POLLERR;
+            if( pollEvents == 0 )
+                continue;
+        }
+
         _impl->connection = _impl->fdSetResult[i].connection;
         LBASSERT( _impl->connection.isValid( ));
 
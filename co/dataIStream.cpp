@@ -42,9 +42,12 @@ public:
             : input( 0 )
             , inputSize( 0 )
             , position( 0 )
+            , decompressor( 0 )
             , swap( swap_ )
         {}
 
+    ~DataIStream() { delete decompressor; }
+
     /** The current input buffer */
     const uint8_t* input;
 
@@ -54,8 +57,13 @@ public:
     /** The current read position in the buffer */
     uint64_t position;
 
-    lunchbox::Decompressor decompressor; //!< current decompressor
+    /** Current decompressor, created for the first compressed input */
+    lunchbox::Decompressor* decompressor;
     lunchbox::Bufferb data; //!< decompressed buffer
+
+    /** The last item spanning input buffers, see getRemainingBuffer() */
+    lunchbox::Bufferb item;
+
     bool swap; //!< Invoke endian conversion
 };
 }
@@ -97,32 +105,33 @@ void DataIStream::_reset()
     _impl->inputSize = 0;
     _impl->position  = 0;
     _impl->swap      = false;
+    _impl->item.clear();
 }
 
-void DataIStream::_read( void* data, uint64_t size )
+bool DataIStream::_read( void* data, uint64_t size )
 {
-    if( !_checkBuffer( ))
+    // large items may be split over multiple blocks by the sender
+    uint8_t* ptr = static_cast< uint8_t* >( data );
+    do
     {
-        LBUNREACHABLE;
-        LBERROR << "No more input data" << std::endl;
-        return;
-    }
-
-    LBASSERT( _impl->input );
-
-    if( _impl->position + size > _impl->inputSize )
-    {
-        LBERROR << "Not enough data in input buffer: need " << size
-                << " bytes, " << _impl->inputSize - _impl->position << " left "
-                << std::endl;
-        LBUNREACHABLE;
-        // TODO: Allow reads which are asymmetric to writes by reading from
-        // multiple blocks here?
-        return;
+        if( !_checkBuffer( ))
+        {
+            LBUNREACHABLE;
+            LBERROR << "No more input data, " << size << " bytes missing"
+                    << std::endl;
+            return false;
+        }
+
+        LBASSERT( _impl->input );
+        const uint64_t bytes = LB_MIN( size,
+                                       _impl->inputSize - _impl->position );
+        memcpy( ptr, _impl->input + _impl->position, bytes );
+        _impl->position += bytes;
+        ptr += bytes;
+        size -= bytes;
     }
-
-    memcpy( data, _impl->input + _impl->position, size );
-    _impl->position += size;
+    while( size > 0 );
+    return true;
 }
 
 const void* DataIStream::getRemainingBuffer( const uint64_t size )
@@ -130,9 +139,16 @@ const void* DataIStream::getRemainingBuffer( const uint64_t size )
     if( !_checkBuffer( ))
         return 0;
 
-    LBASSERT( _impl->position + size <= _impl->inputSize );
     if( _impl->position + size > _impl->inputSize )
+    {
+        // item split over multiple blocks, reassemble it, replacing the
+        // previously reassembled item
+        lunchbox::Bufferb& item = _impl->item;
+        item.resize( size );
+        if( _read( item.getData(), size ))
+            return item.getData();
         return 0;
+    }
 
     _impl->position += size;
     return _impl->input + _impl->position - size;
@@ -178,8 +194,10 @@ const uint8_t* DataIStream::_decompress( const void* data, const uint32_t name,
 #endif
     _impl->data.reset( dataSize );
 
-    _impl->decompressor.setup( Global::getPluginRegistry(), name );
-    LBASSERT( _impl->decompressor.uses( name ));
+    if( !_impl->decompressor )
+        _impl->decompressor = new lunchbox::Decompressor;
+    _impl->decompressor->setup( Global::getPluginRegistry(), name );
+    LBASSERT( _impl->decompressor->uses( name ));
 
     uint64_t outDim[2] = { 0, dataSize };
     uint64_t* chunkSizes = static_cast< uint64_t* >(
@@ -198,8 +216,8 @@ const uint8_t* DataIStream::_decompress( const void* data, const uint32_t name,
         src += size;
     }
 
-    _impl->decompressor.decompress( chunks, chunkSizes, nChunks,
-                                    _impl->data.getData(), outDim );
+    _impl->decompressor->decompress( chunks, chunkSizes, nChunks,
+                                     _impl->data.getData(), outDim );
     return _impl->data.getData();
 }
 
@@ -116,14 +116,17 @@ public:
      * checking is performed by the DataIStream on the returned raw pointer.
      *
      * The buffer is advanced by the given size. If not enough data is present,
-     * 0 is returned and the buffer is unchanged.
+     * 0 is returned.
      *
      * The data written to the DataOStream by the sender is bucketized, it is
      * sent in multiple blocks. The remaining buffer and its size points into
      * one of the buffers, i.e., not all the data sent is returned by this
-     * function. However, a write operation on the other end is never segmented,
-     * that is, if the application writes n bytes to the DataOStream, a
-     * symmetric read from the DataIStream has at least n bytes available.
+     * function. Large writes may be split over several blocks by the sender.
+     * A read of more than the remaining size reassembles the data into a
+     * buffer owned by this stream, that is, if the application writes n bytes
+     * to the DataOStream, a symmetric read from the DataIStream returns n
+     * contiguous bytes. Reassembled data is valid until the next reassembling
+     * read.
      *
      * @param size the number of bytes to advance the buffer
      * @version 1.0
@@ -157,8 +160,11 @@ protected:
 private:
     detail::DataIStream* const _impl;
 
-    /** Read a number of bytes from the stream into a buffer. */
-    CO_API void _read( void* data, uint64_t size );
+    /**
+     * Read a number of bytes from the stream into a buffer.
+     * @return false if not enough data is left.
+     */
+    CO_API bool _read( void* data, uint64_t size );
 
     /**
      * Check that the current buffer has data left, get the next buffer is
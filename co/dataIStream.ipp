@@ -29,8 +29,8 @@ namespace co
     {
         uint64_t nElems = 0;
         *this >> nElems;
-        LBASSERTINFO( nElems <= getRemainingBufferSize(),
-                      nElems << " > " << getRemainingBufferSize( ));
+        LBASSERTINFO( nElems < LB_BIT48,
+                    "Out-of-sync co::DataIStream: " << nElems << " elements?" );
         if( nElems == 0 )
             str.clear();
         else
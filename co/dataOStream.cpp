@@ -78,6 +78,9 @@ public:
     /** Locked connections to the receivers, if _enabled */
     Connections connections;
 
+    /** The uncompressed data of the command being sent */
+    const uint8_t* sendBuffer;
+
     /** The compressor instance. */
     lunchbox::Compressor compressor;
 
@@ -90,24 +93,48 @@ public:
     /** Save all sent data */
     bool save;
 
+    /** Large items may be split over several commands */
+    bool fragments;
+
     DataOStream()
             : state( STATE_UNCOMPRESSED )
             , bufferStart( 0 )
             , dataSize( 0 )
+            , sendBuffer( 0 )
             , enabled( false )
             , dataSent( false )
             , save( false )
+            , fragments( false )
         {}
 
     DataOStream( const DataOStream& rhs )
         : state( rhs.state )
         , bufferStart( rhs.bufferStart )
         , dataSize( rhs.dataSize )
+        , sendBuffer( 0 )
         , enabled( rhs.enabled )
         , dataSent( rhs.dataSent )
         , save( rhs.save )
+        , fragments( rhs.fragments )
     {}
 
+    /** @return the maximum command size, or 0 if items can't be split. */
+    uint64_t getFragmentSize() const
+    {
+        const int32_t size =
+            Global::getIAttribute( Global::IATTR_OBJECT_FRAGMENT_SIZE );
+        if( !fragments || size <= 0 )
+            return 0;
+
+        for( ConnectionsCIter i = connections.begin();
+             i != connections.end(); ++i )
+        {
+            if( !(*i)->hasFragmentedItems( ))
+                return 0;
+        }
+        return size;
+    }
+
     uint32_t getCompressor() const
     {
         if( state == STATE_UNCOMPRESSED || state == STATE_UNCOMPRESSIBLE )
@@ -219,6 +246,11 @@ void DataOStream::_initCompressor( const uint32_t name )
     LB_TS_RESET( _impl->compressor._thread );
 }
 
+void DataOStream::_enableFragments()
+{
+    _impl->fragments = true;
+}
+
 void DataOStream::_enable()
 {
     LBASSERT( !_impl->enabled );
@@ -264,7 +296,25 @@ void DataOStream::_resend()
     LBASSERT( _impl->save );
 
     _impl->compress( _impl->buffer.getData(), _impl->dataSize, STATE_COMPLETE );
-    sendData( _impl->buffer.getData(), _impl->dataSize, true );
+
+    // Large uncompressed data, e.g., for mapping a big object, is resent in
+    // fragments to let other commands pass. Compressed data is sent at once.
+    const uint64_t fragmentSize = _impl->getFragmentSize();
+    if( fragmentSize == 0 || _impl->getCompressor() != EQ_COMPRESSOR_NONE )
+    {
+        _sendData( _impl->buffer.getData(), _impl->dataSize, true );
+        return;
+    }
+
+    const uint8_t* ptr = _impl->buffer.getData();
+    uint64_t size = _impl->dataSize;
+    while( size > fragmentSize )
+    {
+        _sendData( ptr, fragmentSize, false );
+        ptr += fragmentSize;
+        size -= fragmentSize;
+    }
+    _sendData( ptr, size, true );
 }
 
 void DataOStream::_clearConnections()
@@ -301,7 +351,7 @@ void DataOStream::disable()
             _impl->compress( ptr, size, state );
         }
 
-        sendData( ptr, size, true ); // always send to finalize istream
+        _sendData( ptr, size, true ); // always send to finalize istream
     }
 
 #ifndef CO_AGGRESSIVE_CACHING
@@ -342,6 +392,26 @@ void DataOStream::_write( const void* data, uint64_t size )
         LBWARN << *this << std::endl;
 #endif
 
+    const uint64_t fragmentSize = _impl->getFragmentSize();
+    if( fragmentSize > 0 && size > fragmentSize )
+    {
+        // Split large items, the receiver reassembles them
+        const uint8_t* ptr = static_cast< const uint8_t* >( data );
+        while( size > 0 )
+        {
+            if( _impl->buffer.getSize() - _impl->bufferStart >= fragmentSize )
+                flush( false );
+
+            const uint64_t pending = _impl->buffer.getSize() -
+                                     _impl->bufferStart;
+            const uint64_t bytes = LB_MIN( size, fragmentSize - pending );
+            _impl->buffer.append( ptr, bytes );
+            ptr += bytes;
+            size -= bytes;
+        }
+        return;
+    }
+
     if( _impl->buffer.getSize() - _impl->bufferStart >
         Global::getObjectBufferSize( ))
     {
@@ -360,7 +430,7 @@ void DataOStream::flush( const bool last )
 
         _impl->state = STATE_UNCOMPRESSED;
         _impl->compress( ptr, size, STATE_PARTIAL );
-        sendData( ptr, size, last );
+        _sendData( ptr, size, last );
     }
     _impl->dataSent = true;
     _resetBuffer();
@@ -378,6 +448,14 @@ const Connections& DataOStream::getConnections() const
     return _impl->connections;
 }
 
+void DataOStream::_sendData( const void* data, const uint64_t size,
+                              const bool last )
+{
+    _impl->sendBuffer = static_cast< const uint8_t* >( data );
+    sendData( data, size, last );
+    _impl->sendBuffer = 0;
+}
+
 void DataOStream::_resetBuffer()
 {
     _impl->state = STATE_UNCOMPRESSED;
@@ -426,9 +504,9 @@ void DataOStream::sendData( ConnectionPtr connection, const uint64_t dataSize )
     const uint32_t compressor = _impl->getCompressor();
     if( compressor == EQ_COMPRESSOR_NONE )
     {
+        LBASSERT( _impl->sendBuffer );
         if( dataSize > 0 )
-            LBCHECK( connection->send( _impl->buffer.getData(), dataSize,
-                                       true ));
+            LBCHECK( connection->send( _impl->sendBuffer, dataSize, true ));
         return;
     }
 
@@ -128,6 +128,14 @@ namespace DataStreamTest { class Sender; }
         /** @internal Initialize the given compressor. */
         void _initCompressor( const uint32_t compressor );
 
+        /**
+         * @internal Allow splitting large items over several commands.
+         *
+         * Only used by subclasses sending non-last commands, and only done for
+         * receivers which announced reading items spanning commands.
+         */
+        void _enableFragments();
+
         /** @internal Enable output. */
         CO_API void _enable();
 
@@ -175,7 +183,7 @@ namespace DataStreamTest { class Sender; }
         CO_API void _write( const void* data, uint64_t size );
 
         /** Helper function preparing data for sendData() as needed. */
-        void _sendData( const void* data, const uint64_t size );
+        void _sendData( const void* data, uint64_t size, bool last );
 
         /** Reset after sending a buffer. */
         void _resetBuffer();
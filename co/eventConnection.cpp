@@ -18,7 +18,15 @@
  */
 
 #include "eventConnection.h"
-#include "pipeConnection.h"
+#ifdef __linux__
+#  include "log.h"
+#  include <lunchbox/os.h>
+#  include <errno.h>
+#  include <sys/eventfd.h>
+#  include <unistd.h>
+#else
+#  include "pipeConnection.h"
+#endif
 
 #include <lunchbox/scopedMutex.h>
 
@@ -28,6 +36,8 @@ namespace co
 EventConnection::EventConnection()
 #ifdef _WIN32
         : _event( 0 )
+#elif defined __linux__
+        : _eventFD( -1 )
 #else
         : _set( false )
 #endif
@@ -48,6 +58,15 @@ bool EventConnection::connect()
 
 #ifdef _WIN32
     _event = CreateEvent( 0, TRUE, FALSE, 0 );
+#elif defined __linux__
+    _eventFD = ::eventfd( 0, EFD_CLOEXEC | EFD_NONBLOCK );
+    if( _eventFD < 0 )
+    {
+        LBERROR << "Could not create eventfd: " << lunchbox::sysError
+                << std::endl;
+        _setState( STATE_CLOSED );
+        return false;
+    }
 #else
     _connection = new PipeConnection;
     LBCHECK( _connection->connect( ));
@@ -64,6 +83,10 @@ void EventConnection::_close()
     if( _event )
         CloseHandle( _event );
     _event = 0;
+#elif defined __linux__
+    if( _eventFD >= 0 )
+        ::close( _eventFD );
+    _eventFD = -1;
 #else
     if( _connection.isValid( ))
         _connection->close();
@@ -78,6 +101,10 @@ void EventConnection::set()
 {
 #ifdef _WIN32
     SetEvent( _event );
+#elif defined __linux__
+    const uint64_t one = 1;
+    if( ::write( _eventFD, &one, sizeof( one )) != sizeof( one ))
+        LBWARN << "Can't set eventfd: " << lunchbox::sysError << std::endl;
 #else
     lunchbox::ScopedMutex<> mutex( _lock );
     if( _set )
@@ -92,6 +119,10 @@ void EventConnection::reset()
 {
 #ifdef _WIN32
     ResetEvent( _event );
+#elif defined __linux__
+    uint64_t value;
+    if( ::read( _eventFD, &value, sizeof( value )) < 0 && errno != EAGAIN )
+        LBWARN << "Can't reset eventfd: " << lunchbox::sysError << std::endl;
 #else
     lunchbox::ScopedMutex<> mutex( _lock );
     if( !_set )
@@ -110,6 +141,8 @@ Connection::Notifier EventConnection::getNotifier() const
 {
 #ifdef _WIN32
     return _event;
+#elif defined __linux__
+    return _eventFD;
 #else
     return _connection->getNotifier();
 #endif
@@ -22,8 +22,10 @@
 
 #include <co/connection.h>   // base class
 
-#include "buffer.h"
-#include "pipeConnection.h"
+#ifndef __linux__
+#  include "buffer.h"
+#  include "pipeConnection.h"
+#endif
 
 namespace co
 {
@@ -58,13 +60,15 @@ namespace co
     private:
 #ifdef WIN32
         void* _event;
+        Buffer _buffer;
+#elif defined __linux__
+        int _eventFD;
 #else
         PipeConnectionPtr _connection;
         lunchbox::Lock _lock;
         bool _set;
-#endif
-
         Buffer _buffer;
+#endif
 
         void _close();
     };
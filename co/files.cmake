@@ -82,6 +82,7 @@ set(CO_HEADERS
   pipeConnection.h
   queueCommand.h
   rspConnection.h
+  smallOCommand.h
   socketConnection.h
   staticMasterCM.h
   staticSlaveCM.h
@@ -51,6 +51,12 @@ static uint32_t _getObjectBufferSize()
     return 60000;
 }
 
+static std::string _getInstanceCacheDirectory()
+{
+    const char* env = getenv( "CO_INSTANCE_CACHE_DIR" );
+    return env ? env : std::string();
+}
+
 static int32_t _getTimeout()
 {
     const char* env = getenv( "CO_TIMEOUT" );
@@ -66,6 +72,7 @@ static int32_t _getTimeout()
 
 uint16_t    _defaultPort = 0;
 uint32_t    _objectBufferSize = _getObjectBufferSize();
+std::string _instanceCacheDirectory = _getInstanceCacheDirectory();
 int32_t     _iAttributes[Global::IATTR_ALL] =
 {
     100,   // INSTANCE_CACHE_SIZE
@@ -93,7 +100,26 @@ int32_t     _iAttributes[Global::IATTR_ALL] =
     5000,   // RDMA_RESOLVE_TIMEOUT_MS
     1,      // IATTR_ROBUSTNESS
     _getTimeout(), // IATTR_TIMEOUT_DEFAULT
-    1023    // IATTR_OBJECT_COMPRESSION
+    1023,   // IATTR_OBJECT_COMPRESSION
+    65536,  // IATTR_QUEUE_BATCH_SIZE
+    0,      // IATTR_RSP_MULTICAST_LOOPBACK
+    8,      // IATTR_RSP_BURST_SIZE
+    0,      // IATTR_RSP_FEC_GROUP_SIZE
+    1000,   // IATTR_RSP_ROUND_TRIP_TIME
+    1024,   // IATTR_SHM_RING_SIZE_KB
+#ifdef __linux__
+    1,      // IATTR_SHM_SAME_HOST
+#else
+    0,      // IATTR_SHM_SAME_HOST
+#endif
+    0,      // IATTR_TCPIP_IO_URING
+    0,      // IATTR_TCPIP_BUFFER_RTT_US
+    0,      // IATTR_TCPIP_BUSY_POLL_US
+    0,      // IATTR_TCPIP_QUICKACK
+    0,      // IATTR_TCPIP_ZEROCOPY_SIZE
+    4,      // IATTR_STRIPED_STREAMS
+    256,    // IATTR_STRIPED_MIN_SIZE_KB
+    262144  // IATTR_OBJECT_FRAGMENT_SIZE
 };
 }
 
@@ -168,6 +194,16 @@ uint32_t Global::getObjectBufferSize()
     return  _objectBufferSize;
 }
 
+void Global::setInstanceCacheDirectory( const std::string& directory )
+{
+    _instanceCacheDirectory = directory;
+}
+
+const std::string& Global::getInstanceCacheDirectory()
+{
+    return _instanceCacheDirectory;
+}
+
 lunchbox::PluginRegistry& Global::getPluginRegistry()
 {
     static lunchbox::PluginRegistry pluginRegistry;
@@ -54,6 +54,27 @@ namespace co
          */
         CO_API static uint32_t getObjectBufferSize();
 
+        /**
+         * Set the directory for the persistent instance cache tier.
+         *
+         * Instance data received for mapped objects is written to this
+         * directory and used to satisfy object mappings after a restart of the
+         * process, if the master confirms that the cached version is still
+         * current. The default is the value of the environment variable
+         * CO_INSTANCE_CACHE_DIR. An empty string disables the disk tier.
+         *
+         * @param directory the cache directory, or an empty string.
+         * @version 1.0
+         */
+        CO_API static void setInstanceCacheDirectory(
+            const std::string& directory );
+
+        /**
+         * @return the directory of the persistent instance cache tier.
+         * @version 1.0
+         */
+        CO_API static const std::string& getInstanceCacheDirectory();
+
         /** @internal
          * Set the global variables.
          *
@@ -101,6 +122,21 @@ namespace co
             IATTR_ROBUSTNESS,            //!< @internal use robustness
             IATTR_TIMEOUT_DEFAULT,       //!< @internal default timeout
             IATTR_OBJECT_COMPRESSION,    //!< @internal threshold to compress
+            IATTR_QUEUE_BATCH_SIZE,      //!< @internal max bytes per item batch
+            IATTR_RSP_MULTICAST_LOOPBACK, //!< @internal receive from same host
+            IATTR_RSP_BURST_SIZE,        //!< @internal max datagrams per burst
+            IATTR_RSP_FEC_GROUP_SIZE,    //!< @internal max datagrams per parity
+            IATTR_RSP_ROUND_TRIP_TIME,   //!< @internal expected RTT in us
+            IATTR_SHM_RING_SIZE_KB,      //!< @internal buffer per direction
+            IATTR_SHM_SAME_HOST,         //!< @internal use SHM on same host
+            IATTR_TCPIP_IO_URING,        //!< @internal receive using io_uring
+            IATTR_TCPIP_BUFFER_RTT_US,   //!< @internal size buffers, 0: OS
+            IATTR_TCPIP_BUSY_POLL_US,    //!< @internal SO_BUSY_POLL time
+            IATTR_TCPIP_QUICKACK,        //!< @internal ack reads immediately
+            IATTR_TCPIP_ZEROCOPY_SIZE,   //!< @internal min MSG_ZEROCOPY send
+            IATTR_STRIPED_STREAMS,       //!< @internal data sockets per peer
+            IATTR_STRIPED_MIN_SIZE_KB,   //!< @internal min striped write
+            IATTR_OBJECT_FRAGMENT_SIZE,  //!< @internal max object data command
             IATTR_ALL
         };
 
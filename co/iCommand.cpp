@@ -25,17 +25,20 @@
 #include "node.h"
 #include <lunchbox/plugins/compressorTypes.h>
 
+#include <string.h>
+
 namespace co
 {
 namespace detail
 {
-class ICommand
+class ICommand : public lunchbox::Referenced
 {
 public:
     ICommand()
         : func( 0, 0 )
         , buffer( 0 )
         , size( 0 )
+        , offset( 0 )
         , type( COMMANDTYPE_INVALID )
         , cmd( CMD_INVALID )
         , consumed( false )
@@ -47,6 +50,7 @@ public:
         , func( 0, 0 )
         , buffer( buffer_ )
         , size( 0 )
+        , offset( 0 )
         , type( COMMANDTYPE_INVALID )
         , cmd( CMD_INVALID )
         , consumed( false )
@@ -62,6 +66,7 @@ public:
     co::Dispatcher::Func func;
     ConstBufferPtr buffer;
     uint64_t size;
+    uint64_t offset; //!< start of the command within the buffer
     uint32_t type;
     uint32_t cmd;
     bool consumed;
@@ -72,6 +77,7 @@ ICommand::ICommand()
     : DataIStream( false )
     , _impl( new detail::ICommand )
 {
+    _impl->ref( this );
 }
 
 ICommand::ICommand( LocalNodePtr local, NodePtr remote, ConstBufferPtr buffer,
@@ -79,25 +85,58 @@ ICommand::ICommand( LocalNodePtr local, NodePtr remote, ConstBufferPtr buffer,
     : DataIStream( swap_ )
     , _impl( new detail::ICommand( local, remote, buffer ))
 {
+    _impl->ref( this );
     if( _impl->buffer )
         *this >> _impl->size >> _impl->type >> _impl->cmd;
 }
 
+// Copies share the implementation, which holds the parsed header. Only the
+// read position of the DataIStream is per copy.
 ICommand::ICommand( const ICommand& rhs )
     : DataIStream( rhs )
-    , _impl( new detail::ICommand( *rhs._impl ))
+    , _impl( rhs._impl )
 {
+    _impl->ref( this );
+#ifndef NDEBUG
+    _detach(); // consumed is tracked per copy
     _impl->consumed = false;
+#endif
     _skipHeader();
 }
 
+ICommand::ICommand( const ICommand& container, const uint64_t offset )
+    : DataIStream( container.isSwapping( ))
+    , _impl( new detail::ICommand( container._impl->local,
+                                   container._impl->remote,
+                                   container._impl->buffer ))
+{
+    _impl->ref( this );
+    _impl->offset = offset;
+    _parseHeader();
+}
+
+ICommand::ICommand( LocalNodePtr local, NodePtr remote, ConstBufferPtr buffer,
+                    const bool swap_, const uint64_t offset )
+    : DataIStream( swap_ )
+    , _impl( new detail::ICommand( local, remote, buffer ))
+{
+    _impl->ref( this );
+    _impl->offset = offset;
+    _parseHeader();
+}
+
 ICommand& ICommand::operator = ( const ICommand& rhs )
 {
     if( this != &rhs )
     {
         DataIStream::operator = ( rhs );
-        *_impl = *rhs._impl;
+        rhs._impl->ref( this );
+        _impl->unref( this );
+        _impl = rhs._impl;
+#ifndef NDEBUG
+        _detach();
         _impl->consumed = false;
+#endif
         _skipHeader();
     }
     return *this;
@@ -105,14 +144,28 @@ ICommand& ICommand::operator = ( const ICommand& rhs )
 
 ICommand::~ICommand()
 {
-    delete _impl;
+    _impl->unref( this );
 }
 
 void ICommand::clear()
 {
+    _detach();
     _impl->clear();
 }
 
+void ICommand::_detach()
+{
+    // Commands are usually unshared when modified: the queue and cache copies
+    // have been released by then.
+    if( _impl->getRefCount() == 1 )
+        return;
+
+    detail::ICommand* impl = new detail::ICommand( *_impl );
+    impl->ref( this );
+    _impl->unref( this );
+    _impl = impl;
+}
+
 void ICommand::_skipHeader()
 {
     const size_t headerSize = sizeof( _impl->size ) + sizeof( _impl->type ) +
@@ -121,6 +174,30 @@ void ICommand::_skipHeader()
         getRemainingBuffer( headerSize );
 }
 
+// The stream only sees the command once its size is known, since the buffer
+// may hold further commands after this one.
+void ICommand::_parseHeader()
+{
+    LBASSERT( _impl->buffer );
+    LBASSERT( _impl->offset + sizeof( _impl->size ) + sizeof( _impl->type ) +
+              sizeof( _impl->cmd ) <= _impl->buffer->getSize( ));
+
+    const uint8_t* header = _impl->buffer->getData() + _impl->offset;
+    ::memcpy( &_impl->size, header, sizeof( _impl->size ));
+    header += sizeof( _impl->size );
+    ::memcpy( &_impl->type, header, sizeof( _impl->type ));
+    header += sizeof( _impl->type );
+    ::memcpy( &_impl->cmd, header, sizeof( _impl->cmd ));
+
+    if( isSwapping( ))
+    {
+        lunchbox::byteswap( _impl->size );
+        lunchbox::byteswap( _impl->type );
+        lunchbox::byteswap( _impl->cmd );
+    }
+    _skipHeader();
+}
+
 uint32_t ICommand::getType() const
 {
     return _impl->type;
@@ -138,16 +215,19 @@ uint64_t ICommand::getSize() const
 
 void ICommand::setType( const CommandType type )
 {
+    _detach();
     _impl->type = type;
 }
 
 void ICommand::setCommand( const uint32_t cmd )
 {
+    _detach();
     _impl->cmd = cmd;
 }
 
 void ICommand::setDispatchFunction( const Dispatcher::Func& func )
 {
+    _detach();
     _impl->func = func;
 }
 
@@ -157,6 +237,11 @@ ConstBufferPtr ICommand::getBuffer() const
     return _impl->buffer;
 }
 
+uint64_t ICommand::getOffset() const
+{
+    return _impl->offset;
+}
+
 size_t ICommand::nRemainingBuffers() const
 {
     return _impl->buffer ? 1 : 0;
@@ -179,12 +264,15 @@ bool ICommand::getNextBuffer( uint32_t& compressor, uint32_t& nChunks,
         return false;
 
 #ifndef NDEBUG
+    _detach();
     LBASSERT( !_impl->consumed );
     _impl->consumed = true;
 #endif
 
-    *chunkData = _impl->buffer->getData();
-    size = _impl->buffer->getSize();
+    *chunkData = _impl->buffer->getData() + _impl->offset;
+    size = _impl->buffer->getSize() - _impl->offset;
+    if( _impl->size > 0 ) // don't read into the next command
+        size = LB_MIN( size, _impl->size );
     compressor = EQ_COMPRESSOR_NONE;
     nChunks = 1;
     return true;
@@ -211,6 +299,7 @@ bool ICommand::operator()()
 {
     LBASSERT( _impl->func.isValid( ));
     Dispatcher::Func func = _impl->func;
+    _detach();
     _impl->func.clear();
     return func( *this );
 }
@@ -48,6 +48,22 @@ namespace detail { class ICommand; }
                         ConstBufferPtr buffer, const bool swap ); //!< @internal
         CO_API ICommand( const ICommand& rhs ); //!< @internal
 
+        /**
+         * @internal Construct a command embedded in another command.
+         *
+         * The embedded command shares the buffer of the container and starts
+         * at the given byte offset with its own command header.
+         */
+        CO_API ICommand( const ICommand& container, const uint64_t offset );
+
+        /**
+         * @internal Construct a command stored at the given byte offset of a
+         * buffer holding multiple received commands.
+         */
+        CO_API ICommand( LocalNodePtr local, NodePtr remote,
+                         ConstBufferPtr buffer, const bool swap,
+                         const uint64_t offset );
+
         CO_API virtual ~ICommand(); //!< @internal
 
         CO_API ICommand& operator = ( const ICommand& rhs ); //!< @internal
@@ -84,6 +100,9 @@ namespace detail { class ICommand; }
 
         /** @internal @return the buffer */
         CO_API ConstBufferPtr getBuffer() const;
+
+        /** @internal @return the start of this command within the buffer. */
+        CO_API uint64_t getOffset() const;
         //@}
 
         /** @internal @name Command dispatch */
@@ -102,7 +121,7 @@ namespace detail { class ICommand; }
         //@}
 
     private:
-        detail::ICommand* const _impl;
+        detail::ICommand* _impl; //!< shared between copies, copy-on-write
 
         friend CO_API std::ostream& operator << (std::ostream&,const ICommand&);
 
@@ -116,6 +135,12 @@ namespace detail { class ICommand; }
         //@}
 
         void _skipHeader(); //!< @internal
+
+        /** @internal Read the header at the offset, without the stream. */
+        void _parseHeader();
+
+        /** @internal Unshare the implementation before modifying it. */
+        void _detach();
     };
 
     CO_API std::ostream& operator << ( std::ostream& os, const ICommand& );
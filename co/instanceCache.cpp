@@ -20,13 +20,22 @@
 
 #include "instanceCache.h"
 
+#include "buffer.h"
+#include "bufferListener.h"
+#include "localNode.h"
+#include "log.h"
 #include "objectDataICommand.h"
 #include "objectDataIStream.h"
 #include "objectVersion.h"
 
 #include <lunchbox/debug.h>
+#include <lunchbox/memoryMap.h>
+#include <lunchbox/mtQueue.h>
 #include <lunchbox/scopedMutex.h>
 
+#include <cstdio>
+#include <fstream>
+
 namespace co
 {
 //#define EQ_INSTRUMENT_CACHE
@@ -45,15 +54,200 @@ lunchbox::a_int32_t nUnusedRelease;
 }
 #endif
 
+namespace
+{
+/** Magic number and version of the disk tier file format. */
+static const uint64_t _diskMagic = 0x436F496E73740001ull;
+
+/** magic, version, id, master node (uint128 each), instance, #commands */
+enum DiskHeader
+{
+    HEADER_MAGIC,
+    HEADER_VERSION_HIGH,
+    HEADER_VERSION_LOW,
+    HEADER_ID_HIGH,
+    HEADER_ID_LOW,
+    HEADER_NODE_HIGH,
+    HEADER_NODE_LOW,
+    HEADER_INSTANCE,
+    HEADER_COMMANDS,
+    HEADER_ALL
+};
+
+/** Deletes restored buffers, which are not owned by a BufferCache. */
+class BufferDeleter : public BufferListener
+{
+public:
+    virtual void notifyFree( Buffer* buffer ) { delete buffer; }
+};
+static BufferDeleter _bufferDeleter;
+
+/** @return true if the data received from the given node is byte-swapped. */
+bool _isSwapping( NodePtr node )
+{
+#ifdef COLLAGE_BIGENDIAN
+    return !node->isBigEndian();
+#else
+    return node->isBigEndian();
+#endif
+}
+
+/**
+ * @return the given command in a buffer of its own. Received commands share
+ *         the buffer of their connection read, which would be kept alive by
+ *         the cache without being accounted for.
+ */
+ICommand _compact( const ICommand& command )
+{
+    ConstBufferPtr buffer = command.getBuffer();
+    const uint64_t offset = command.getOffset();
+    const uint64_t size = LB_MIN( command.getSize(),
+                                  buffer->getSize() - offset );
+    if( offset == 0 && size == buffer->getSize( ))
+        return command;
+
+    BufferPtr copy = new Buffer( &_bufferDeleter );
+    copy->replace( buffer->getData() + offset, size );
+
+    NodePtr node = command.getNode();
+    ICommand compact( command.getLocalNode(), node, copy, _isSwapping( node ));
+    compact.setType( CommandType( command.getType( )));
+    compact.setCommand( command.getCommand( ));
+    return compact;
+}
+}
+
+/**
+ * Writes and removes the disk tier files, so that the command thread adding
+ * instance data does not wait for the disk.
+ */
+class InstanceCache::Writer : public lunchbox::Thread
+{
+public:
+    Writer() { start(); }
+    virtual ~Writer()
+    {
+        _jobs.push( Job( Job::EXIT ));
+        join();
+    }
+
+    /** Write the given, complete instance data to filename. */
+    void store( const std::string& filename, const ObjectVersion& rev,
+                const NodeID& from, const uint32_t instanceID,
+                const ObjectDataIStream& stream )
+    {
+        Job job( Job::STORE );
+        job.filename = filename;
+        job.rev = rev;
+        job.from = from;
+        job.instanceID = instanceID;
+        job.commands = stream.getDataCommands();
+        _jobs.push( job );
+    }
+
+    /** Remove the given file after all previously queued writes. */
+    void remove( const std::string& filename )
+    {
+        Job job( Job::REMOVE );
+        job.filename = filename;
+        _jobs.push( job );
+    }
+
+protected:
+    virtual void run()
+    {
+        for( ;; )
+        {
+            const Job job = _jobs.pop();
+            switch( job.type )
+            {
+              case Job::STORE:
+                  _store( job );
+                  break;
+              case Job::REMOVE:
+                  ::remove( job.filename.c_str( ));
+                  break;
+              case Job::EXIT:
+                  return;
+            }
+        }
+    }
+
+private:
+    struct Job
+    {
+        enum Type { STORE, REMOVE, EXIT };
+        explicit Job( const Type type_ = EXIT )
+            : type( type_ ), instanceID( EQ_INSTANCE_INVALID ) {}
+
+        Type type;
+        std::string filename;
+        ObjectVersion rev;
+        NodeID from;
+        uint32_t instanceID;
+        ObjectDataIStream::CommandDeque commands; //!< hold the data buffers
+    };
+
+    lunchbox::MTQueue< Job > _jobs;
+
+    void _store( const Job& job )
+    {
+        const std::string tmpName = job.filename + ".tmp";
+
+        uint64_t header[ HEADER_ALL ];
+        header[ HEADER_MAGIC ] = _diskMagic;
+        header[ HEADER_VERSION_HIGH ] = job.rev.version.high();
+        header[ HEADER_VERSION_LOW ] = job.rev.version.low();
+        header[ HEADER_ID_HIGH ] = job.rev.identifier.high();
+        header[ HEADER_ID_LOW ] = job.rev.identifier.low();
+        header[ HEADER_NODE_HIGH ] = job.from.high();
+        header[ HEADER_NODE_LOW ] = job.from.low();
+        header[ HEADER_INSTANCE ] = job.instanceID;
+        header[ HEADER_COMMANDS ] = job.commands.size();
+
+        std::ofstream file( tmpName.c_str(),
+                            std::ios::out | std::ios::binary | std::ios::trunc );
+        file.write( reinterpret_cast< const char* >( header ),
+                    sizeof( header ));
+
+        for( ObjectDataIStream::CommandDeque::const_iterator i =
+                 job.commands.begin(); i != job.commands.end(); ++i )
+        {
+            const ICommand& command = *i;
+            ConstBufferPtr buffer = command.getBuffer();
+            const uint64_t offset = command.getOffset();
+            const uint64_t size = LB_MIN( command.getSize(),
+                                          buffer->getSize() - offset );
+
+            file.write( reinterpret_cast< const char* >( &size ),
+                        sizeof( size ));
+            file.write( reinterpret_cast< const char* >( buffer->getData() +
+                                                         offset ), size );
+        }
+        file.close();
+
+        if( !file || ::rename( tmpName.c_str(), job.filename.c_str( )) != 0 )
+        {
+            LBWARN << "Can't write instance cache file " << job.filename
+                   << std::endl;
+            ::remove( tmpName.c_str( ));
+        }
+    }
+};
+
 const InstanceCache::Data InstanceCache::Data::NONE;
 
-InstanceCache::InstanceCache( const uint64_t maxSize )
+InstanceCache::InstanceCache( const uint64_t maxSize,
+                              const std::string& directory )
         : _maxSize( maxSize )
         , _size( 0 )
+        , _directory( directory )
+        , _writer( directory.empty() ? 0 : new Writer )
 {}
 
 InstanceCache::~InstanceCache()
 {
+    delete _writer;
     for( ItemHash::iterator i = _items->begin(); i != _items->end(); ++i )
     {
         Item& item = i->second;
@@ -87,6 +281,14 @@ InstanceCache::Item::Item()
 
 bool InstanceCache::add( const ObjectVersion& rev, const uint32_t instanceID,
                          ICommand& command, const uint32_t usage )
+{
+    ICommand compact = _compact( command );
+    return _add( rev, instanceID, compact, usage, !_directory.empty( ));
+}
+
+bool InstanceCache::_add( const ObjectVersion& rev, const uint32_t instanceID,
+                          ICommand& command, const uint32_t usage,
+                          const bool persist )
 {
     LBASSERTINFO( command.isValid(), command );
 
@@ -172,7 +374,12 @@ bool InstanceCache::add( const ObjectVersion& rev, const uint32_t instanceID,
     stream->addDataCommand( command );
 
     if( stream->isReady( ))
+    {
         _size += stream->getDataSize();
+        if( persist )
+            _writer->store( _getFilename( rev.identifier ), rev, item.from,
+                            item.data.masterInstanceID, *stream );
+    }
 
     _releaseItems( 1 );
     _releaseItems( 0 );
@@ -212,6 +419,81 @@ void InstanceCache::remove( const NodeID& nodeID )
     }
 }
 
+bool InstanceCache::restore( const UUID& id, LocalNodePtr localNode,
+                             NodePtr master )
+{
+    if( _directory.empty() || !master )
+        return false;
+    {
+        lunchbox::ScopedMutex<> mutex( _items );
+        if( _items->find( id ) != _items->end( ))
+            return false;
+    }
+
+    const std::string filename = _getFilename( id );
+    {
+        std::ifstream probe( filename.c_str( ));
+        if( !probe )
+            return false;
+    }
+
+    lunchbox::MemoryMap file;
+    const uint8_t* data = static_cast< const uint8_t* >(
+                              file.map( filename ));
+    const size_t headerSize = HEADER_ALL * sizeof( uint64_t );
+    if( !data || file.getSize() < headerSize )
+        return false;
+
+    const uint64_t* header = reinterpret_cast< const uint64_t* >( data );
+    const UUID objectID( header[ HEADER_ID_HIGH ], header[ HEADER_ID_LOW ] );
+    const NodeID nodeID( header[ HEADER_NODE_HIGH ], header[ HEADER_NODE_LOW ]);
+    if( header[ HEADER_MAGIC ] != _diskMagic || objectID != id ||
+        nodeID != master->getNodeID( ))
+    {
+        return false;
+    }
+
+    const ObjectVersion rev( id, uint128_t( header[ HEADER_VERSION_HIGH ],
+                                            header[ HEADER_VERSION_LOW ] ));
+    const uint32_t instanceID = uint32_t( header[ HEADER_INSTANCE ] );
+    const bool swapping = _isSwapping( master );
+
+    size_t offset = headerSize;
+    for( uint64_t i = 0; i < header[ HEADER_COMMANDS ]; ++i )
+    {
+        if( offset + sizeof( uint64_t ) > file.getSize( ))
+            return false;
+        const uint64_t size =
+            *reinterpret_cast< const uint64_t* >( data + offset );
+        offset += sizeof( uint64_t );
+        if( offset + size > file.getSize( ))
+        {
+            LBWARN << "Truncated instance cache file " << filename
+                   << std::endl;
+            return false;
+        }
+
+        BufferPtr buffer = new Buffer( &_bufferDeleter );
+        buffer->replace( data + offset, size );
+        offset += size;
+
+        ICommand command( localNode, master, buffer, swapping );
+        command.setType( COMMANDTYPE_OBJECT );
+        command.setCommand( CMD_OBJECT_INSTANCE );
+        if( !_add( rev, instanceID, command, 0, false ))
+            return false;
+    }
+
+    LBLOG( LOG_OBJECTS ) << "Restored " << rev << " from " << filename
+                         << std::endl;
+    return true;
+}
+
+std::string InstanceCache::_getFilename( const UUID& id ) const
+{
+    return _directory + "/" + id.getString() + ".coc";
+}
+
 const InstanceCache::Data& InstanceCache::operator[]( const UUID& id )
 {
 #ifdef EQ_INSTRUMENT_CACHE
@@ -253,6 +535,9 @@ bool InstanceCache::release( const UUID& id, const uint32_t count )
 bool InstanceCache::erase( const UUID& id )
 {
     lunchbox::ScopedMutex<> mutex( _items );
+    if( _writer )
+        _writer->remove( _getFilename( id ));
+
     ItemHash::iterator i = _items->find( id );
     if( i == _items->end( ))
         return false;
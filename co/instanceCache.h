@@ -32,15 +32,31 @@
 #include <lunchbox/uuid.h>      // member
 
 #include <iostream>
+#include <string>
 
 namespace co
 {
-    /** @internal A thread-safe cache for object instance data. */
+    /**
+     * @internal A thread-safe cache for object instance data.
+     *
+     * The cache optionally persists complete instance data streams in a disk
+     * directory, one file per object identifier. The files are written by a
+     * background thread, which is flushed when the cache is destroyed. The
+     * disk tier survives a restart of the process and is used by restore() to
+     * re-populate the in-memory cache before an object is mapped.
+     */
     class InstanceCache
     {
     public:
-        /** Construct a new instance cache. */
-        CO_API InstanceCache( const uint64_t maxSize = LB_100MB );
+        /**
+         * Construct a new instance cache.
+         *
+         * @param maxSize the maximum number of bytes held in memory.
+         * @param directory the directory of the disk tier, or an empty string
+         *                  to disable persistent caching.
+         */
+        CO_API InstanceCache( const uint64_t maxSize = LB_100MB,
+                              const std::string& directory = std::string( ));
 
         /** Destruct this instance cache. */
         CO_API ~InstanceCache();
@@ -60,6 +76,22 @@ namespace co
         /** Remove all items from the given node. */
         void remove( const NodeID& node );
 
+        /**
+         * Load the persisted instance data of an object from the disk tier.
+         *
+         * Nothing is loaded if the disk tier is disabled, if the object has
+         * data in memory or if the persisted data was not received from the
+         * given master node. The master instance identifier and version of the
+         * restored data is validated by the master during mapping.
+         *
+         * @param id the identifier of the object.
+         * @param localNode the local node receiving the data.
+         * @param master the master node of the object.
+         * @return true if data was restored, false otherwise.
+         */
+        CO_API bool restore( const UUID& id, LocalNodePtr localNode,
+                             NodePtr master );
+
         /** One cache entry */
         struct Data
         {
@@ -118,6 +150,8 @@ namespace co
         bool isEmpty() { return _items->empty(); }
 
     private:
+        class Writer;
+
         struct Item
         {
             Item();
@@ -139,6 +173,14 @@ namespace co
 
         const lunchbox::Clock _clock;  //!< Clock for item expiration
 
+        const std::string _directory; //!< disk tier, empty if disabled
+        Writer* const _writer; //!< writes the disk tier, 0 if disabled
+
+        bool _add( const ObjectVersion& rev, const uint32_t instanceID,
+                   ICommand& command, const uint32_t usage,
+                   const bool persist );
+        std::string _getFilename( const UUID& id ) const;
+
         void _releaseItems( const uint32_t minUsage );
         void _releaseStreams( InstanceCache::Item& item );
         void _releaseStreams( InstanceCache::Item& item,
@@ -0,0 +1,380 @@
+
+/* Copyright (c) 2026, The Collage Authors
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "ioRing.h"
+
+#include "exception.h"
+#include "global.h"
+#include "log.h"
+
+#include <lunchbox/os.h>
+#include <lunchbox/perThread.h>
+#include <lunchbox/scopedMutex.h>
+
+#include <errno.h>
+#include <liburing.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#define RING_DEPTH 256 // three entries per read
+
+namespace co
+{
+namespace
+{
+/** The request of a read chain, stored in the low bits of the user data. */
+enum Step
+{
+    STEP_CONSUME, //!< read the notifier
+    STEP_RECEIVE, //!< receive from the socket
+    STEP_SIGNAL,  //!< write the notifier
+    STEP_ALL,
+    STEP_MASK = 3
+};
+
+const uint64_t _one = 1;
+}
+
+void exitIORing( IORing* ring )
+{
+    ring->_drain();
+    ring->unref();
+}
+
+namespace
+{
+lunchbox::PerThread< IORing, exitIORing > _rings;
+IORingPtr _shared; // used by threads without a ring
+lunchbox::Lock _sharedLock;
+
+void* _getData( IORing::Read* read, const Step step )
+{
+    return reinterpret_cast< void* >( uintptr_t( read ) | step );
+}
+}
+
+IORing::Read::Read()
+    : _result( 0 )
+    , _counter( 0 )
+    , _notifier( ::eventfd( 1, EFD_CLOEXEC )) // consumed by the first chain
+    , _socket( -1 )
+    , _done( true )
+{
+    if( _notifier < 0 )
+        LBWARN << "Can't create eventfd: " << lunchbox::sysError << std::endl;
+}
+
+IORing::Read::~Read()
+{
+    if( _notifier >= 0 )
+        ::close( _notifier );
+    if( _socket >= 0 )
+        ::close( _socket );
+}
+
+IORing::IORing()
+    : _ring( new io_uring )
+    , _queued( 0 )
+    , _pending( 0 )
+    , _valid( false )
+{
+    const int error = io_uring_queue_init( RING_DEPTH, _ring, 0 );
+    if( error )
+        LBINFO << "io_uring not available: " << strerror( -error ) << std::endl;
+    else
+        _valid = true;
+}
+
+IORing::~IORing()
+{
+    if( _valid )
+    {
+        _reap();
+        io_uring_queue_exit( _ring );
+    }
+    delete _ring;
+}
+
+bool IORing::_isSupported()
+{
+    static int supported = -1;
+    static lunchbox::Lock lock;
+
+    lunchbox::ScopedMutex<> mutex( lock );
+    if( supported < 0 )
+    {
+        io_uring ring;
+        const int error = io_uring_queue_init( 1, &ring, 0 );
+        if( error )
+            LBINFO << "io_uring not available: " << strerror( -error )
+                   << std::endl;
+        else
+            io_uring_queue_exit( &ring );
+        supported = error ? 0 : 1;
+    }
+    return supported == 1;
+}
+
+IORing* IORing::_getShared()
+{
+    lunchbox::ScopedMutex<> mutex( _sharedLock );
+    if( !_shared )
+        _shared = new IORing;
+    return _shared->_valid ? _shared.get() : 0;
+}
+
+IORing::ReadPtr IORing::newRead()
+{
+    if( !_isSupported( ))
+        return 0;
+
+    ReadPtr read = new Read;
+    if( read->_notifier < 0 )
+        return 0;
+    return read;
+}
+
+void IORing::flush()
+{
+    IORing* ring = _rings.get();
+    if( !ring )
+    {
+        ring = new IORing;
+        ring->ref(); // unref in exitIORing
+        _rings = ring;
+    }
+    if( !ring->_valid )
+        return;
+
+    lunchbox::ScopedMutex<> mutex( ring->_lock );
+    ring->_reap();
+    ring->_submit();
+}
+
+void IORing::queue( ReadPtr read, const int fd, void* buffer,
+                    const uint64_t bytes )
+{
+    LBASSERT( read->_done );
+    IORing* ring = _rings.get();
+    if( ring && ring->_valid )
+    {
+        ring->_queue( read, fd, buffer, bytes );
+        return;
+    }
+
+    // No receiver thread, nobody flushes: use the shared ring and submit now
+    ring = _getShared();
+    if( ring )
+    {
+        ring->_queue( read, fd, buffer, bytes );
+        lunchbox::ScopedMutex<> mutex( ring->_lock );
+        ring->_submit();
+        return;
+    }
+
+    // fail the read and signal it, so that the connection gets closed
+    LBERROR << "No io_uring available, failing read" << std::endl;
+    read->_ring = 0;
+    read->_result = -ENOSYS;
+    if( ::write( read->_notifier, &_one, sizeof( _one )) != sizeof( _one ))
+        LBWARN << "Can't signal eventfd: " << lunchbox::sysError << std::endl;
+}
+
+void IORing::_queue( ReadPtr read, const int fd, void* buffer,
+                     const uint64_t bytes )
+{
+    lunchbox::ScopedMutex<> mutex( _lock );
+    if( io_uring_sq_space_left( _ring ) < STEP_ALL )
+        _submit();
+
+    io_uring_sqe* sqes[ STEP_ALL ];
+    for( size_t i = 0; i < STEP_ALL; ++i )
+    {
+        sqes[ i ] = io_uring_get_sqe( _ring );
+        LBASSERT( sqes[ i ] );
+        io_uring_sqe_set_data( sqes[ i ], _getData( read.get(), Step( i )));
+        read->ref(); // unref in _reap
+    }
+    _pending += STEP_ALL;
+
+    // Hard links keep the chain going on short or failed receives, so that the
+    // notifier is always signalled.
+    io_uring_prep_read( sqes[ STEP_CONSUME ], read->_notifier, &read->_counter,
+                        sizeof( read->_counter ), 0 );
+    io_uring_sqe_set_flags( sqes[ STEP_CONSUME ], IOSQE_IO_HARDLINK );
+    io_uring_prep_recv( sqes[ STEP_RECEIVE ], fd, buffer, bytes, 0 );
+    io_uring_sqe_set_flags( sqes[ STEP_RECEIVE ], IOSQE_IO_HARDLINK );
+    io_uring_prep_write( sqes[ STEP_SIGNAL ], read->_notifier, &_one,
+                         sizeof( _one ), 0 );
+
+    read->_ring = this;
+    read->_result = 0;
+    read->_done = false;
+    ++_queued;
+}
+
+bool IORing::wait( Read& read, const bool block )
+{
+    IORingPtr ring = read._ring;
+    if( !ring ) // failed in queue
+        return true;
+
+    // The ring may belong to another thread, which then can't flush while we
+    // wait here. The submit below does its work.
+    lunchbox::ScopedMutex<> mutex( ring->_lock );
+    ring->_submit();
+    ring->_reap();
+    if( read._done || !block )
+        return read._done;
+
+    const uint32_t timeout = Global::getTimeout();
+    __kernel_timespec time;
+    time.tv_sec = timeout / 1000;
+    time.tv_nsec = ( timeout % 1000 ) * 1000000;
+
+    while( !read._done )
+    {
+        io_uring_cqe* cqe = 0;
+        const int error = timeout == LB_TIMEOUT_INDEFINITE ?
+                              io_uring_wait_cqe( ring->_ring, &cqe ) :
+                              io_uring_wait_cqe_timeout( ring->_ring, &cqe,
+                                                         &time );
+        if( error == -ETIME )
+            throw Exception( Exception::TIMEOUT_READ );
+        if( error && error != -EINTR )
+        {
+            LBWARN << "Error waiting for read completion: "
+                   << strerror( -error ) << std::endl;
+            read._result = error;
+            return true;
+        }
+        ring->_reap();
+    }
+    return true;
+}
+
+void IORing::release( Read& read, const int fd )
+{
+    LBASSERT( read._socket < 0 );
+    read._socket = fd;
+
+    IORingPtr ring = read._ring;
+    if( !ring )
+        return;
+
+    // submit a queued chain, which then completes on the shut down socket
+    lunchbox::ScopedMutex<> mutex( ring->_lock );
+    ring->_submit();
+}
+
+void IORing::_submit()
+{
+    if( _queued == 0 )
+        return;
+
+    const int submitted = io_uring_submit( _ring );
+    if( submitted < 0 )
+        LBWARN << "io_uring submission failed: " << strerror( -submitted )
+               << std::endl;
+    else
+        _queued = 0;
+}
+
+void IORing::_reap()
+{
+    io_uring_cqe* cqe = 0;
+    while( io_uring_peek_cqe( _ring, &cqe ) == 0 )
+    {
+        const uintptr_t data = uintptr_t( io_uring_cqe_get_data( cqe ));
+        if( data == 0 ) // cancel request of _drain
+        {
+            io_uring_cqe_seen( _ring, cqe );
+            continue;
+        }
+
+        Read* read = reinterpret_cast< Read* >( data & ~uintptr_t( STEP_MASK ));
+        switch( data & STEP_MASK )
+        {
+        case STEP_RECEIVE:
+            read->_result = cqe->res;
+            read->_done = true;
+            break;
+
+        case STEP_SIGNAL:
+            // a cancelled chain does not signal, wake the reader ourselves
+            if( cqe->res < 0 &&
+                ::write( read->_notifier, &_one, sizeof( _one )) !=
+                    sizeof( _one ))
+            {
+                LBWARN << "Can't signal eventfd: " << lunchbox::sysError
+                       << std::endl;
+            }
+            break;
+        }
+        io_uring_cqe_seen( _ring, cqe );
+        LBASSERT( _pending > 0 );
+        --_pending;
+        read->unref(); // ref in queue
+    }
+}
+
+void IORing::_drain()
+{
+    if( !_valid )
+        return;
+
+    lunchbox::ScopedMutex<> mutex( _lock );
+    _submit(); // queued chains hold references and released sockets
+    _reap();
+    if( _pending == 0 )
+        return;
+
+    // cancel the pending receives, which may never complete otherwise
+    io_uring_sqe* sqe = io_uring_get_sqe( _ring );
+    if( sqe )
+    {
+        io_uring_prep_cancel64( sqe, 0, IORING_ASYNC_CANCEL_ANY );
+        io_uring_sqe_set_data( sqe, 0 );
+        ++_queued;
+        _submit();
+    }
+
+    const uint32_t timeout = Global::getTimeout();
+    __kernel_timespec time;
+    time.tv_sec = timeout / 1000;
+    time.tv_nsec = ( timeout % 1000 ) * 1000000;
+
+    while( _pending > 0 )
+    {
+        io_uring_cqe* cqe = 0;
+        const int error = timeout == LB_TIMEOUT_INDEFINITE ?
+                              io_uring_wait_cqe( _ring, &cqe ) :
+                              io_uring_wait_cqe_timeout( _ring, &cqe, &time );
+        if( error && error != -EINTR )
+        {
+            LBWARN << "Can't drain io_uring, " << _pending
+                   << " requests still pending: " << strerror( -error )
+                   << std::endl;
+            return;
+        }
+        _reap();
+    }
+}
+}
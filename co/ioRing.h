@@ -0,0 +1,136 @@
+
+/* Copyright (c) 2026, The Collage Authors
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef CO_IORING_H
+#define CO_IORING_H
+
+#include <co/types.h>
+#include <lunchbox/lock.h>
+#include <lunchbox/nonCopyable.h>
+#include <lunchbox/referenced.h>
+
+#ifndef CO_USE_LIBURING
+#  error IORing needs liburing
+#endif
+
+struct io_uring;
+
+namespace co
+{
+class IORing;
+typedef lunchbox::RefPtr< IORing > IORingPtr;
+
+/**
+ * An io_uring submitting and completing the asynchronous socket reads of one
+ * thread.
+ *
+ * A read is queued as a chain of three requests: consuming the notifier
+ * eventfd, receiving from the socket and signalling the notifier again. Queued
+ * reads are submitted together by flush(), which the ConnectionSet calls before
+ * it blocks, so one receiver thread re-arms all its connections with a single
+ * system call. Completions are reaped without system calls.
+ */
+class IORing : public lunchbox::Referenced, public lunchbox::NonCopyable
+{
+public:
+    /** One pending read, owned by a socket connection and its requests. */
+    class Read : public lunchbox::Referenced, public lunchbox::NonCopyable
+    {
+    public:
+        /** @return the eventfd signalled when the read has completed. */
+        int getNotifier() const { return _notifier; }
+
+        /** @return the result of the completed receive. */
+        int64_t getResult() const { return _result; }
+
+    private:
+        friend class IORing;
+        Read();
+        virtual ~Read();
+
+        IORingPtr _ring;
+        int64_t _result;
+        uint64_t _counter; //!< notifier value consumed by the chain
+        int _notifier;
+        int _socket; //!< released socket, closed with the last request
+        bool _done;
+    };
+    typedef lunchbox::RefPtr< Read > ReadPtr;
+
+    /** @return a new read, or 0 if io_uring is not supported. */
+    static ReadPtr newRead();
+
+    /**
+     * Submit all queued reads of the calling thread's ring.
+     *
+     * Creates the ring of a receiving thread on first use. The ring is drained
+     * when the thread exits: queued reads are submitted, pending ones are
+     * cancelled and all completions are reaped.
+     */
+    static void flush();
+
+    /**
+     * Queue a receive from a socket into the given buffer.
+     *
+     * The read is queued on the calling thread's ring, and submitted by the
+     * next flush(). Threads without a ring, e.g., during a handshake, use a
+     * shared ring and submit immediately.
+     */
+    static void queue( ReadPtr read, int fd, void* buffer, uint64_t bytes );
+
+    /**
+     * Wait for the completion of a read.
+     *
+     * @return true if the read has completed, false if block is false and the
+     *         read is still pending.
+     * @throw Exception on timeout.
+     */
+    static bool wait( Read& read, bool block );
+
+    /**
+     * Release the socket of a closed connection.
+     *
+     * Queued requests name the socket by its descriptor, which is therefore
+     * kept open until the last request of the read has completed. The socket
+     * has to be shut down, so that a pending receive completes.
+     */
+    static void release( Read& read, int fd );
+
+private:
+    IORing();
+    virtual ~IORing();
+
+    io_uring* const _ring;
+    lunchbox::Lock _lock;
+    uint32_t _queued;
+    uint32_t _pending; //!< submitted or queued requests not yet reaped
+    bool _valid;
+
+    friend void exitIORing( IORing* ring ); // drains the ring at thread exit
+    static bool _isSupported();
+    static IORing* _getShared();
+
+    void _queue( ReadPtr read, int fd, void* buffer, uint64_t bytes );
+    void _submit();
+    void _reap();
+    void _drain();
+};
+}
+
+#endif //CO_IORING_H
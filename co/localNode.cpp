@@ -37,6 +37,10 @@
 #include "objectICommand.h"
 #include "objectStore.h"
 #include "pipeConnection.h"
+#ifdef __linux__
+#  include "shmConnection.h"
+#endif
+#include "smallOCommand.h"
 #include "worker.h"
 #include "zeroconf.h"
 
@@ -68,6 +72,73 @@ typedef HandlerHash::const_iterator HandlerHashCIter;
 typedef std::pair< LocalNode::CommandHandler, CommandQueue* > CommandPair;
 typedef stde::hash_map< uint128_t, CommandPair > CommandHash;
 typedef CommandHash::const_iterator CommandHashCIter;
+
+/** The protocol features announced to peers during the handshake. */
+const uint32_t _features = NODE_FEATURE_UNPADDED_COMMANDS |
+                           NODE_FEATURE_FRAGMENTED_ITEMS |
+                           NODE_FEATURE_BATCHED_MAPPING;
+
+/**
+ * @return the features announced after the node data of a connect (reply)
+ *         command, or 0 for older peers which do not send them.
+ */
+uint32_t _getFeatures( ICommand& command, const std::string& data )
+{
+    // older peers pad the command with undefined data, use the command size
+    const uint64_t nodeDataSize = OCommand::getSize() + sizeof( NodeID ) +
+                                  2 * sizeof( uint32_t ) + sizeof( uint64_t ) +
+                                  data.length();
+    if( command.getSize() < nodeDataSize + sizeof( uint32_t ))
+        return 0;
+    return command.get< uint32_t >();
+}
+
+/** @return a shared memory listener for nodes on this host, if wanted. */
+ConnectionDescriptionPtr _newSHMDescription(
+    const ConnectionDescriptions& descriptions )
+{
+    if( !Global::getIAttribute( Global::IATTR_SHM_SAME_HOST ))
+        return 0;
+
+    bool remote = false;
+    for( ConnectionDescriptionsCIter i = descriptions.begin();
+         i != descriptions.end(); ++i )
+    {
+        const ConnectionType type = (*i)->type;
+        if( type == CONNECTIONTYPE_SHM )
+            return 0;
+        if( type == CONNECTIONTYPE_TCPIP || type == CONNECTIONTYPE_SDP )
+            remote = true;
+    }
+    if( !remote )
+        return 0;
+
+    ConnectionDescriptionPtr description = new ConnectionDescription;
+    description->type = CONNECTIONTYPE_SHM;
+    return description;
+}
+
+/**
+ * @return the descriptions to connect to a node with, its shared memory
+ *         listeners first if it runs on this host, and without them otherwise.
+ */
+ConnectionDescriptions _sortDescriptions(
+    const ConnectionDescriptions& descriptions )
+{
+    ConnectionDescriptions sorted;
+    for( ConnectionDescriptionsCIter i = descriptions.begin();
+         i != descriptions.end(); ++i )
+    {
+        ConnectionDescriptionPtr description = *i;
+        if( description->type != CONNECTIONTYPE_SHM )
+            sorted.push_back( description );
+#ifdef __linux__
+        else if( SHMConnection::isLocal( description ))
+            sorted.insert( sorted.begin(), description );
+#endif
+    }
+    return sorted;
+}
 }
 
 namespace detail
@@ -115,6 +186,7 @@ public:
     LocalNode()
             : smallBuffers( 200 )
             , bigBuffers( 20 )
+            , recvBuffers( 20 )
             , sendToken( true )
             , lastSendToken( 0 )
             , objectStore( 0 )
@@ -153,6 +225,9 @@ public:
     /** The command buffer 'allocator' for big packets */
     co::BufferCache bigBuffers;
 
+    /** The buffer 'allocator' for reads of multiple packets */
+    co::BufferCache recvBuffers;
+
     bool sendToken; //!< send token availability.
     uint64_t lastSendToken; //!< last used time for timeout detection
     std::deque< co::ICommand > sendTokenQueue; //!< pending requests
@@ -324,7 +399,12 @@ bool LocalNode::listen()
     if( !isClosed() || !_connectSelf( ))
         return false;
 
-    const ConnectionDescriptions& descriptions = getConnectionDescriptions();
+    // Nodes on the same host connect over shared memory, if available
+    ConnectionDescriptions descriptions = getConnectionDescriptions();
+    ConnectionDescriptionPtr shm = _newSHMDescription( descriptions );
+    if( shm )
+        descriptions.push_back( shm );
+
     for( ConnectionDescriptionsCIter i = descriptions.begin();
          i != descriptions.end(); ++i )
     {
@@ -333,10 +413,18 @@ bool LocalNode::listen()
 
         if( !connection || !connection->listen( ))
         {
+            if( description == shm )
+            {
+                LBINFO << "No shared memory listener for nodes on this host"
+                       << std::endl;
+                continue;
+            }
             LBWARN << "Can't create listener connection: " << description
                    << std::endl;
             return false;
         }
+        if( description == shm )
+            _addConnectionDescription( shm );
 
         _impl->connectionNodes[ connection ] = this;
         _impl->incoming.addConnection( connection );
@@ -482,8 +570,8 @@ void LocalNode::_addConnection( ConnectionPtr connection )
     }
 
     _impl->incoming.addConnection( connection );
-    BufferPtr buffer = _impl->smallBuffers.alloc( COMMAND_ALLOCSIZE );
-    connection->recvNB( buffer, COMMAND_MINSIZE );
+    BufferPtr buffer = _impl->recvBuffers.alloc( COMMAND_RECVSIZE );
+    connection->recvAvailableNB( buffer, COMMAND_RECVSIZE );
 }
 
 void LocalNode::_removeConnection( ConnectionPtr connection )
@@ -571,7 +659,11 @@ bool LocalNode::_connectSelf()
         return false;
     }
 
-    Node::_connect( connection->acceptSync( ));
+    ConnectionPtr sibling = connection->acceptSync();
+    sibling->setUnpaddedCommands( true ); // read by our own receiver thread
+    sibling->setFragmentedItems( true );
+    sibling->setBatchedMapping( true );
+    Node::_connect( sibling );
     _setClosed(); // reset state after _connect set it to connected
 
     // add to connection set
@@ -614,13 +706,14 @@ void LocalNode::ackRequest( NodePtr node, const uint32_t requestID )
     if( node == this ) // OPT
         serveRequest( requestID );
     else
-        node->send( CMD_NODE_ACK_REQUEST ) << requestID;
+        SmallOCommand( node, CMD_NODE_ACK_REQUEST )
+            << requestID;
 }
 
 void LocalNode::ping( NodePtr peer )
 {
     LBASSERT( !_impl->inReceiverThread( ));
-    peer->send( CMD_NODE_PING );
+    SmallOCommand( peer, CMD_NODE_PING );
 }
 
 bool LocalNode::pingIdleNodes()
@@ -638,7 +731,7 @@ bool LocalNode::pingIdleNodes()
         {
             LBINFO << " Ping Node: " <<  node->getNodeID() << " last seen "
                    << node->getLastReceiveTime() << std::endl;
-            node->send( CMD_NODE_PING );
+            SmallOCommand( node, CMD_NODE_PING );
             pinged = true;
         }
     }
@@ -702,6 +795,17 @@ bool LocalNode::mapObjectSync( const uint32_t requestID )
     return _impl->objectStore->mapObjectSync( requestID );
 }
 
+RequestIDs LocalNode::mapObjectsNB( const Objects& objects,
+                                    const ObjectVersions& versions )
+{
+    return _impl->objectStore->mapObjectsNB( objects, versions );
+}
+
+bool LocalNode::mapObjectsSync( const RequestIDs& requestIDs )
+{
+    return _impl->objectStore->mapObjectsSync( requestIDs );
+}
+
 void LocalNode::unmapObject( Object* object )
 {
     _impl->objectStore->unmapObject( object );
@@ -756,7 +860,8 @@ LocalNode::SendToken LocalNode::acquireSendToken( NodePtr node )
     LBASSERT( !_impl->inReceiverThread( ));
 
     const uint32_t requestID = registerRequest();
-    node->send( CMD_NODE_ACQUIRE_SEND_TOKEN ) << requestID;
+    SmallOCommand( node, CMD_NODE_ACQUIRE_SEND_TOKEN )
+        << requestID;
 
     bool ret = false;
     if( waitRequest( requestID, ret, Global::getTimeout( )))
@@ -773,7 +878,7 @@ void LocalNode::releaseSendToken( SendToken& node )
     if( !node )
         return;
 
-    node->send( CMD_NODE_RELEASE_SEND_TOKEN );
+    SmallOCommand( node, CMD_NODE_RELEASE_SEND_TOKEN );
     node = 0; // In case app stores token in member variable
 }
 
@@ -980,7 +1085,8 @@ uint32_t LocalNode::_connect( NodePtr node )
     LBINFO << "Connecting " << node << std::endl;
 
     // try connecting using the given descriptions
-    const ConnectionDescriptions& cds = node->getConnectionDescriptions();
+    const ConnectionDescriptions& cds =
+        _sortDescriptions( node->getConnectionDescriptions( ));
     for( ConnectionDescriptionsCIter i = cds.begin();
         i != cds.end(); ++i )
     {
@@ -1026,7 +1132,7 @@ uint32_t LocalNode::_connect( NodePtr node, ConnectionPtr connection )
     const uint32_t cmd = CMD_NODE_CONNECT;
 #endif
     OCommand( Connections( 1, connection ), cmd )
-        << getNodeID() << requestID << getType() << serialize();
+        << getNodeID() << requestID << getType() << serialize() << _features;
 
     bool connected = false;
     if( !waitRequest( requestID, connected, 10000 /*ms*/ ))
@@ -1186,6 +1292,7 @@ void LocalNode::_runReceiverThread()
     _impl->pendingCommands.clear();
     _impl->smallBuffers.flush();
     _impl->bigBuffers.flush();
+    _impl->recvBuffers.flush();
 
     LBINFO << "Leaving receiver thread of " << lunchbox::className( this )
            << std::endl;
@@ -1235,36 +1342,77 @@ bool LocalNode::_handleData()
 {
     _impl->smallBuffers.compact();
     _impl->bigBuffers.compact();
+    _impl->recvBuffers.compact();
 
     ConnectionPtr connection = _impl->incoming.getConnection();
     LBASSERT( connection );
 
-    BufferPtr buffer = _readHead( connection );
-    if( !buffer ) // fluke signal
+    BufferPtr recvBuffer = _readHead( connection );
+    if( !recvBuffer ) // fluke signal
         return false;
 
-    ICommand command = _setupCommand( connection, buffer );
-    const bool gotCommand = _readTail( command, buffer, connection );
-    LBASSERT( gotCommand );
-
-    // start next receive
-    BufferPtr nextBuffer = _impl->smallBuffers.alloc( COMMAND_ALLOCSIZE );
-    connection->recvNB( nextBuffer, COMMAND_MINSIZE );
+    // Commands retained after dispatch keep their buffer alive. Copy small
+    // reads out, so they don't pin a whole receive buffer, which is then
+    // reused for the next receive.
+    BufferPtr buffer = recvBuffer;
+    if( recvBuffer->getSize() <= COMMAND_ALLOCSIZE )
+    {
+        buffer = _impl->smallBuffers.alloc( COMMAND_ALLOCSIZE );
+        buffer->replace( recvBuffer->getData(), recvBuffer->getSize( ));
+    }
 
-    if( gotCommand )
+    // Dispatch all complete commands of the read. They share its buffer, only
+    // commands bigger than the receive size are read into their own buffer.
+    uint64_t offset = 0;
+    while( buffer->getSize() - offset >= OCommand::getSize( ))
     {
+        uint64_t wireSize = 0;
+        ICommand command = _setupCommand( connection, buffer, offset,
+                                          wireSize );
+        if( !command.isValid( ))
+        {
+            LBERROR << "Invalid command read on " << connection << std::endl;
+            _removeConnection( connection );
+            return false;
+        }
+
+        if( wireSize > buffer->getSize() - offset )
+        {
+            if( wireSize <= COMMAND_RECVSIZE )
+                break; // incomplete, continued by the next read
+
+            if( !_readTail( command, wireSize, buffer, offset, connection ))
+            {
+                LBERROR << "Incomplete command read: " << command << std::endl;
+                return false;
+            }
+            offset = buffer->getSize();
+        }
+        else
+            offset += wireSize;
+
         _dispatchCommand( command );
-        return true;
+        if( connection->isClosed( )) // removed by the command handler
+            return true;
     }
 
-    LBERROR << "Incomplete command read: " << command << std::endl;
-    return false;
+    // start next receive, continuing the incomplete command
+    BufferPtr nextBuffer = recvBuffer;
+    if( buffer == recvBuffer )
+        nextBuffer = _impl->recvBuffers.alloc( COMMAND_RECVSIZE );
+    else
+        nextBuffer->resize( 0 );
+    const uint64_t remaining = buffer->getSize() - offset;
+    if( remaining > 0 )
+        nextBuffer->append( buffer->getData() + offset, remaining );
+    connection->recvAvailableNB( nextBuffer, COMMAND_RECVSIZE - remaining );
+    return true;
 }
 
 BufferPtr LocalNode::_readHead( ConnectionPtr connection )
 {
     BufferPtr buffer;
-    const bool gotSize = connection->recvSync( buffer, false );
+    const bool gotData = connection->recvSync( buffer, false );
 
     if( !buffer ) // fluke signal
     {
@@ -1274,18 +1422,19 @@ BufferPtr LocalNode::_readHead( ConnectionPtr connection )
         return 0;
     }
 
-    if( !gotSize ) // Some systems signal data on dead connections.
+    if( !gotData ) // Some systems signal data on dead connections.
     {
-        buffer->setSize( 0 );
-        connection->recvNB( buffer, COMMAND_MINSIZE );
+        // keep the start of an incomplete command from the last read
+        connection->recvAvailableNB( buffer,
+                                     COMMAND_RECVSIZE - buffer->getSize( ));
         return 0;
     }
 
     return buffer;
 }
 
-ICommand LocalNode::_setupCommand( ConnectionPtr connection,
-                                   ConstBufferPtr buffer )
+ICommand LocalNode::_setupCommand( ConnectionPtr connection, BufferPtr buffer,
+                                   const uint64_t offset, uint64_t& wireSize )
 {
     NodePtr node;
     ConnectionNodeHashCIter i = _impl->connectionNodes.find( connection );
@@ -1301,7 +1450,26 @@ ICommand LocalNode::_setupCommand( ConnectionPtr connection,
 #else
     const bool swapping = node ? node->isBigEndian() : false;
 #endif
-    ICommand command( this, node, buffer, swapping );
+    // Only connected peers may send unpadded commands, the byte order of
+    // handshake commands is not known here.
+    uint64_t flag = 0;
+    if( node && !connection->isMulticast( ))
+    {
+        flag = COMMAND_UNPADDED;
+        if( swapping )
+            lunchbox::byteswap( flag );
+    }
+    uint8_t* sizeField = buffer->getData() + offset;
+    uint64_t size = 0;
+    ::memcpy( &size, sizeField, sizeof( size ));
+    const bool padded = !( size & flag );
+    if( !padded )
+    {
+        size &= ~flag;
+        ::memcpy( sizeField, &size, sizeof( size ));
+    }
+
+    ICommand command( this, node, buffer, swapping, offset );
 
     if( node )
         node->_setLastReceive( getTime64( ));
@@ -1317,7 +1485,7 @@ ICommand LocalNode::_setupCommand( ConnectionPtr connection,
           case CMD_NODE_CONNECT_REPLY:
           case CMD_NODE_ID:
 #ifdef COLLAGE_BIGENDIAN
-              command = ICommand( this, node, buffer, true );
+              command = ICommand( this, node, buffer, true, offset );
 #endif
               break;
 
@@ -1325,7 +1493,7 @@ ICommand LocalNode::_setupCommand( ConnectionPtr connection,
           case CMD_NODE_CONNECT_REPLY_BE:
           case CMD_NODE_ID_BE:
 #ifndef COLLAGE_BIGENDIAN
-              command = ICommand( this, node, buffer, true );
+              command = ICommand( this, node, buffer, true, offset );
 #endif
               break;
 
@@ -1336,31 +1504,37 @@ ICommand LocalNode::_setupCommand( ConnectionPtr connection,
         command.setCommand( cmd ); // reset correctly swapped version
     }
 
+    wireSize = padded ? LB_MAX( command.getSize(),
+                                uint64_t( COMMAND_MINSIZE )) :
+                        command.getSize();
+    if( !padded && wireSize > buffer->getSize() - offset )
+    {
+        // incomplete, keep the flag for parsing it again after the next read
+        size |= flag;
+        ::memcpy( sizeField, &size, sizeof( size ));
+    }
     return command;
 }
 
-bool LocalNode::_readTail( ICommand& command, BufferPtr buffer,
+bool LocalNode::_readTail( ICommand& command, const uint64_t wireSize,
+                           ConstBufferPtr buffer, const uint64_t offset,
                            ConnectionPtr connection )
 {
-    const uint64_t needed = command.getSize();
-    if( needed <= buffer->getSize( ))
-        return true;
+    // not enough space in the receive buffer, read into a new buffer
+    LBASSERT( wireSize > COMMAND_RECVSIZE );
+    const uint64_t available = buffer->getSize() - offset;
+    BufferPtr bigBuffer = _impl->bigBuffers.alloc( wireSize );
+    bigBuffer->append( buffer->getData() + offset, available );
 
-    if( needed > buffer->getMaxSize( ))
-    {
-        LBASSERT( needed > COMMAND_ALLOCSIZE );
-        // not enough space for remaining data, alloc and copy to new buffer
-        BufferPtr newBuffer = _impl->bigBuffers.alloc( needed );
-        newBuffer->replace( *buffer );
-        buffer = newBuffer;
-
-        command = ICommand( this, command.getNode(), buffer,
-                            command.isSwapping( ));
-    }
+    connection->recvNB( bigBuffer, wireSize - available );
+    if( !connection->recvSync( bigBuffer ))
+        return false;
 
-    // read remaining data
-    connection->recvNB( buffer, command.getSize() - buffer->getSize( ));
-    return connection->recvSync( buffer );
+    const uint32_t cmd = command.getCommand(); // swapped by _setupCommand
+    command = ICommand( this, command.getNode(), bigBuffer,
+                        command.isSwapping(), 0 );
+    command.setCommand( cmd );
+    return true;
 }
 
 BufferPtr LocalNode::allocBuffer( const uint64_t size )
@@ -1538,6 +1712,7 @@ bool LocalNode::_cmdConnect( ICommand& command )
     const uint32_t requestID = command.get< uint32_t >();
     const uint32_t nodeType = command.get< uint32_t >();
     std::string data = command.get< std::string >();
+    const uint32_t features = _getFeatures( command, data );
 
     LBVERB << "handle connect " << command << " req " << requestID << " type "
            << nodeType << " data " << data << std::endl;
@@ -1599,8 +1774,15 @@ bool LocalNode::_cmdConnect( ICommand& command )
 
     // send our information as reply
     OCommand( Connections( 1, connection ), cmd )
-        << getNodeID() << requestID << getType() << serialize();
-
+        << getNodeID() << requestID << getType() << serialize() << _features;
+
+    // the reply has to be padded, the peer does not know us yet
+    connection->setUnpaddedCommands(
+        ( features & NODE_FEATURE_UNPADDED_COMMANDS ) != 0 );
+    connection->setFragmentedItems(
+        ( features & NODE_FEATURE_FRAGMENTED_ITEMS ) != 0 );
+    connection->setBatchedMapping(
+        ( features & NODE_FEATURE_BATCHED_MAPPING ) != 0 );
     notifyConnect( peer );
     return true;
 }
@@ -1630,6 +1812,7 @@ bool LocalNode::_cmdConnectReply( ICommand& command )
 
     const uint32_t nodeType = command.get< uint32_t >();
     std::string data = command.get< std::string >();
+    const uint32_t features = _getFeatures( command, data );
 
     LBVERB << "handle connect reply " << command << " req " << requestID
            << " type " << nodeType << " data " << data << std::endl;
@@ -1673,6 +1856,12 @@ bool LocalNode::_cmdConnectReply( ICommand& command )
     LBASSERT( data.empty( ));
     LBASSERT( peer->getNodeID() == nodeID );
 
+    connection->setUnpaddedCommands(
+        ( features & NODE_FEATURE_UNPADDED_COMMANDS ) != 0 );
+    connection->setFragmentedItems(
+        ( features & NODE_FEATURE_FRAGMENTED_ITEMS ) != 0 );
+    connection->setBatchedMapping(
+        ( features & NODE_FEATURE_BATCHED_MAPPING ) != 0 );
     peer->_connect( connection );
     _impl->connectionNodes[ connection ] = peer;
     {
@@ -1865,7 +2054,8 @@ bool LocalNode::_cmdAcquireSendToken( ICommand& command )
     _impl->sendToken = false;
 
     const uint32_t requestID = command.get< uint32_t >();
-    command.getNode()->send( CMD_NODE_ACQUIRE_SEND_TOKEN_REPLY ) << requestID;
+    SmallOCommand( command.getNode(),
+                   CMD_NODE_ACQUIRE_SEND_TOKEN_REPLY ) << requestID;
     return true;
 }
 
@@ -1892,7 +2082,8 @@ bool LocalNode::_cmdReleaseSendToken( ICommand& )
     ICommand& request = _impl->sendTokenQueue.front();
 
     const uint32_t requestID = request.get< uint32_t >();
-    request.getNode()->send( CMD_NODE_ACQUIRE_SEND_TOKEN_REPLY ) << requestID;
+    SmallOCommand( request.getNode(),
+                   CMD_NODE_ACQUIRE_SEND_TOKEN_REPLY ) << requestID;
     _impl->sendTokenQueue.pop_front();
     return true;
 }
@@ -1954,7 +2145,7 @@ bool LocalNode::_cmdRemoveListener( ICommand& command )
 bool LocalNode::_cmdPing( ICommand& command )
 {
     LBASSERT( inCommandThread( ));
-    command.getNode()->send( CMD_NODE_PING_REPLY );
+    SmallOCommand( command.getNode(), CMD_NODE_PING_REPLY );
     return true;
 }
 
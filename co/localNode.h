@@ -240,6 +240,22 @@ namespace detail { class LocalNode; class ReceiverThread; class CommandThread; }
         /** Finalize the mapping of a distributed object. @version 1.0 */
         CO_API virtual bool mapObjectSync( const uint32_t requestID );
 
+        /**
+         * Start mapping multiple distributed objects.
+         *
+         * The master nodes of all objects are resolved with one request per
+         * connected node, and all map requests to the same master are sent in
+         * one command. The master answers all of them in one pipelined stream.
+         *
+         * @sa mapObject()
+         * @version 1.1
+         */
+        CO_API virtual RequestIDs mapObjectsNB( const Objects& objects,
+                                                const ObjectVersions& versions );
+
+        /** Finalize the mapping of multiple objects. @version 1.1 */
+        CO_API virtual bool mapObjectsSync( const RequestIDs& requestIDs );
+
         /**
          * Unmap a mapped object.
          *
@@ -503,8 +519,10 @@ namespace detail { class LocalNode; class ReceiverThread; class CommandThread; }
         void   _handleDisconnect();
         bool   _handleData();
         BufferPtr _readHead( ConnectionPtr connection );
-        ICommand   _setupCommand( ConnectionPtr, ConstBufferPtr );
-        bool      _readTail( ICommand&, BufferPtr, ConnectionPtr );
+        ICommand   _setupCommand( ConnectionPtr, BufferPtr, uint64_t offset,
+                                  uint64_t& wireSize );
+        bool      _readTail( ICommand&, uint64_t wireSize, ConstBufferPtr,
+                             uint64_t offset, ConnectionPtr );
         void   _initService();
         void   _exitService();
 
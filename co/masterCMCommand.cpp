@@ -32,9 +32,6 @@ public:
     MasterCMCommand()
     {}
 
-    MasterCMCommand( const MasterCMCommand& )
-    {}
-
     uint128_t requestedVersion;
     uint128_t minCachedVersion;
     uint128_t maxCachedVersion;
@@ -52,23 +49,29 @@ MasterCMCommand::MasterCMCommand( const ICommand& command )
     : ICommand( command )
     , _impl( new detail::MasterCMCommand )
 {
-    _init();
+    if( isValid( ))
+        _read( *this );
+}
+
+MasterCMCommand::MasterCMCommand( const ICommand& command, DataIStream& entry )
+    : ICommand( command )
+    , _impl( new detail::MasterCMCommand )
+{
+    _read( entry );
 }
 
 MasterCMCommand::MasterCMCommand( const MasterCMCommand& rhs )
     : ICommand( rhs )
     , _impl( new detail::MasterCMCommand( *rhs._impl ))
 {
-    _init();
 }
 
-void MasterCMCommand::_init()
+void MasterCMCommand::_read( DataIStream& is )
 {
-    if( isValid( ))
-        *this >> _impl->requestedVersion >> _impl->minCachedVersion
-              >> _impl->maxCachedVersion >> _impl->objectID >> _impl->maxVersion
-              >> _impl->requestID >> _impl->instanceID
-              >> _impl->masterInstanceID >> _impl->useCache;
+    is >> _impl->requestedVersion >> _impl->minCachedVersion
+       >> _impl->maxCachedVersion >> _impl->objectID >> _impl->maxVersion
+       >> _impl->requestID >> _impl->instanceID >> _impl->masterInstanceID
+       >> _impl->useCache;
 }
 
 MasterCMCommand::~MasterCMCommand()
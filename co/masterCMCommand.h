@@ -32,6 +32,9 @@ class MasterCMCommand : public ICommand
 public:
     MasterCMCommand( const ICommand& command );
 
+    /** Construct from one map request entry read from the given stream. */
+    MasterCMCommand( const ICommand& command, DataIStream& entry );
+
     MasterCMCommand( const MasterCMCommand& rhs );
 
     virtual ~MasterCMCommand();
@@ -59,7 +62,7 @@ private:
     MasterCMCommand& operator = ( const MasterCMCommand& );
     detail::MasterCMCommand* const _impl;
 
-    void _init();
+    void _read( DataIStream& is );
 };
 
 }
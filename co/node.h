@@ -190,6 +190,7 @@ namespace detail { class Node; }
 
         /** Ensures the connectivity of this node. */
         ConnectionPtr _getConnection( const bool preferMulticast );
+        friend class SmallOCommand;
 
         /** @internal @name Methods for LocalNode */
         //@{
@@ -68,9 +68,20 @@ namespace co
         CMD_NODE_COMMAND,
         CMD_NODE_PING,
         CMD_NODE_PING_REPLY,
-        CMD_NODE_ADD_CONNECTION
+        CMD_NODE_ADD_CONNECTION,
+        CMD_NODE_FIND_MASTER_NODE_IDS,
+        CMD_NODE_FIND_MASTER_NODE_IDS_REPLY,
+        CMD_NODE_MAP_OBJECTS
         // check that not more than CMD_NODE_CUSTOM have been defined!
     };
+
+    /** Optional protocol features, announced during the connect handshake. */
+    enum NodeFeature
+    {
+        NODE_FEATURE_UNPADDED_COMMANDS = 1, //!< reads the command size first
+        NODE_FEATURE_FRAGMENTED_ITEMS = 2, //!< reads items spanning commands
+        NODE_FEATURE_BATCHED_MAPPING = 4 //!< maps many objects per command
+    };
 }
 
 #endif // CO_NODECOMMAND_H
@@ -34,12 +34,14 @@ public:
     OCommand( co::Dispatcher* const dispatcher_, LocalNodePtr localNode_ )
         : isLocked( false )
         , size( 0 )
+        , priority( COMMANDPRIORITY_CONTROL )
         , dispatcher( dispatcher_ )
         , localNode( localNode_ )
     {}
 
     bool isLocked;
     uint64_t size;
+    CommandPriority priority;
     co::Dispatcher* const dispatcher;
     LocalNodePtr localNode;
 };
@@ -85,7 +87,8 @@ OCommand::~OCommand()
                  i != connections.end(); ++i )
             {
                 ConnectionPtr connection = *i;
-                connection->send( padding, delta, true );
+                if( !connection->hasUnpaddedCommands( ))
+                    connection->send( padding, delta, true );
             }
         }
         for( ConnectionsCIter i = connections.begin();
@@ -129,13 +132,18 @@ void OCommand::sendHeader( const uint64_t additionalSize )
     for( ConnectionsCIter i = connections.begin(); i != connections.end(); ++i )
     {
         ConnectionPtr connection = *i;
-        connection->lockSend();
+        connection->lockSend( _impl->priority );
     }
     _impl->isLocked = true;
     _impl->size = additionalSize;
     flush( true );
 }
 
+void OCommand::_setPriority( const CommandPriority priority )
+{
+    _impl->priority = priority;
+}
+
 size_t OCommand::getSize()
 {
     return sizeof( uint64_t ) + sizeof( uint32_t ) + sizeof( uint32_t );
@@ -164,15 +172,30 @@ void OCommand::sendData( const void* buffer, const uint64_t size,
 
     // Update size field
     uint8_t* bytes = getBuffer().getData();
-    reinterpret_cast< uint64_t* >( bytes )[ 0 ] = _impl->size + size;
-    const uint64_t sendSize = _impl->isLocked ? size : LB_MAX( size,
-                                                               COMMAND_MINSIZE);
+    uint64_t& sizeField = reinterpret_cast< uint64_t* >( bytes )[ 0 ];
+    const uint64_t commandSize = _impl->size + size;
+    const uint64_t paddedSize = _impl->isLocked ? size : LB_MAX( size,
+                                                                COMMAND_MINSIZE);
     const Connections& connections = getConnections();
     for( ConnectionsCIter i = connections.begin(); i != connections.end(); ++i )
     {
         ConnectionPtr connection = *i;
-        connection->send( bytes, sendSize, _impl->isLocked );
+        if( !_impl->isLocked )
+            connection->lockSend( _impl->priority );
+        if( connection->hasUnpaddedCommands( ))
+        {
+            sizeField = commandSize | COMMAND_UNPADDED;
+            connection->send( bytes, size, true );
+        }
+        else
+        {
+            sizeField = commandSize;
+            connection->send( bytes, paddedSize, true );
+        }
+        if( !_impl->isLocked )
+            connection->unlockSend();
     }
+    sizeField = commandSize;
 }
 
 }
@@ -85,6 +85,9 @@ protected:
     CO_API virtual void sendData( const void* buffer, const uint64_t size,
                                   const bool last );
 
+    /** @internal Set the priority used to lock the connections. */
+    void _setPriority( const CommandPriority priority );
+
 private:
     OCommand& operator = ( const OCommand& );
     detail::OCommand* const _impl;
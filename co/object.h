@@ -391,7 +391,7 @@ public:
 
     /** @internal */
     CO_API void removeSlave( NodePtr node, const uint32_t instanceID );
-    CO_API void removeSlaves( NodePtr node ); //!< @internal
+    CO_API virtual void removeSlaves( NodePtr node ); //!< @internal
     void setMasterNode( NodePtr node ); //!< @internal
     /** @internal */
     void addInstanceDatas( const ObjectDataIStreamDeque&, const uint128_t&);
@@ -35,6 +35,8 @@ namespace co
     class ObjectDataIStream : public DataIStream
     {
     public:
+        typedef std::deque< ICommand > CommandDeque;
+
         ObjectDataIStream();
         ObjectDataIStream( const ObjectDataIStream& from );
         virtual ~ObjectDataIStream();
@@ -55,13 +57,14 @@ namespace co
         bool hasInstanceData() const;
         CO_API virtual NodePtr getMaster();
 
+        /** @return the not yet consumed data commands of this stream. */
+        const CommandDeque& getDataCommands() const { return _commands; }
+
     protected:
         virtual bool getNextBuffer( uint32_t& compressor, uint32_t& nChunks,
                                     const void** chunkData, uint64_t& size );
 
     private:
-        typedef std::deque< ICommand > CommandDeque;
-
         /** All data commands for this istream. */
         CommandDeque _commands;
 
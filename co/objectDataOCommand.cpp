@@ -68,6 +68,9 @@ ObjectDataOCommand::ObjectDataOCommand( const Connections& receivers,
     : ObjectOCommand( receivers, cmd, type, id, instanceID )
     , _impl( new detail::ObjectDataOCommand( stream, dataSize ))
 {
+    // instance data goes to the node, deltas to the object instances
+    _setPriority( type == COMMANDTYPE_NODE ? COMMANDPRIORITY_INSTANCE :
+                                             COMMANDPRIORITY_DELTA );
     _init( version, sequence, dataSize, isLast );
 }
 
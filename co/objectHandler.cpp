@@ -20,6 +20,7 @@
 #include "objectHandler.h"
 
 #include "object.h"
+#include "objectVersion.h"
 
 namespace co
 {
@@ -34,4 +35,25 @@ void ObjectHandler::releaseObject( Object* object )
     else
         unmapObject( object );
 }
+
+RequestIDs ObjectHandler::mapObjectsNB( const Objects& objects,
+                                        const ObjectVersions& versions )
+{
+    LBASSERT( objects.size() == versions.size( ));
+
+    RequestIDs requestIDs( objects.size(), LB_UNDEFINED_UINT32 );
+    for( size_t i = 0; i < objects.size() && i < versions.size(); ++i )
+        requestIDs[i] = mapObjectNB( objects[i], versions[i].identifier,
+                                     versions[i].version, 0 );
+    return requestIDs;
+}
+
+bool ObjectHandler::mapObjectsSync( const RequestIDs& requestIDs )
+{
+    bool mapped = true;
+    for( RequestIDsCIter i = requestIDs.begin(); i != requestIDs.end(); ++i )
+        if( !mapObjectSync( *i ))
+            mapped = false;
+    return mapped;
+}
 }
@@ -68,6 +68,29 @@ namespace co
         /** Finalize the mapping of a distributed object. @version 1.0 */
         virtual bool mapObjectSync( const uint32_t requestID ) = 0;
 
+        /**
+         * Start mapping multiple distributed objects.
+         *
+         * The default implementation calls mapObjectNB() for each object.
+         *
+         * @param objects the objects to map.
+         * @param versions the identifier and version to map, one per object.
+         * @return the request identifiers for mapObjectsSync(), in the order
+         *         of the given objects.
+         * @version 1.1
+         */
+        CO_API virtual RequestIDs mapObjectsNB( const Objects& objects,
+                                                const ObjectVersions& versions );
+
+        /**
+         * Finalize the mapping of multiple distributed objects.
+         *
+         * @param requestIDs the request identifiers from mapObjectsNB().
+         * @return true if all objects were mapped, false otherwise.
+         * @version 1.1
+         */
+        CO_API virtual bool mapObjectsSync( const RequestIDs& requestIDs );
+
         /** Unmap a mapped object. @version 1.0 */
         virtual void unmapObject( Object* object ) = 0;
 
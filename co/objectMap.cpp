@@ -23,6 +23,7 @@
 #include "dataIStream.h"
 #include "dataOStream.h"
 #include "objectFactory.h"
+#include "objectVersion.h"
 
 #include <lunchbox/scopedMutex.h>
 
@@ -56,7 +57,7 @@ class ObjectMap
 {
 public:
     ObjectMap( ObjectHandler& h, ObjectFactory& f )
-        : handler( h ) , factory( f ) {}
+        : handler( h ) , factory( f ), autoMap( false ) {}
 
     ~ObjectMap()
     {
@@ -91,6 +92,92 @@ public:
         entry.instance = 0;
     }
 
+    /**
+     * Create and map all unmapped entries, syncing after all are issued.
+     *
+     * Must be called without holding the lock, which is only taken to read
+     * the entries and to store the mapped instances.
+     */
+    void mapEntries( const IDVector& identifiers )
+    {
+        Objects objects;
+        ObjectVersions versions;
+        std::vector< uint32_t > types;
+        {
+            lunchbox::ScopedFastRead mutex( lock );
+            for( IDVectorCIter i = identifiers.begin();
+                 i != identifiers.end(); ++i )
+            {
+                MapCIter it = map.find( *i );
+                if( it == map.end( ))
+                    continue;
+
+                const Entry& entry = it->second;
+                if( entry.instance || entry.type == OBJECTTYPE_NONE )
+                    continue;
+
+                versions.push_back( ObjectVersion( *i, entry.version ));
+                types.push_back( entry.type );
+            }
+        }
+
+        size_t nObjects = 0;
+        for( size_t i = 0; i < types.size(); ++i )
+        {
+            co::Object* object = factory.createObject( types[i] );
+            LBASSERT( object );
+            if( !object )
+                continue;
+
+            objects.push_back( object );
+            versions[ nObjects ] = versions[i];
+            types[ nObjects ] = types[i];
+            ++nObjects;
+        }
+        if( objects.empty( ))
+            return;
+        versions.resize( nObjects );
+        types.resize( nObjects );
+
+        const RequestIDs requests = handler.mapObjectsNB( objects, versions );
+        LBASSERT( requests.size() == objects.size( ));
+
+        Objects unused;
+        std::vector< uint32_t > unusedTypes;
+        for( size_t i = 0; i < objects.size(); ++i )
+        {
+            co::Object* object = objects[i];
+            if( !handler.mapObjectSync( requests[i] ))
+            {
+                LBWARN << "Automatic mapping of " << versions[i].identifier
+                       << " failed" << std::endl;
+                factory.destroyObject( object, types[i] );
+                continue;
+            }
+
+            lunchbox::ScopedFastWrite mutex( lock );
+            MapIter it = map.find( versions[i].identifier );
+            if( it == map.end() || it->second.instance )
+            {
+                // removed or mapped by someone else while we were mapping
+                unused.push_back( object );
+                unusedTypes.push_back( types[i] );
+                continue;
+            }
+
+            Entry& entry = it->second;
+            LBASSERT( object->getVersion() == entry.version );
+            entry.instance = object;
+            entry.own = true;
+        }
+
+        for( size_t i = 0; i < unused.size(); ++i )
+        {
+            handler.unmapObject( unused[i] );
+            factory.destroyObject( unused[i], unusedTypes[i] );
+        }
+    }
+
     ObjectHandler& handler;
     ObjectFactory& factory; //!< The 'parent' user
 
@@ -107,6 +194,9 @@ public:
 
     /** Changed master objects since the last commit. */
     ObjectVersions changed;
+
+    /** Map new entries during deserialize. */
+    bool autoMap;
 };
 }
 
@@ -195,6 +285,7 @@ void ObjectMap::deserialize( DataIStream& is, const uint64_t dirtyBits )
 {
     Serializable::deserialize( is, dirtyBits );
     lunchbox::ScopedFastWrite mutex( _impl->lock );
+    IDVector added;
     if( dirtyBits == DIRTY_ALL )
     {
         LBASSERT( _impl->map.empty( ));
@@ -206,14 +297,17 @@ void ObjectMap::deserialize( DataIStream& is, const uint64_t dirtyBits )
             LBASSERT( _impl->map.find( ov.identifier ) == _impl->map.end( ));
             Entry& entry = _impl->map[ ov.identifier ];
             entry.version = ov.version;
+            added.push_back( ov.identifier );
             is >> entry.type >> ov;
         }
+        mutex.leave(); // mapping blocks on the master nodes
+        if( _impl->autoMap )
+            _impl->mapEntries( added );
         return;
     }
 
     if( dirtyBits & DIRTY_ADDED )
     {
-        IDVector added;
         is >> added;
 
         for( IDVectorCIter i = added.begin(); i != added.end(); ++i )
@@ -254,6 +348,10 @@ void ObjectMap::deserialize( DataIStream& is, const uint64_t dirtyBits )
                 entry.instance->sync( ov.version );
         }
     }
+
+    mutex.leave(); // mapping blocks on the master nodes
+    if( _impl->autoMap && !added.empty( ))
+        _impl->mapEntries( added );
 }
 
 void ObjectMap::notifyAttached()
@@ -373,4 +471,14 @@ void ObjectMap::clear()
     _impl->clear();
 }
 
+void ObjectMap::setAutoMap( const bool autoMap )
+{
+    _impl->autoMap = autoMap;
+}
+
+bool ObjectMap::isAutoMap() const
+{
+    return _impl->autoMap;
+}
+
 }
@@ -117,6 +117,24 @@ public:
     /** Deregister or unmap all registered and mapped objects. @version 1.0 */
     CO_API void clear();
 
+    /**
+     * Enable or disable automatic mapping of new entries on slave instances.
+     *
+     * When enabled, all objects added to the map are created using the object
+     * factory and mapped during sync(). The map requests for all new objects
+     * are issued at once and synchronized afterwards, so the time until a
+     * large commit is visible is dominated by the slowest object, not by the
+     * sum of all mapping latencies. Disabled by default, in which case objects
+     * are mapped lazily by map().
+     *
+     * @param autoMap true to map new entries automatically.
+     * @version 1.1
+     */
+    CO_API void setAutoMap( const bool autoMap );
+
+    /** @return true if new entries are mapped automatically. @version 1.1 */
+    CO_API bool isAutoMap() const;
+
     /** Commit all registered objects. @version 1.0 */
     CO_API virtual uint128_t commit( const uint32_t incarnation =
                                      CO_COMMIT_NEXT );
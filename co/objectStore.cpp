@@ -34,6 +34,7 @@
 #include "objectDataIStream.h"
 #include "objectDataICommand.h"
 #include "objectICommand.h"
+#include "objectVersion.h"
 
 #include <lunchbox/scopedMutex.h>
 
@@ -52,7 +53,8 @@ ObjectStore::ObjectStore( LocalNode* localNode )
         : _localNode( localNode )
         , _instanceIDs( -0x7FFFFFFF )
         , _instanceCache( new InstanceCache( Global::getIAttribute(
-                              Global::IATTR_INSTANCE_CACHE_SIZE ) * LB_1MB ) )
+                              Global::IATTR_INSTANCE_CACHE_SIZE ) * LB_1MB,
+                              Global::getInstanceCacheDirectory( )))
 {
     LBASSERT( localNode );
     CommandQueue* queue = localNode->getCommandThreadQueue();
@@ -61,6 +63,10 @@ ObjectStore::ObjectStore( LocalNode* localNode )
         CmdFunc( this, &ObjectStore::_cmdFindMasterNodeID ), queue );
     localNode->_registerCommand( CMD_NODE_FIND_MASTER_NODE_ID_REPLY,
         CmdFunc( this, &ObjectStore::_cmdFindMasterNodeIDReply ), 0 );
+    localNode->_registerCommand( CMD_NODE_FIND_MASTER_NODE_IDS,
+        CmdFunc( this, &ObjectStore::_cmdFindMasterNodeIDs ), queue );
+    localNode->_registerCommand( CMD_NODE_FIND_MASTER_NODE_IDS_REPLY,
+        CmdFunc( this, &ObjectStore::_cmdFindMasterNodeIDsReply ), 0 );
     localNode->_registerCommand( CMD_NODE_ATTACH_OBJECT,
         CmdFunc( this, &ObjectStore::_cmdAttachObject ), 0 );
     localNode->_registerCommand( CMD_NODE_DETACH_OBJECT,
@@ -71,6 +77,8 @@ ObjectStore::ObjectStore( LocalNode* localNode )
         CmdFunc( this, &ObjectStore::_cmdDeregisterObject ), queue );
     localNode->_registerCommand( CMD_NODE_MAP_OBJECT,
         CmdFunc( this, &ObjectStore::_cmdMapObject ), queue );
+    localNode->_registerCommand( CMD_NODE_MAP_OBJECTS,
+        CmdFunc( this, &ObjectStore::_cmdMapObjects ), queue );
     localNode->_registerCommand( CMD_NODE_MAP_OBJECT_SUCCESS,
         CmdFunc( this, &ObjectStore::_cmdMapObjectSuccess ), 0 );
     localNode->_registerCommand( CMD_NODE_MAP_OBJECT_REPLY,
@@ -184,9 +192,14 @@ NodeID ObjectStore::_findMasterNodeID( const UUID& identifier )
     // OPT: look up locally first?
     Nodes nodes;
     _localNode->getNodes( nodes );
+    return _findMasterNodeID( identifier, nodes );
+}
 
+NodeID ObjectStore::_findMasterNodeID( const UUID& identifier,
+                                       const Nodes& nodes )
+{
     // OPT: send to multiple nodes at once?
-    for( NodesIter i = nodes.begin(); i != nodes.end(); ++i )
+    for( NodesCIter i = nodes.begin(); i != nodes.end(); ++i )
     {
         NodePtr node = *i;
         const uint32_t requestID = _localNode->registerRequest();
@@ -209,6 +222,93 @@ NodeID ObjectStore::_findMasterNodeID( const UUID& identifier )
     return NodeID();
 }
 
+void ObjectStore::_findMasterNodeIDs( const ObjectVersions& versions,
+                                      NodeIDs& masterNodeIDs )
+{
+    LB_TS_NOT_THREAD( _commandThread );
+
+    masterNodeIDs.assign( versions.size(), NodeID( ));
+    if( versions.empty( ))
+        return;
+
+    Nodes nodes;
+    _localNode->getNodes( nodes );
+
+    std::vector< UUID > ids;
+    ids.reserve( versions.size( ));
+    for( ObjectVersionsCIter i = versions.begin(); i != versions.end(); ++i )
+        ids.push_back( i->identifier );
+
+    // ask all nodes at once, one request per node for all identifiers
+    Nodes batched;
+    Nodes others;
+    for( NodesCIter i = nodes.begin(); i != nodes.end(); ++i )
+    {
+        if( _hasBatchedMapping( *i ))
+            batched.push_back( *i );
+        else
+            others.push_back( *i );
+    }
+
+    std::vector< NodeIDs > replies( batched.size( ));
+    RequestIDs requestIDs( batched.size( ));
+    for( size_t i = 0; i < batched.size(); ++i )
+    {
+        requestIDs[i] = _localNode->registerRequest( &replies[i] );
+
+        LBLOG( LOG_OBJECTS ) << "Finding " << ids.size() << " objects on "
+                             << batched[i] << " req " << requestIDs[i]
+                             << std::endl;
+        batched[i]->send( CMD_NODE_FIND_MASTER_NODE_IDS )
+            << ids << requestIDs[i];
+    }
+
+    for( size_t i = 0; i < batched.size(); ++i )
+    {
+        _localNode->waitRequest( requestIDs[i] );
+
+        const NodeIDs& reply = replies[i];
+        LBASSERT( reply.size() == ids.size( ));
+        for( size_t j = 0; j < reply.size() && j < ids.size(); ++j )
+            if( masterNodeIDs[j] == 0 )
+                masterNodeIDs[j] = reply[j];
+    }
+
+    // older nodes only answer one identifier at a time
+    for( size_t j = 0; j < ids.size() && !others.empty(); ++j )
+        if( masterNodeIDs[j] == 0 )
+            masterNodeIDs[j] = _findMasterNodeID( ids[j], others );
+}
+
+bool ObjectStore::_hasBatchedMapping( NodePtr node )
+{
+    ConnectionPtr connection = node->getConnection();
+    return connection && connection->hasBatchedMapping();
+}
+
+NodeID ObjectStore::_getMasterNodeID( const UUID& id )
+{
+    lunchbox::ScopedFastRead mutex( _objects );
+    ObjectsHashCIter i = _objects->find( id );
+    if( i == _objects->end( ))
+        return NodeID();
+
+    const Objects& objects = i->second;
+    LBASSERT( !objects.empty( ));
+
+    for( ObjectsCIter j = objects.begin(); j != objects.end(); ++j )
+    {
+        Object* object = *j;
+        if( object->isMaster( ))
+            return _localNode->getNodeID();
+
+        NodePtr master = object->getMasterNode();
+        if( master.isValid( ) && master->getNodeID() != 0 )
+            return master->getNodeID();
+    }
+    return NodeID();
+}
+
 //---------------------------------------------------------------------------
 // object mapping
 //---------------------------------------------------------------------------
@@ -363,13 +463,31 @@ uint32_t ObjectStore::mapObjectNB( Object* object, const UUID& id,
     LBLOG( LOG_OBJECTS )
         << "Mapping " << lunchbox::className( object ) << " to id " << id
         << " version " << version << std::endl;
+    if( !_checkMapObject( object, id ))
+        return LB_UNDEFINED_UINT32;
+
+    if( !master || !master->isReachable( ))
+    {
+        LBWARN << "Mapping of object " << id << " failed, invalid master node"
+               << std::endl;
+        return LB_UNDEFINED_UINT32;
+    }
+
+    const uint32_t requestID = _localNode->registerRequest( object );
+    OCommand command( master->send( CMD_NODE_MAP_OBJECT ));
+    _writeMapObject( command, object, id, version, master, requestID );
+    return requestID;
+}
+
+bool ObjectStore::_checkMapObject( Object* object, const UUID& id ) const
+{
     LBASSERT( object );
     LBASSERTINFO( id.isGenerated(), id );
 
     if( !object || !id.isGenerated( ))
     {
         LBWARN << "Invalid object " << object << " or id " << id << std::endl;
-        return LB_UNDEFINED_UINT32;
+        return false;
     }
 
     const bool isAttached = object->isAttached();
@@ -380,17 +498,15 @@ uint32_t ObjectStore::mapObjectNB( Object* object, const UUID& id,
     {
         LBWARN << "Invalid object state: attached " << isAttached << " master "
                << isMaster << std::endl;
-        return LB_UNDEFINED_UINT32;
-    }
-
-    if( !master || !master->isReachable( ))
-    {
-        LBWARN << "Mapping of object " << id << " failed, invalid master node"
-               << std::endl;
-        return LB_UNDEFINED_UINT32;
+        return false;
     }
+    return true;
+}
 
-    const uint32_t requestID = _localNode->registerRequest( object );
+void ObjectStore::_writeMapObject( DataOStream& os, Object* object,
+                                   const UUID& id, const uint128_t& version,
+                                   NodePtr master, const uint32_t requestID )
+{
     uint128_t minCachedVersion = VERSION_HEAD;
     uint128_t maxCachedVersion = VERSION_NONE;
     uint32_t masterInstanceID = 0;
@@ -398,6 +514,9 @@ uint32_t ObjectStore::mapObjectNB( Object* object, const UUID& id,
 
     if( _instanceCache )
     {
+        // fill memory cache from disk tier, master validates instance&version
+        _instanceCache->restore( id, _localNode, master );
+
         const InstanceCache::Data& cached = (*_instanceCache)[ id ];
         if( cached != InstanceCache::Data::NONE )
         {
@@ -414,11 +533,9 @@ uint32_t ObjectStore::mapObjectNB( Object* object, const UUID& id,
     }
 
     object->notifyAttach();
-    master->send( CMD_NODE_MAP_OBJECT )
-        << version << minCachedVersion << maxCachedVersion << id
-        << object->getMaxVersions() << requestID << _genNextID( _instanceIDs )
-        << masterInstanceID << useCache;
-    return requestID;
+    os << version << minCachedVersion << maxCachedVersion << id
+       << object->getMaxVersions() << requestID << _genNextID( _instanceIDs )
+       << masterInstanceID << useCache;
 }
 
 bool ObjectStore::mapObjectSync( const uint32_t requestID )
@@ -443,6 +560,93 @@ bool ObjectStore::mapObjectSync( const uint32_t requestID )
     return mapped;
 }
 
+RequestIDs ObjectStore::mapObjectsNB( const Objects& objects,
+                                      const ObjectVersions& versions )
+{
+    LB_TS_NOT_THREAD( _commandThread );
+    LB_TS_NOT_THREAD( _receiverThread );
+    LBASSERT( objects.size() == versions.size( ));
+
+    const size_t nObjects = std::min( objects.size(), versions.size( ));
+    RequestIDs requestIDs( objects.size(), LB_UNDEFINED_UINT32 );
+
+    NodeIDs masterNodeIDs;
+    _findMasterNodeIDs( versions, masterNodeIDs );
+
+    // group map requests per master node
+    typedef stde::hash_map< lunchbox::uint128_t,
+                            std::vector< size_t > > MasterRequests;
+    MasterRequests masterRequests;
+
+    for( size_t i = 0; i < nObjects; ++i )
+    {
+        const UUID& id = versions[i].identifier;
+        if( !_checkMapObject( objects[i], id ))
+            continue;
+
+        if( masterNodeIDs[i] == 0 )
+        {
+            LBWARN << "Can't find master node for object id " << id
+                   << std::endl;
+            continue;
+        }
+        masterRequests[ masterNodeIDs[i] ].push_back( i );
+    }
+
+    for( MasterRequests::const_iterator i = masterRequests.begin();
+         i != masterRequests.end(); ++i )
+    {
+        NodePtr master = _localNode->connect( NodeID( i->first ));
+        if( !master || master->isClosed() || !master->isReachable( ))
+        {
+            LBWARN << "Can't connect master node with id " << i->first
+                   << " for " << i->second.size() << " objects" << std::endl;
+            continue;
+        }
+
+        const std::vector< size_t >& indices = i->second;
+        LBLOG( LOG_OBJECTS ) << "Mapping " << indices.size() << " objects from "
+                             << master << std::endl;
+
+        if( !_hasBatchedMapping( master )) // older master, map one by one
+        {
+            for( std::vector< size_t >::const_iterator j = indices.begin();
+                 j != indices.end(); ++j )
+            {
+                const ObjectVersion& ov = versions[ *j ];
+                requestIDs[ *j ] = mapObjectNB( objects[ *j ], ov.identifier,
+                                                ov.version, master );
+            }
+            continue;
+        }
+
+        OCommand command( master->send( CMD_NODE_MAP_OBJECTS ));
+        command << uint64_t( indices.size( ));
+
+        for( std::vector< size_t >::const_iterator j = indices.begin();
+             j != indices.end(); ++j )
+        {
+            Object* object = objects[ *j ];
+            const ObjectVersion& ov = versions[ *j ];
+            const uint32_t requestID = _localNode->registerRequest( object );
+
+            _writeMapObject( command, object, ov.identifier, ov.version,
+                             master, requestID );
+            requestIDs[ *j ] = requestID;
+        }
+    }
+    return requestIDs;
+}
+
+bool ObjectStore::mapObjectsSync( const RequestIDs& requestIDs )
+{
+    bool mapped = true;
+    for( RequestIDsCIter i = requestIDs.begin(); i != requestIDs.end(); ++i )
+        if( !mapObjectSync( *i ))
+            mapped = false;
+    return mapped;
+}
+
 void ObjectStore::unmapObject( Object* object )
 {
     LBASSERT( object );
@@ -639,33 +843,7 @@ bool ObjectStore::_cmdFindMasterNodeID( ICommand& command )
     const uint32_t requestID = command.get< uint32_t >();
     LBASSERT( id.isGenerated() );
 
-    NodeID masterNodeID;
-    {
-        lunchbox::ScopedFastRead mutex( _objects );
-        ObjectsHashCIter i = _objects->find( id );
-
-        if( i != _objects->end( ))
-        {
-            const Objects& objects = i->second;
-            LBASSERT( !objects.empty( ));
-
-            for( ObjectsCIter j = objects.begin(); j != objects.end(); ++j )
-            {
-                Object* object = *j;
-                if( object->isMaster( ))
-                    masterNodeID = _localNode->getNodeID();
-                else
-                {
-                    NodePtr master = object->getMasterNode();
-                    if( master.isValid( ))
-                        masterNodeID = master->getNodeID();
-                }
-                if( masterNodeID != 0 )
-                    break;
-            }
-        }
-    }
-
+    const NodeID masterNodeID = _getMasterNodeID( id );
     LBLOG( LOG_OBJECTS ) << "Object " << id << " master " << masterNodeID
                          << " req " << requestID << std::endl;
     command.getNode()->send( CMD_NODE_FIND_MASTER_NODE_ID_REPLY )
@@ -681,6 +859,42 @@ bool ObjectStore::_cmdFindMasterNodeIDReply( ICommand& command )
     return true;
 }
 
+bool ObjectStore::_cmdFindMasterNodeIDs( ICommand& command )
+{
+    LB_TS_THREAD( _commandThread );
+
+    std::vector< UUID > ids;
+    command >> ids;
+    const uint32_t requestID = command.get< uint32_t >();
+
+    NodeIDs masterNodeIDs;
+    masterNodeIDs.reserve( ids.size( ));
+    for( std::vector< UUID >::const_iterator i = ids.begin(); i != ids.end();
+         ++i )
+    {
+        LBASSERT( i->isGenerated( ));
+        masterNodeIDs.push_back( _getMasterNodeID( *i ));
+    }
+
+    LBLOG( LOG_OBJECTS ) << "Resolved master of " << ids.size() << " objects"
+                         << " req " << requestID << std::endl;
+    command.getNode()->send( CMD_NODE_FIND_MASTER_NODE_IDS_REPLY )
+            << requestID << masterNodeIDs;
+    return true;
+}
+
+bool ObjectStore::_cmdFindMasterNodeIDsReply( ICommand& command )
+{
+    const uint32_t requestID = command.get< uint32_t >();
+    NodeIDs* masterNodeIDs = static_cast< NodeIDs* >(
+                                 _localNode->getRequestData( requestID ));
+    LBASSERT( masterNodeIDs );
+
+    command >> *masterNodeIDs;
+    _localNode->serveRequest( requestID );
+    return true;
+}
+
 bool ObjectStore::_cmdAttachObject( ICommand& command )
 {
     LB_TS_THREAD( _receiverThread );
@@ -781,6 +995,28 @@ bool ObjectStore::_cmdMapObject( ICommand& cmd )
     LB_TS_THREAD( _commandThread );
 
     MasterCMCommand command( cmd );
+    _mapObject( command );
+    return true;
+}
+
+bool ObjectStore::_cmdMapObjects( ICommand& cmd )
+{
+    LB_TS_THREAD( _commandThread );
+
+    const uint64_t nObjects = cmd.get< uint64_t >();
+    LBLOG( LOG_OBJECTS ) << "Cmd map " << nObjects << " objects " << cmd
+                         << std::endl;
+
+    // each entry is handled as a single map request, replies are pipelined
+    ICommand entry( cmd );
+    entry.setCommand( CMD_NODE_MAP_OBJECT );
+    for( uint64_t i = 0; i < nObjects; ++i )
+        _mapObject( MasterCMCommand( entry, cmd ));
+    return true;
+}
+
+void ObjectStore::_mapObject( const MasterCMCommand& command )
+{
     const UUID& id = command.getObjectID();
 
     LBLOG( LOG_OBJECTS ) << "Cmd map object " << command << " id " << id << "."
@@ -817,7 +1053,6 @@ bool ObjectStore::_cmdMapObject( ICommand& cmd )
             << node->getNodeID() << id << command.getRequestedVersion()
             << command.getRequestID() << false << command.useCache() << false;
     }
-    return true;
 }
 
 bool ObjectStore::_cmdMapObjectSuccess( ICommand& command )
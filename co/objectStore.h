@@ -96,6 +96,13 @@ namespace co
         /** Finalize the mapping of a distributed object. */
         bool mapObjectSync( const uint32_t requestID );
 
+        /** Start mapping distributed objects, batched per master node. */
+        RequestIDs mapObjectsNB( const Objects& objects,
+                                 const ObjectVersions& versions );
+
+        /** Finalize the mapping of distributed objects. */
+        bool mapObjectsSync( const RequestIDs& requestIDs );
+
         /**
          * Unmap a mapped object.
          *
@@ -178,6 +185,7 @@ namespace co
         /** enableSendOnRegister() invocations. */
         lunchbox::a_int32_t _sendOnRegister;
 
+        typedef std::vector< NodeID > NodeIDs;
         typedef stde::hash_map< lunchbox::uint128_t, Objects > ObjectsHash;
         typedef ObjectsHash::const_iterator ObjectsHashCIter;
 
@@ -209,8 +217,30 @@ namespace co
          */
         NodeID _findMasterNodeID( const UUID& id );
 
+        /** @return the master node id found on one of the given nodes. */
+        NodeID _findMasterNodeID( const UUID& id, const Nodes& nodes );
+
+        /**
+         * Resolve the master node ids for multiple identifiers, using one
+         * request per connected node.
+         */
+        void _findMasterNodeIDs( const ObjectVersions& versions,
+                                 NodeIDs& masterNodeIDs );
+
+        /** @return true if the node handles the batched mapping commands. */
+        static bool _hasBatchedMapping( NodePtr node );
+
+        /** @return the master node id of a locally attached object. */
+        NodeID _getMasterNodeID( const UUID& id );
+
         NodePtr _connectMaster( const UUID& id );
 
+        bool _checkMapObject( Object* object, const UUID& id ) const;
+        void _writeMapObject( DataOStream& os, Object* object, const UUID& id,
+                              const uint128_t& version, NodePtr master,
+                              const uint32_t requestID );
+        void _mapObject( const MasterCMCommand& command );
+
         void _attachObject( Object* object, const UUID& id,
                             const uint32_t instanceID );
         void _detachObject( Object* object );
@@ -218,9 +248,12 @@ namespace co
         /** The command handler functions. */
         bool _cmdFindMasterNodeID( ICommand& command );
         bool _cmdFindMasterNodeIDReply( ICommand& command );
+        bool _cmdFindMasterNodeIDs( ICommand& command );
+        bool _cmdFindMasterNodeIDsReply( ICommand& command );
         bool _cmdAttachObject( ICommand& command );
         bool _cmdDetachObject( ICommand& command );
         bool _cmdMapObject( ICommand& command );
+        bool _cmdMapObjects( ICommand& command );
         bool _cmdMapObjectSuccess( ICommand& command );
         bool _cmdMapObjectReply( ICommand& command );
         bool _cmdUnmapObject( ICommand& command );
@@ -24,17 +24,112 @@
 #include "node.h"
 #ifdef _WIN32
 #  include "namedPipeConnection.h"
+#elif defined __linux__
+#  include "byteRing.h"
+#  include "exception.h"
+#  include "global.h"
 #endif
 
 #include <lunchbox/log.h>
 #include <lunchbox/thread.h>
 
 #include <errno.h>
+#ifdef __linux__
+#  include <poll.h>
+#  include <stdlib.h>
+#  include <string.h>
+#  include <sys/eventfd.h>
+#  include <unistd.h>
+#endif
 
 namespace co
 {
+#ifdef __linux__
+namespace
+{
+static const uint64_t _ringSize = 262144; //!< bytes per direction
+
+int _getTimeout()
+{
+    const uint32_t timeout = Global::getTimeout();
+    return timeout == LB_TIMEOUT_INDEFINITE ? -1 : int( timeout );
+}
+
+/** The memory and eventfds of both directions, shared by the siblings. */
+class Rings : public lunchbox::Referenced
+{
+public:
+    Rings() : _memory( 0 )
+    {
+        for( size_t i = 0; i < 4; ++i )
+            _fds[ i ] = -1;
+    }
+
+    virtual ~Rings()
+    {
+        for( size_t i = 0; i < 4; ++i )
+            if( _fds[ i ] >= 0 )
+                ::close( _fds[ i ] );
+        free( _memory );
+    }
+
+    bool init()
+    {
+        const size_t size = 2 * ( sizeof( ByteRing::State ) + _ringSize );
+        if( ::posix_memalign( &_memory, 64, size ) != 0 )
+        {
+            _memory = 0;
+            return false;
+        }
+
+        ByteRing::State* states = static_cast< ByteRing::State* >( _memory );
+        ::memset( states, 0, 2 * sizeof( ByteRing::State ));
+        ByteRing::init( states[ 0 ] );
+        ByteRing::init( states[ 1 ] );
+
+        for( size_t i = 0; i < 4; ++i )
+        {
+            _fds[ i ] = ::eventfd( 0, EFD_CLOEXEC | EFD_NONBLOCK );
+            if( _fds[ i ] < 0 )
+                return false;
+        }
+        return true;
+    }
+
+    /** Set up the rings of one sibling, the first one writes ring 0. */
+    void setup( ByteRing& in, ByteRing& out, const bool first )
+    {
+        ByteRing::State* states = static_cast< ByteRing::State* >( _memory );
+        uint8_t* data = reinterpret_cast< uint8_t* >( states + 2 );
+        const size_t i = first ? 0 : 1;
+        const size_t j = 1 - i;
+
+        out.setup( &states[ i ], data + i * _ringSize, _ringSize,
+                   _fds[ 2 * i ], _fds[ 2 * i + 1 ] );
+        in.setup( &states[ j ], data + j * _ringSize, _ringSize,
+                  _fds[ 2 * j ], _fds[ 2 * j + 1 ] );
+    }
+
+private:
+    void* _memory;
+    int _fds[ 4 ]; //!< the data and space eventfd of each ring
+};
+}
+
+struct PipeConnection::Private
+{
+    lunchbox::RefPtr< Rings > rings; //!< shared with the sibling
+    ByteRing in;
+    ByteRing out;
+};
+#endif
 
 PipeConnection::PipeConnection()
+#ifdef __linux__
+    : _private( new Private )
+#else
+    : _private( 0 )
+#endif
 {
     ConnectionDescriptionPtr description = _getDescription();
     description->type = CONNECTIONTYPE_PIPE;
@@ -44,6 +139,9 @@ PipeConnection::PipeConnection()
 PipeConnection::~PipeConnection()
 {
     _close();
+#ifdef __linux__
+    delete _private;
+#endif
 }
 
 //----------------------------------------------------------------------
@@ -149,7 +247,115 @@ int64_t PipeConnection::write( const void* buffer, const uint64_t bytes )
     return _namedPipe->write( buffer, bytes );
 }
 
-#else // !_WIN32
+#elif defined __linux__
+
+Connection::Notifier PipeConnection::getNotifier() const
+{
+    return isClosed() ? -1 : _private->in.getDataFD();
+}
+
+bool PipeConnection::_createPipes()
+{
+    lunchbox::RefPtr< Rings > rings = new Rings;
+    if( !rings->init( ))
+    {
+        LBERROR << "Could not create pipe: " << lunchbox::sysError
+                << std::endl;
+        return false;
+    }
+
+    _private->rings = rings;
+    _sibling->_private->rings = rings;
+    rings->setup( _private->in, _private->out, true );
+    rings->setup( _sibling->_private->in, _sibling->_private->out, false );
+    return true;
+}
+
+void PipeConnection::_close()
+{
+    if( isClosed( ))
+        return;
+
+    // The rings stay valid until destruction, the sibling might use them
+    _private->in.close();
+    _private->out.close();
+    _setState( STATE_CLOSED );
+    _sibling = 0;
+}
+
+void PipeConnection::readNB( void*, const uint64_t )
+{
+    /* NOP */
+}
+
+int64_t PipeConnection::readSync( void* buffer, const uint64_t bytes,
+                                  const bool )
+{
+    if( isClosed( ))
+        return -1;
+
+    ByteRing& ring = _private->in;
+    for( ;; )
+    {
+        const uint64_t size = ring.read( buffer, bytes );
+        if( size == ByteRing::CORRUPTED )
+        {
+            close();
+            return -1;
+        }
+        if( size > 0 )
+            return size;
+
+        if( ring.isClosed( ))
+        {
+            LBINFO << "Got EOF, closing " << getDescription()->toString()
+                   << std::endl;
+            close();
+            return -1;
+        }
+
+        pollfd fd = { ring.getDataFD(), POLLIN, 0 };
+        const int result = ::poll( &fd, 1, _getTimeout( ));
+        if( result == 0 )
+            throw Exception( Exception::TIMEOUT_READ );
+        if( result < 0 && errno != EINTR )
+        {
+            LBWARN << "Error during read: " << lunchbox::sysError << std::endl;
+            return -1;
+        }
+    }
+}
+
+int64_t PipeConnection::write( const void* buffer, const uint64_t bytes )
+{
+    if( !isConnected( ))
+        return -1;
+
+    ByteRing& ring = _private->out;
+    for( ;; )
+    {
+        if( ring.isClosed( ))
+            return -1;
+
+        const uint64_t size = ring.write( buffer, bytes );
+        if( size == ByteRing::CORRUPTED )
+            return -1;
+        if( size > 0 )
+            return size;
+
+        pollfd fd = { ring.getSpaceFD(), POLLIN, 0 };
+        const int result = ::poll( &fd, 1, _getTimeout( ));
+        if( result == 0 )
+            throw Exception( Exception::TIMEOUT_WRITE );
+        if( result < 0 && errno != EINTR )
+        {
+            LBWARN << "Write error: " << lunchbox::sysError << std::endl;
+            return -1;
+        }
+    }
+}
+
+#else // !_WIN32 && !__linux__
 
 bool PipeConnection::_createPipes()
 {
@@ -194,6 +400,6 @@ void PipeConnection::_close()
     _setState( STATE_CLOSED );
     _sibling = 0;
 }
-#endif // else _WIN32
+#endif
 
 }
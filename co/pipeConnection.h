@@ -22,6 +22,8 @@
 
 #ifdef _WIN32
 #  include <co/namedPipeConnection.h>
+#elif defined __linux__
+#  include <co/connection.h>
 #else
 #  include "fdConnection.h"
 #endif
@@ -40,10 +42,11 @@ namespace co
      *
      * The pipe connection is implemented using anonymous pipes, and can
      * therefore only be used between related threads. It consist of a pair of
-     * siblings representing the two endpoints.
+     * siblings representing the two endpoints. On Linux, each direction is a
+     * lock-free ring in memory, and an eventfd signals a waiting reader.
      */
     class PipeConnection
-#ifdef _WIN32
+#if defined _WIN32 || defined __linux__
         : public Connection
 #else
         : public FDConnection
@@ -58,7 +61,7 @@ namespace co
         virtual bool connect();
         virtual void close() { _close(); }
 
-#ifdef _WIN32
+#if defined _WIN32 || defined __linux__
         virtual Notifier getNotifier() const;
 #endif
 
@@ -68,7 +71,7 @@ namespace co
         virtual ConnectionPtr acceptSync() { return _sibling; }
 
     protected:
-#ifdef _WIN32
+#if defined _WIN32 || defined __linux__
         virtual void readNB( void* buffer, const uint64_t bytes );
         virtual int64_t readSync( void* buffer, const uint64_t bytes,
                                   const bool ignored );
@@ -84,7 +87,7 @@ namespace co
         LB_TS_VAR( _recvThread );
 #endif
         struct Private;
-        Private* _private; // placeholder for binary-compatible changes
+        Private* _private; // the rings on Linux
 
         bool _createPipes();
         void _close();
@@ -27,9 +27,12 @@ namespace co
     enum QueueCommand
     {
         CMD_QUEUE_GET_ITEM = CMD_OBJECT_CUSTOM, // 10
-        CMD_QUEUE_EMPTY,
+        CMD_QUEUE_EMPTY, //!< @deprecated replaced by an empty CMD_QUEUE_ITEMS
         CMD_QUEUE_ITEM,
-        CMD_QUEUE_CUSTOM = 15 //!< Commands for subclasses of queues start here
+        CMD_QUEUE_ITEMS, //!< a batch of CMD_QUEUE_ITEM commands
+        CMD_QUEUE_RECLAIM, //!< master asks a slave to return items
+        CMD_QUEUE_RETURN, //!< slave returns items
+        CMD_QUEUE_CUSTOM = 16 //!< Commands for subclasses of queues start here
     };
 }
 
@@ -29,21 +29,24 @@ namespace detail
 class QueueItem
 {
 public:
-    QueueItem( co::QueueMaster& queueMaster_ )
+    QueueItem( co::QueueMaster& queueMaster_, const uint32_t priority_ )
         : queueMaster( queueMaster_ )
+        , priority( priority_ )
     {}
 
     QueueItem( const QueueItem& rhs )
         : queueMaster( rhs.queueMaster )
+        , priority( rhs.priority )
     {}
 
     co::QueueMaster& queueMaster;
+    const uint32_t priority;
 };
 }
 
-QueueItem::QueueItem( QueueMaster& master )
+QueueItem::QueueItem( QueueMaster& master, const uint32_t priority )
     : DataOStream()
-    , _impl( new detail::QueueItem( master ))
+    , _impl( new detail::QueueItem( master, priority ))
 {
     enableSave();
     _enable();
@@ -64,4 +67,9 @@ QueueItem::~QueueItem()
     delete _impl;
 }
 
+uint32_t QueueItem::_getPriority() const
+{
+    return _impl->priority;
+}
+
 }
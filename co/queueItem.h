@@ -43,9 +43,11 @@ public:
 private:
     friend class QueueMaster;
 
-    QueueItem( QueueMaster& master );
+    QueueItem( QueueMaster& master, const uint32_t priority );
     QueueItem( const QueueItem& rhs );
 
+    uint32_t _getPriority() const;
+
     virtual void sendData( const void*, const uint64_t, const bool )
         { LBDONTCALL }
 
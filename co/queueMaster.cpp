@@ -22,12 +22,16 @@
 #include "queueMaster.h"
 
 #include "dataOStream.h"
+#include "global.h"
 #include "objectICommand.h"
 #include "objectOCommand.h"
 #include "queueCommand.h"
 #include "queueItem.h"
 
-#include <lunchbox/mtQueue.h>
+#include <lunchbox/atomic.h>
+#include <lunchbox/clock.h>
+#include <lunchbox/scopedMutex.h>
+#include <deque>
 
 namespace co
 {
@@ -38,22 +42,200 @@ namespace detail
 class ItemBuffer : public lunchbox::Bufferb, public lunchbox::Referenced
 {
 public:
-    ItemBuffer( lunchbox::Bufferb& from )
-        : lunchbox::Bufferb( from )
+    ItemBuffer()
+        : lunchbox::Bufferb()
         , lunchbox::Referenced()
+        , next( 0 )
     {}
 
+    /** Take over the data of the given buffer without copying it. */
+    ItemBuffer( lunchbox::Bufferb& from )
+        : lunchbox::Bufferb()
+        , lunchbox::Referenced()
+        , next( 0 )
+    {
+        swap( from );
+    }
+
+    ItemBuffer( const void* data, const uint64_t size )
+        : lunchbox::Bufferb()
+        , lunchbox::Referenced()
+        , next( 0 )
+    {
+        replace( data, size );
+    }
+
     ~ItemBuffer()
     {}
+
+    lunchbox::Atomic< ItemBuffer* > next; //!< the next item in an ItemList
 };
 
 typedef lunchbox::RefPtr< ItemBuffer > ItemBufferPtr;
+typedef std::vector< ItemBufferPtr > Items;
+
+/**
+ * An intrusive, unbounded multi-producer single-consumer FIFO.
+ *
+ * Producers link items with one compare-and-swap on the head, the consumer
+ * unlinks them from the tail without any atomic operation in the common case.
+ */
+class ItemList
+{
+public:
+    ItemList() : _head( &_stub ), _tail( &_stub ) {}
+
+    /** Append an item. Thread-safe, lock-free. */
+    void push( ItemBuffer* item )
+    {
+        item->next = 0;
+        ItemBuffer* previous;
+        do
+            previous = _head;
+        while( !_head.compareAndSwap( previous, item ));
+        previous->next = item;
+    }
+
+    /** @return the oldest item, or 0. Not thread-safe. */
+    ItemBuffer* pop()
+    {
+        ItemBuffer* tail = _tail;
+        ItemBuffer* next = tail->next;
+        if( tail == &_stub )
+        {
+            if( !next )
+                return 0;
+            _tail = next;
+            tail = next;
+            next = next->next;
+        }
+
+        if( next )
+        {
+            _tail = next;
+            return tail;
+        }
+
+        if( tail != _head )
+            return 0; // a producer has not yet linked its item
+
+        push( &_stub );
+        next = tail->next;
+        if( !next )
+            return 0;
+        _tail = next;
+        return tail;
+    }
+
+private:
+    ItemBuffer _stub;
+    lunchbox::Atomic< ItemBuffer* > _head;
+    ItemBuffer* _tail;
+};
+
+/** The items of a QueueMaster, one ItemList per priority. */
+class ItemQueue
+{
+public:
+    enum { N_PRIORITIES = 4 };
+
+    ~ItemQueue() { clear(); }
+
+    /** Enqueue an item. Thread-safe, lock-free. */
+    void push( ItemBuffer* item, const uint32_t priority )
+    {
+        item->ref( this ); // unref in _pop
+        _lists[ LB_MIN( priority, uint32_t( N_PRIORITIES - 1 )) ].push( item );
+    }
+
+    /** Put items back to be handed out before all others. */
+    void pushFront( const Items& items )
+    {
+        lunchbox::ScopedWrite mutex( _lock );
+        _returned.insert( _returned.begin(), items.begin(), items.end( ));
+    }
+
+    /** Dequeue up to n items, highest priority first. */
+    void tryPop( const size_t n, Items& items )
+    {
+        lunchbox::ScopedWrite mutex( _lock );
+        while( items.size() < n && !_returned.empty( ))
+        {
+            items.push_back( _returned.front( ));
+            _returned.pop_front();
+        }
+
+        for( int i = N_PRIORITIES - 1; i >= 0; --i )
+            while( items.size() < n && _pop( _lists[i], items ))
+                /* nop */ ;
+    }
+
+    void clear()
+    {
+        lunchbox::ScopedWrite mutex( _lock );
+        Items items;
+        _returned.clear();
+        for( size_t i = 0; i < N_PRIORITIES; ++i )
+            while( _pop( _lists[i], items ))
+                items.clear();
+    }
+
+private:
+    ItemList _lists[ N_PRIORITIES ];
+    std::deque< ItemBufferPtr > _returned;
+    lunchbox::Lock _lock; //!< serializes the consumers
+
+    bool _pop( ItemList& list, Items& items )
+    {
+        ItemBuffer* item = list.pop();
+        if( !item )
+            return false;
+        items.push_back( item );
+        item->unref( this ); // ref'd in push
+        return true;
+    }
+};
+
+/** A slave which received items, as seen by the master. */
+struct Slave
+{
+    Slave( NodePtr node_, const uint32_t instanceID_ )
+        : node( node_ ), instanceID( instanceID_ ), items( 0 )
+        , reclaiming( false ), reclaimed( 0 ), reclaimTime( 0 )
+    {}
+
+    NodePtr node;
+    uint32_t instanceID;
+    uint32_t items; //!< estimate of the items held by the slave
+    bool reclaiming; //!< waiting for the reply to CMD_QUEUE_RECLAIM
+    uint32_t reclaimed; //!< the number of items reclaimed
+    int64_t reclaimTime; //!< the time CMD_QUEUE_RECLAIM was sent
+};
+typedef std::vector< Slave > Slaves;
+typedef Slaves::iterator SlavesIter;
+
+/** An item request deferred until outstanding reclaims are answered. */
+struct Request
+{
+    Request( NodePtr node_, const uint32_t instanceID_, const uint32_t amount_,
+             const int32_t id_ )
+        : node( node_ ), instanceID( instanceID_ ), amount( amount_ )
+        , id( id_ )
+    {}
+
+    NodePtr node;
+    uint32_t instanceID;
+    uint32_t amount;
+    int32_t id;
+};
+typedef std::deque< Request > Requests;
 
 class QueueMaster : public co::Dispatcher
 {
 public:
     QueueMaster( const co::QueueMaster& parent )
         : co::Dispatcher()
+        , reclaims( 0 )
         , _parent( parent )
     {}
 
@@ -66,35 +248,266 @@ public:
         const uint32_t slaveInstanceID = command.get< uint32_t >();
         const int32_t requestID = command.get< int32_t >();
 
-        typedef std::vector< ItemBufferPtr > Items;
+        const NodePtr node = command.getNode();
+        _expireReclaims();
+
+        // a waiting slave repeats its request, see QueueSlave::pop()
+        if( _isPending( node, slaveInstanceID, requestID ))
+        {
+            _servePending();
+            return true;
+        }
+
         Items items;
         queue.tryPop( itemsRequested, items );
+        if( !items.empty( ))
+        {
+            _send( node, slaveInstanceID, requestID, items );
+            return true;
+        }
+
+        // An idle slave steals items prefetched by the others: reclaim some
+        // and answer once they have been returned.
+        pending.push_back( Request( node, slaveInstanceID, itemsRequested,
+                                    requestID ));
+        _servePending();
+        return true;
+    }
+
+    bool cmdReturn( co::ICommand& comd )
+    {
+        co::ObjectICommand command( comd );
+
+        const uint32_t slaveInstanceID = command.get< uint32_t >();
+        const bool detached = command.get< bool >();
+        const uint32_t nItems = command.get< uint32_t >();
 
-        Connections connections( 1, command.getNode()->getConnection( ));
-        for( Items::const_iterator i = items.begin(); i != items.end(); ++i )
+        Items items;
+        items.reserve( nItems );
+        for( uint32_t i = 0; i < nItems; ++i )
         {
-            co::ObjectOCommand cmd( connections, CMD_QUEUE_ITEM,
-                                    COMMANDTYPE_OBJECT, _parent.getID(),
-                                    slaveInstanceID );
+            const uint64_t size = command.get< uint64_t >();
+            const void* data = size ? command.getRemainingBuffer( size ) : 0;
+            items.push_back( new ItemBuffer( data, size ));
+        }
+        if( !items.empty( ))
+            queue.pushFront( items ); // returned items are the oldest
 
-            const ItemBufferPtr item = *i;
-            if( !item->isEmpty( ))
-                cmd << Array< const void >( item->getData(), item->getSize( ));
+        SlavesIter i = _findSlave( command.getNode(), slaveInstanceID );
+        if( i != slaves.end( ))
+        {
+            if( i->reclaiming )
+            {
+                LBASSERT( reclaims > 0 );
+                --reclaims;
+                i->reclaiming = false;
+
+                // less items than reclaimed means the slave has none left
+                i->items = ( nItems < i->reclaimed || nItems > i->items ) ?
+                               0 : i->items - nItems;
+            }
+            if( detached )
+                slaves.erase( i );
         }
 
-        if( itemsRequested > items.size( ))
-            co::ObjectOCommand( connections, CMD_QUEUE_EMPTY,
-                                COMMANDTYPE_OBJECT, command.getObjectID(),
-                                slaveInstanceID ) << requestID;
+        _expireReclaims();
+        _servePending();
         return true;
     }
 
-    typedef lunchbox::MTQueue< ItemBufferPtr > ItemQueue;
+    /** Forget the slaves of a disconnected node. */
+    void removeSlaves( NodePtr node )
+    {
+        for( SlavesIter i = slaves.begin(); i != slaves.end(); )
+        {
+            if( i->node != node )
+            {
+                ++i;
+                continue;
+            }
+            if( i->reclaiming )
+            {
+                LBASSERT( reclaims > 0 );
+                --reclaims;
+            }
+            i = slaves.erase( i );
+        }
+
+        for( Requests::iterator i = pending.begin(); i != pending.end(); )
+        {
+            if( i->node == node )
+                i = pending.erase( i );
+            else
+                ++i;
+        }
+        _servePending();
+    }
 
     ItemQueue queue;
+    Slaves slaves; //!< slaves which received items
+    Requests pending; //!< requests waiting for reclaimed items
+    uint32_t reclaims; //!< outstanding CMD_QUEUE_RECLAIM replies
 
 private:
     const co::QueueMaster& _parent;
+    lunchbox::Clock _clock;
+
+    SlavesIter _findSlave( NodePtr node, const uint32_t instanceID )
+    {
+        for( SlavesIter i = slaves.begin(); i != slaves.end(); ++i )
+            if( i->node == node && i->instanceID == instanceID )
+                return i;
+        return slaves.end();
+    }
+
+    bool _isPending( NodePtr node, const uint32_t instanceID,
+                     const int32_t requestID ) const
+    {
+        for( Requests::const_iterator i = pending.begin(); i != pending.end();
+             ++i )
+        {
+            if( i->node == node && i->instanceID == instanceID &&
+                i->id == requestID )
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Reclaim half of the items of the slave holding the most.
+     * @return true if items are reclaimed for the given requester.
+     */
+    bool _reclaim( NodePtr node, const uint32_t instanceID )
+    {
+        SlavesIter requester = _findSlave( node, instanceID );
+        if( requester != slaves.end( ))
+            requester->items = 0; // consumed all its items
+
+        SlavesIter slave = slaves.end();
+        for( SlavesIter i = slaves.begin(); i != slaves.end(); ++i )
+        {
+            if( i->items == 0 || i->reclaiming || !i->node->isReachable( ))
+                continue;
+            if( slave == slaves.end() || i->items > slave->items )
+                slave = i;
+        }
+        if( slave == slaves.end( ))
+            return false;
+
+        slave->reclaiming = true;
+        slave->reclaimed = ( slave->items + 1 ) / 2;
+        slave->reclaimTime = _clock.getTime64();
+        ++reclaims;
+
+        Connections connections( 1, slave->node->getConnection( ));
+        co::ObjectOCommand( connections, CMD_QUEUE_RECLAIM,
+                            COMMANDTYPE_OBJECT, _parent.getID(),
+                            slave->instanceID ) << slave->reclaimed;
+        return true;
+    }
+
+    /** Give up on reclaims not answered within the keepalive timeout. */
+    void _expireReclaims()
+    {
+        if( reclaims == 0 )
+            return;
+
+        const int64_t time = _clock.getTime64() -
+                             int64_t( Global::getKeepaliveTimeout( ));
+        for( SlavesIter i = slaves.begin(); i != slaves.end(); ++i )
+        {
+            if( !i->reclaiming ||
+                ( i->reclaimTime > time && i->node->isReachable( )))
+            {
+                continue;
+            }
+
+            LBINFO << "Queue slave " << i->node << " did not return reclaimed "
+                   << "items in time" << std::endl;
+            LBASSERT( reclaims > 0 );
+            --reclaims;
+            i->reclaiming = false;
+            i->items = 0; // don't reclaim again from an unresponsive slave
+        }
+    }
+
+    /** Answer deferred requests, reclaiming items for them when needed. */
+    void _servePending()
+    {
+        while( !pending.empty( ))
+        {
+            const Request& request = pending.front();
+            Items items;
+            queue.tryPop( request.amount, items );
+            if( items.empty() &&
+                ( reclaims > 0 || _reclaim( request.node, request.instanceID )))
+            {
+                return; // wait for the reclaimed items
+            }
+
+            _send( request.node, request.instanceID, request.id, items );
+            pending.pop_front();
+        }
+    }
+
+    void _send( NodePtr node, const uint32_t slaveInstanceID,
+                const int32_t requestID, const Items& items )
+    {
+        if( !items.empty( ))
+        {
+            SlavesIter slave = _findSlave( node, slaveInstanceID );
+            if( slave == slaves.end( ))
+            {
+                slaves.push_back( Slave( node, slaveInstanceID ));
+                slave = slaves.end() - 1;
+            }
+            slave->items += uint32_t( items.size( ));
+        }
+
+        // Items are sent as complete CMD_QUEUE_ITEM commands, packed into as
+        // few CMD_QUEUE_ITEMS batches as the byte budget allows. The last
+        // batch completes the request, a batch without items signals an empty
+        // queue to the requesting slave.
+        static const uint64_t headerSize = sizeof( uint64_t ) +
+                                           2 * sizeof( uint32_t ) +
+                                           sizeof( UUID ) + sizeof( uint32_t );
+        const uint64_t budget =
+            Global::getIAttribute( Global::IATTR_QUEUE_BATCH_SIZE );
+
+        Connections connections( 1, node->getConnection( ));
+        Items::const_iterator i = items.begin();
+        do
+        {
+            Items::const_iterator end = i;
+            for( uint64_t size = 0; end != items.end(); ++end )
+            {
+                size += headerSize + (*end)->getSize();
+                if( size > budget && end != i )
+                    break;
+            }
+
+            co::ObjectOCommand batch( connections, CMD_QUEUE_ITEMS,
+                                      COMMANDTYPE_OBJECT, _parent.getID(),
+                                      slaveInstanceID );
+            batch << requestID << uint32_t( end - i )
+                  << bool( end == items.end( ));
+
+            for( ; i != end; ++i )
+            {
+                const ItemBufferPtr item = *i;
+                batch << uint64_t( headerSize + item->getSize( ))
+                      << uint32_t( COMMANDTYPE_OBJECT )
+                      << uint32_t( CMD_QUEUE_ITEM ) << _parent.getID()
+                      << slaveInstanceID;
+                if( !item->isEmpty( ))
+                    batch << Array< const void >( item->getData(),
+                                                  item->getSize( ));
+            }
+        }
+        while( i != items.end( ));
+    }
 };
 }
 
@@ -120,6 +533,15 @@ void QueueMaster::attach( const UUID& id, const uint32_t instanceID )
     registerCommand( CMD_QUEUE_GET_ITEM,
                      CommandFunc< detail::QueueMaster >(
                          _impl, &detail::QueueMaster::cmdGetItem ), queue );
+    registerCommand( CMD_QUEUE_RETURN,
+                     CommandFunc< detail::QueueMaster >(
+                         _impl, &detail::QueueMaster::cmdReturn ), queue );
+}
+
+void QueueMaster::removeSlaves( NodePtr node )
+{
+    Object::removeSlaves( node );
+    _impl->removeSlaves( node );
 }
 
 void QueueMaster::clear()
@@ -134,13 +556,18 @@ void QueueMaster::getInstanceData( co::DataOStream& os )
 
 QueueItem QueueMaster::push()
 {
-    return QueueItem( *this );
+    return QueueItem( *this, 0 );
+}
+
+QueueItem QueueMaster::push( const uint32_t priority )
+{
+    return QueueItem( *this, priority );
 }
 
 void QueueMaster::_addItem( QueueItem& item )
 {
-    detail::ItemBufferPtr newBuffer = new detail::ItemBuffer( item.getBuffer());
-    _impl->queue.push( newBuffer );
+    _impl->queue.push( new detail::ItemBuffer( item.getBuffer( )),
+                       item._getPriority( ));
 }
 
 } // co
@@ -57,6 +57,20 @@ public:
      */
     CO_API QueueItem push();
 
+    /**
+     * Enqueue a new queue item with the given priority.
+     *
+     * Items of a higher priority are handed out before items of a lower
+     * priority, items of the same priority in the order they were enqueued.
+     * Priorities range from 0 (the default) to 3, higher values are clamped.
+     * Items may be enqueued concurrently from multiple threads.
+     *
+     * @param priority the priority of the item.
+     * @return the item to enqueue.
+     * @version 1.1
+     */
+    CO_API QueueItem push( const uint32_t priority );
+
     /** Remove all enqueued items. @version 1.0 */
     CO_API void clear();
 
@@ -64,6 +78,7 @@ private:
     detail::QueueMaster* const _impl;
 
     CO_API virtual void attach( const UUID& id, const uint32_t instanceID );
+    virtual void removeSlaves( NodePtr node );
 
     virtual ChangeType getChangeType() const { return STATIC; }
     virtual void getInstanceData( co::DataOStream& os );
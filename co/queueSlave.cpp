@@ -22,43 +22,219 @@
 #include "queueSlave.h"
 
 #include "buffer.h"
-#include "commandQueue.h"
 #include "dataIStream.h"
 #include "global.h"
 #include "objectOCommand.h"
 #include "objectICommand.h"
 #include "queueCommand.h"
-#include "exception.h"
+
+#include <lunchbox/clock.h>
+#include <lunchbox/monitor.h>
+#include <lunchbox/scopedMutex.h>
+#include <deque>
 
 namespace co
 {
 namespace detail
 {
-class QueueSlave
+/** Upper limit for the adaptive refill amount. */
+static const uint32_t _maxPrefetchAmount = 4096;
+
+/** Object and batch header of a CMD_QUEUE_ITEMS command. */
+static const uint64_t _batchHeaderSize = sizeof( UUID ) + sizeof( uint32_t ) +
+                                         sizeof( int32_t ) + sizeof( uint32_t ) +
+                                         sizeof( bool );
+
+/** Command and object header of a CMD_QUEUE_ITEM command. */
+static const uint64_t _itemHeaderSize = sizeof( uint64_t ) +
+                                        2 * sizeof( uint32_t ) +
+                                        sizeof( UUID ) + sizeof( uint32_t );
+
+/** A received CMD_QUEUE_ITEMS command. */
+struct Batch
+{
+    Batch( const co::ICommand& command_, const uint32_t nItems_ )
+        : command( command_ ), nItems( nItems_ ) {}
+
+    co::ICommand command;
+    uint32_t nItems;
+};
+
+class QueueSlave : public co::Dispatcher
 {
 public:
-    QueueSlave( const uint32_t mark, const uint32_t amount)
-        : masterInstanceID( EQ_INSTANCE_ALL )
+    QueueSlave( const co::QueueSlave& parent_, const uint32_t mark,
+                const uint32_t amount )
+        : parent( parent_ )
+        , masterInstanceID( EQ_INSTANCE_ALL )
         , prefetchMark( mark == LB_UNDEFINED_UINT32 ?
                         Global::getIAttribute( Global::IATTR_QUEUE_MIN_SIZE ) :
                         mark )
         , prefetchAmount( amount == LB_UNDEFINED_UINT32 ?
                           Global::getIAttribute( Global::IATTR_QUEUE_REFILL ) :
                           amount )
+        , adaptive( mark == LB_UNDEFINED_UINT32 &&
+                    amount == LB_UNDEFINED_UINT32 )
+        , nItems( 0 )
+        , batchItems( 0 )
+        , events( 0 )
+        , request( 0 )
+        , emptyRequest( 0 )
+        , requestTime( 0.f )
+        , lastReturn( -1.f )
+        , popTime( 0.f )
+        , rtt( 0.f )
     {}
 
-    co::CommandQueue queue;
+    /** The command handler functions. */
+    bool cmdItems( co::ICommand& comd )
+    {
+        co::ObjectICommand command( comd );
+
+        const int32_t requestID = command.get< int32_t >();
+        const uint32_t nBatchItems = command.get< uint32_t >();
+        const bool last = command.get< bool >();
+
+        lunchbox::ScopedWrite mutex( lock );
+        if( last && requestID == request )
+            finishRequest();
+
+        if( nBatchItems > 0 )
+        {
+            batches.push_back( Batch( command, nBatchItems ));
+            nItems += nBatchItems;
+        }
+        else
+            emptyRequest = requestID;
+
+        ++events;
+        return true;
+    }
+
+    bool cmdReclaim( co::ICommand& comd )
+    {
+        co::ObjectICommand command( comd );
+        const uint32_t amount = command.get< uint32_t >();
+
+        lunchbox::ScopedWrite mutex( lock );
+        returnItems( false, amount );
+        return true;
+    }
+
+    /** Unpack the next item, sharing the buffer of its batch. */
+    co::ObjectICommand nextItem()
+    {
+        LBASSERT( nItems > 0 );
+        if( batchItems == 0 )
+        {
+            LBASSERT( !batches.empty( ));
+            const Batch& next = batches.front();
+            batch = next.command;
+            batch.getRemainingBuffer( _batchHeaderSize );
+            batchItems = next.nItems;
+            batches.pop_front();
+        }
+        --batchItems;
+        --nItems;
+
+        // all data of the batch is in one buffer, see ICommand::getNextBuffer
+        const uint64_t end = LB_MIN( batch.getBuffer()->getSize(),
+                                     batch.getOffset() + batch.getSize( ));
+        const uint64_t offset = end - batch.getRemainingBufferSize();
+        co::ObjectICommand item( co::ICommand( batch, offset ));
+        batch.getRemainingBuffer( item.getSize( ));
+        return item;
+    }
+
+    /** Send up to the given number of unconsumed items back to the master. */
+    void returnItems( const bool detached, const uint32_t amount )
+    {
+        Connections connections( 1, master->getConnection( ));
+        co::ObjectOCommand command( connections, CMD_QUEUE_RETURN,
+                                    COMMANDTYPE_OBJECT, parent.getID(),
+                                    masterInstanceID );
+        const uint32_t nReturned = LB_MIN( amount, nItems );
+        command << parent.getInstanceID() << detached << nReturned;
+
+        for( uint32_t i = 0; i < nReturned; ++i )
+        {
+            co::ObjectICommand item = nextItem();
+            const uint64_t size = item.getSize() - _itemHeaderSize;
+            command << size;
+            if( size > 0 )
+                command << Array< const void >(
+                    item.getRemainingBuffer( size ), size );
+        }
+    }
+
+    /** Sample the time the application spent on the last item. */
+    void startPop()
+    {
+        if( lastReturn < 0.f )
+            return;
+
+        const float time = clock.getTimef() - lastReturn;
+        popTime = popTime > 0.f ? ( 7.f * popTime + time ) * .125f : time;
+        lastReturn = -1.f;
+        adapt();
+    }
+
+    /** Sample the round-trip time of the completed outstanding request. */
+    void finishRequest()
+    {
+        const float time = clock.getTimef() - requestTime;
+        rtt = rtt > 0.f ? ( 7.f * rtt + time ) * .125f : time;
+        request = 0;
+        adapt();
+    }
+
+    /**
+     * Prefetch the items consumed during one round trip when reaching the
+     * mark, and refill for two round trips.
+     */
+    void adapt()
+    {
+        if( !adaptive || popTime <= 0.f || rtt <= 0.f )
+            return;
+
+        const float itemsPerRTT = rtt / popTime;
+        prefetchMark = uint32_t( LB_MIN( itemsPerRTT, _maxPrefetchAmount ));
+        prefetchAmount = uint32_t( LB_MIN( 2.f * itemsPerRTT + 1.f,
+                                           _maxPrefetchAmount ));
+    }
+
+    const co::QueueSlave& parent;
     NodePtr master;
     uint32_t masterInstanceID;
 
-    const uint32_t prefetchMark;
-    const uint32_t prefetchAmount;
+    uint32_t prefetchMark;
+    uint32_t prefetchAmount;
+    const bool adaptive; //!< adapt mark and amount to pop rate and RTT
+
+    /** Protects the local items against returning them during pop. */
+    lunchbox::Lock lock;
+    std::deque< Batch > batches; //!< received, not yet unpacked batches
+    uint32_t nItems; //!< the number of local items
+    co::ICommand batch; //!< the CMD_QUEUE_ITEMS currently unpacked
+    uint32_t batchItems; //!< the number of items left in batch
+    lunchbox::Monitor< uint32_t > events; //!< incremented on each batch
+
+    int32_t request; //!< the outstanding item request, 0 if none
+    int32_t emptyRequest; //!< the last request answered with no items
+    lunchbox::Clock clock;
+    float requestTime; //!< send time of the outstanding request
+    float lastReturn; //!< time the last item was returned, -1 if none
+    float popTime; //!< average application time per item
+    float rtt; //!< average round-trip time of an item request
 };
 }
 
 QueueSlave::QueueSlave( const uint32_t prefetchMark,
                         const uint32_t prefetchAmount )
-        : _impl( new detail::QueueSlave( prefetchMark, prefetchAmount ))
+#pragma warning(push)
+#pragma warning(disable: 4355)
+        : _impl( new detail::QueueSlave( *this, prefetchMark, prefetchAmount ))
+#pragma warning(pop)
 {}
 
 QueueSlave::~QueueSlave()
@@ -69,8 +245,24 @@ QueueSlave::~QueueSlave()
 void QueueSlave::attach( const UUID& id, const uint32_t instanceID )
 {
     Object::attach(id, instanceID);
-    registerCommand( CMD_QUEUE_ITEM, CommandFunc<Object>(0, 0), &_impl->queue );
-    registerCommand( CMD_QUEUE_EMPTY, CommandFunc<Object>(0, 0), &_impl->queue);
+
+    CommandQueue* queue = getLocalNode()->getCommandThreadQueue();
+    registerCommand( CMD_QUEUE_ITEMS,
+                     CommandFunc< detail::QueueSlave >(
+                         _impl, &detail::QueueSlave::cmdItems ), queue );
+    registerCommand( CMD_QUEUE_RECLAIM,
+                     CommandFunc< detail::QueueSlave >(
+                         _impl, &detail::QueueSlave::cmdReclaim ), queue );
+}
+
+void QueueSlave::notifyDetach()
+{
+    Object::notifyDetach();
+
+    // hand unconsumed items to the other slaves
+    lunchbox::ScopedWrite mutex( _impl->lock );
+    if( _impl->master && _impl->master->isReachable( ))
+        _impl->returnItems( true, _impl->nItems );
 }
 
 void QueueSlave::applyInstanceData( co::DataIStream& is )
@@ -87,39 +279,67 @@ void QueueSlave::applyInstanceData( co::DataIStream& is )
 ObjectICommand QueueSlave::pop( const uint32_t timeout )
 {
     static lunchbox::a_int32_t _request;
-    const int32_t request = ++_request;
+    int32_t request = 0; // the request sent by this pop, if any
+    bool first = true;
+    const float start = _impl->clock.getTimef();
+    const uint32_t interval = Global::getKeepaliveTimeout();
 
     while( true )
     {
-        const size_t queueSize = _impl->queue.getSize();
-        if( queueSize <= _impl->prefetchMark )
+        const uint32_t events = _impl->events.get();
         {
-            send( _impl->master, CMD_QUEUE_GET_ITEM, _impl->masterInstanceID )
+            lunchbox::ScopedWrite mutex( _impl->lock );
+            if( first )
+            {
+                _impl->startPop();
+                first = false;
+            }
+
+            // at most one outstanding request to not flood the master
+            if( _impl->request == 0 && _impl->nItems <= _impl->prefetchMark )
+            {
+                request = ++_request;
+                _impl->request = request;
+                _impl->requestTime = _impl->clock.getTimef();
+                send( _impl->master, CMD_QUEUE_GET_ITEM,
+                      _impl->masterInstanceID )
                     << _impl->prefetchAmount << getInstanceID() << request;
-        }
+            }
 
-        try
-        {
-            ObjectICommand cmd( _impl->queue.pop( timeout ));
-            switch( cmd.getCommand( ))
+            if( _impl->nItems > 0 )
             {
-            case CMD_QUEUE_ITEM:
-                return ObjectICommand( cmd );
-
-            default:
-                LBUNIMPLEMENTED;
-            case CMD_QUEUE_EMPTY:
-                if( cmd.get< int32_t >() == request )
-                    return ObjectICommand( 0, 0, 0, false );
-                // else left-over or not our empty command, discard and retry
-                break;
+                _impl->lastReturn = _impl->clock.getTimef();
+                return _impl->nextItem();
             }
+
+            // The queue is empty only if the master saw it after this pop
+            // started, otherwise wait for the reply to a new request.
+            if( request != 0 && _impl->emptyRequest == request )
+                return ObjectICommand( 0, 0, 0, false );
         }
-        catch (co::Exception& e)
+
+        uint32_t wait = interval;
+        if( timeout != LB_TIMEOUT_INDEFINITE )
         {
-            LBWARN << e.what() << std::endl;
-            return ObjectICommand( 0, 0, 0, false );
+            const float left = float( timeout ) -
+                               ( _impl->clock.getTimef() - start );
+            if( left <= 0.f )
+            {
+                LBWARN << "Timeout while waiting for queue items" << std::endl;
+                return ObjectICommand( 0, 0, 0, false );
+            }
+            wait = LB_MIN( wait, uint32_t( left ) + 1 );
         }
+
+        if( _impl->events.timedWaitNE( events, wait ))
+            continue;
+
+        // Repeat the unanswered request, which lets the master give up on
+        // items reclaimed from unresponsive slaves.
+        lunchbox::ScopedWrite mutex( _impl->lock );
+        if( _impl->request != 0 )
+            send( _impl->master, CMD_QUEUE_GET_ITEM, _impl->masterInstanceID )
+                << _impl->prefetchAmount << getInstanceID() << _impl->request;
     }
 }
 
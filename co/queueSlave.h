@@ -35,6 +35,10 @@ namespace detail { class QueueSlave; }
  *
  * One or more instances of this class are mapped to the identifier of the
  * QueueMaster registered on another node.
+ *
+ * When the master runs out of items, it reclaims half of the prefetched but not
+ * yet consumed items of the slave holding the most to hand them to the idle
+ * slave. Items left in a slave when it is unmapped are returned to the master.
  */
 class QueueSlave : public Object
 {
@@ -48,6 +52,12 @@ public:
      * hides the network latency by pipelining the network communication with
      * the processing, but introduces some imbalance between queue slaves.
      *
+     * If neither parameter is given, both are adapted continuously: the mark
+     * is set to the number of items consumed during one round-trip to the
+     * master, and the refill to twice this number. The Global defaults are
+     * used until the first measurements are available. At most one request is
+     * outstanding at any time.
+     *
      * @param prefetchMark the low-water mark for prefetching, or
      *                     LB_UNDEFINED_UINT32 to use the Global default.
      * @param prefetchAmount the refill quantity when prefetching, or
@@ -77,6 +87,7 @@ private:
     detail::QueueSlave* const _impl;
 
     CO_API virtual void attach( const UUID& id, const uint32_t instanceID );
+    CO_API virtual void notifyDetach();
 
     virtual ChangeType getChangeType() const { return STATIC; }
     virtual void getInstanceData( co::DataOStream& ) { LBDONTCALL }
@@ -32,12 +32,32 @@
 
 #include <boost/bind.hpp>
 
+#include <cmath>
+
 //#define EQ_INSTRUMENT_RSP
 #define EQ_RSP_MERGE_WRITES
 #define EQ_RSP_MAX_TIMEOUTS 1000
+#define EQ_RSP_MAX_BURST 64     // datagrams per send or receive system call
+#define EQ_RSP_MAX_GRO_BURST 8  // coalesced receive buffers with GRO
+#define EQ_RSP_MAX_GSO_SIZE 65000 // bytes per segmentation offload send
+#define EQ_RSP_MAX_FEC_GROUP 64 // datagrams per parity, bits in _parityMask
+#define EQ_RSP_MIN_REFERENCE 16 // datagrams of a write queued by reference
+#define EQ_RSP_MAX_WINDOW 65536 // datagrams in flight, see _getWindowSize
+#define EQ_RSP_MAX_LEGACY_WINDOW 16384 // unique 16 bit sequences in flight
+#define EQ_RSP_MAX_LEGACY_NACKS 300
+#define EQ_RSP_LEGACY_SHIFT 4 // header growth of a version 0 data datagram
+
+#ifdef __linux__
+#  define EQ_RSP_MMSG // batched datagram I/O using sendmmsg and recvmmsg
+#  include <errno.h>
+#  include <netinet/in.h>
+#  include <netinet/udp.h>
+#  include <sys/socket.h>
+#endif
 
 // Note: Do not use version > 255, endianness detection magic relies on this.
-const uint16_t EQ_RSP_PROTOCOL_VERSION = 0;
+const uint16_t EQ_RSP_PROTOCOL_VERSION = 1; // 32 bit sequences, selective acks
+const uint16_t EQ_RSP_LEGACY_VERSION = 0; // 16 bit sequences, still spoken
 
 using namespace boost::asio;
 
@@ -53,6 +73,8 @@ lunchbox::a_int32_t nBytesWritten;
 lunchbox::a_int32_t nDatagrams;
 lunchbox::a_int32_t nRepeated;
 lunchbox::a_int32_t nMergedDatagrams;
+lunchbox::a_int32_t nParities;
+lunchbox::a_int32_t nRecovered;
 lunchbox::a_int32_t nAckRequests;
 lunchbox::a_int32_t nAcksSend;
 lunchbox::a_int32_t nAcksSendTotal;
@@ -66,7 +88,138 @@ float writeWaitTime = 0.f;
 lunchbox::Clock instrumentClock;
 #endif
 
-static uint16_t _numBuffers = 0;
+static uint32_t _numBuffers = 0;
+
+template< class T > T _swapped( T value )
+{
+#ifdef COLLAGE_BIGENDIAN
+    lunchbox::byteswap( value );
+#endif
+    return value;
+}
+
+/** @return the 32 bit sequence nearest to reference with the given LSBs. */
+uint32_t _unwrap( const uint32_t reference, const uint16_t sequence )
+{
+    return reference + int16_t( sequence - uint16_t( reference ));
+}
+
+/** Version 0 ack request, see DatagramAckRequest */
+struct LegacyAckRequest
+{
+    uint16_t type;
+    uint16_t writerID;
+    uint16_t sequence;
+
+    void byteswap()
+    {
+#ifdef COLLAGE_BIGENDIAN
+        lunchbox::byteswap( type );
+        lunchbox::byteswap( writerID );
+        lunchbox::byteswap( sequence );
+#endif
+    }
+};
+
+/** Version 0 ack, see DatagramAck */
+struct LegacyAck
+{
+    uint16_t type;
+    uint16_t readerID;
+    uint16_t writerID;
+    uint16_t sequence;
+
+    void byteswap()
+    {
+#ifdef COLLAGE_BIGENDIAN
+        lunchbox::byteswap( type );
+        lunchbox::byteswap( readerID );
+        lunchbox::byteswap( writerID );
+        lunchbox::byteswap( sequence );
+#endif
+    }
+};
+
+/** Version 0 nack, see DatagramNack */
+struct LegacyNack
+{
+    uint16_t type;
+    uint16_t readerID;
+    uint16_t writerID;
+    uint16_t count;
+    struct { uint16_t start; uint16_t end; } nacks[ EQ_RSP_MAX_LEGACY_NACKS ];
+
+    void byteswap()
+    {
+#ifdef COLLAGE_BIGENDIAN
+        lunchbox::byteswap( type );
+        lunchbox::byteswap( readerID );
+        lunchbox::byteswap( writerID );
+        lunchbox::byteswap( count );
+        for( uint16_t i = 0; i < count; ++i )
+        {
+            lunchbox::byteswap( nacks[i].start );
+            lunchbox::byteswap( nacks[i].end );
+        }
+#endif
+    }
+};
+
+/** XOR the given bytes into the destination, a machine word at a time. */
+void _xor( uint8_t* to, const uint8_t* from, size_t size )
+{
+    for( ; size >= sizeof( uint64_t ); size -= sizeof( uint64_t ))
+    {
+        uint64_t word;
+        uint64_t other;
+        ::memcpy( &word, to, sizeof( word ));
+        ::memcpy( &other, from, sizeof( other ));
+        word ^= other;
+        ::memcpy( to, &word, sizeof( word ));
+        to += sizeof( uint64_t );
+        from += sizeof( uint64_t );
+    }
+    for( ; size > 0; --size )
+        *to++ ^= *from++;
+}
+
+int32_t _getFECGroupSize()
+{
+    const int32_t size =
+        Global::getIAttribute( Global::IATTR_RSP_FEC_GROUP_SIZE );
+    return LB_MAX( 0, LB_MIN( size, EQ_RSP_MAX_FEC_GROUP ));
+}
+
+/** @return the datagrams in flight needed to keep the link busy. */
+uint32_t _getWindowSize( const int64_t bandwidth, const int32_t mtu )
+{
+    // Lost datagrams are repaired after about two round trips. KB/s are
+    // treated as bytes/ms, see _refillBucket.
+    const int64_t rtt =
+        Global::getIAttribute( Global::IATTR_RSP_ROUND_TRIP_TIME );
+    const int64_t size = bandwidth * rtt * 2 / 1000 / LB_MAX( mtu, 1 );
+    const int64_t minSize =
+        Global::getIAttribute( Global::IATTR_RSP_NUM_BUFFERS );
+    return uint32_t( LB_MIN( LB_MAX( size, minSize ),
+                             int64_t( EQ_RSP_MAX_WINDOW )));
+}
+
+/**
+ * @return the TCP-friendly rate in KB/s for the given loss rate and
+ *         round-trip time in ms, see RFC 5348 and TFMCC (RFC 4654).
+ */
+int64_t _getFairRate( const float loss, const float rtt, const int32_t size )
+{
+    if( loss <= 0.f )
+        return std::numeric_limits< int64_t >::max();
+
+    // t_RTO = 4 R. KB/s are treated as bytes/ms, see _refillBucket.
+    const float r = LB_MAX( rtt, .01f );
+    const float time = r * std::sqrt( 2.f * loss / 3.f ) +
+                       12.f * r * std::sqrt( 3.f * loss / 8.f ) * loss *
+                       ( 1.f + 32.f * loss * loss );
+    return int64_t( float( size ) / time );
+}
 }
 
 RSPConnection::RSPConnection()
@@ -76,21 +229,52 @@ RSPConnection::RSPConnection()
     , _ackFreq( Global::getIAttribute( Global::IATTR_RSP_ACK_FREQUENCY ))
     , _payloadSize( _mtu - sizeof( DatagramData ))
     , _timeouts( 0 )
+    , _protocolVersion( EQ_RSP_PROTOCOL_VERSION )
+    , _wide( true )
     , _event( new EventConnection )
     , _read( 0 )
     , _write( 0 )
+    , _loopback( false )
+    , _mmsg( false )
+    , _gso( false )
+    , _gro( false )
     , _timeout( _ioService )
     , _wakeup( _ioService )
-    , _maxBucketSize( ( _mtu * _ackFreq) >> 1 )
+    , _maxBucketSize( _mtu * LB_MAX( 1, Global::getIAttribute(
+                                         Global::IATTR_RSP_BURST_SIZE )))
     , _bucketSize( 0 )
     , _sendRate( 0 )
+    , _pacingRate( -1 )
+    , _adaptTime( 0.f )
+    , _lossRate( 0.f )
+    , _rtt( 0.f )
+    , _fairRate( std::numeric_limits< int64_t >::max( ))
+    , _highest( 0 )
+    , _hasHighest( false )
     , _thread( 0 )
-    , _acked( std::numeric_limits< uint16_t >::max( ))
+    , _acked( std::numeric_limits< uint32_t >::max( ))
     , _threadBuffers( Global::getIAttribute( Global::IATTR_RSP_NUM_BUFFERS))
-    , _recvBuffer( _mtu )
+    , _recvBuffer( _mtu + EQ_RSP_LEGACY_SHIFT )
     , _readBuffer( 0 )
     , _readBufferPos( 0 )
     , _sequence( 0 )
+    , _parity( _mtu )
+    , _nParities( 0 )
+    , _paritySequence( 0 )
+    , _parityCount( 0 )
+    , _parityBytes( 0 )
+    , _parityMask( 0 )
+    , _parityActive( false )
+    , _fecMaxGroupSize( uint16_t( _getFECGroupSize( )))
+    , _fecGroupSize( _fecMaxGroupSize )
+    , _fecClean( 0 )
+    , _nRecovered( 0 )
+    , _dropInterval( 0 )
+    , _nDataDatagrams( 0 )
+    , _reference( 0 )
+    , _referenceEnd( 0 )
+    , _referenced( false )
+    , _referenceAborted( false )
     // ensure we have a handleConnectedTimeout before the write pop
     , _writeTimeOut( Global::IATTR_RSP_ACK_TIMEOUT * EQ_RSP_MAX_TIMEOUTS * 2 )
 {
@@ -101,14 +285,10 @@ RSPConnection::RSPConnection()
 
     LBCHECK( _event->connect( ));
 
-    _buffers.reserve( Global::getIAttribute( Global::IATTR_RSP_NUM_BUFFERS ));
-    while( static_cast< int32_t >( _buffers.size( )) <
-           Global::getIAttribute( Global::IATTR_RSP_NUM_BUFFERS ))
-    {
-        _buffers.push_back( new Buffer( _mtu ));
-    }
+    _resizeBuffers( Global::getIAttribute( Global::IATTR_RSP_NUM_BUFFERS ));
 
     LBASSERT( sizeof( DatagramNack ) <= size_t( _mtu ));
+    LBASSERT( sizeof( DatagramAck ) <= size_t( _mtu ));
     LBLOG( LOG_RSP ) << "New RSP connection, " << _buffers.size()
                      << " buffers of " << _mtu << " bytes" << std::endl;
 
@@ -175,7 +355,19 @@ void RSPConnection::_close()
     delete _write;
     _write = 0;
 
+    while( !_burstBuffers.empty( ))
+    {
+        delete _burstBuffers.back();
+        _burstBuffers.pop_back();
+    }
+    while( !_parityBuffers.empty( ))
+    {
+        delete _parityBuffers.back();
+        _parityBuffers.pop_back();
+    }
+
     _threadBuffers.clear();
+    _abortReference();
     _appBuffers.push( 0 ); // unlock any other read/write threads
 
     _setState( STATE_CLOSED );
@@ -203,7 +395,11 @@ bool RSPConnection::listen()
         return false;
 
     _setState( STATE_CONNECTING );
-    _numBuffers =  Global::getIAttribute( Global::IATTR_RSP_NUM_BUFFERS );
+
+    // The buffers limit the datagrams in flight, and the out-of-order
+    // datagrams buffered for each writer. Size them for the link.
+    _numBuffers = _getWindowSize( description->bandwidth, _mtu );
+    _resizeBuffers( _numBuffers );
 
     // init udp connection
     if( description->port == 0 )
@@ -267,9 +463,15 @@ bool RSPConnection::listen()
         _write->set_option( ip::multicast::outbound_interface( ifAddr.to_v4()));
 
         _write->connect( writeEndpoint );
-
-        _read->set_option( ip::multicast::enable_loopback( false ));
-        _write->set_option( ip::multicast::enable_loopback( false ));
+        _writeAddr = _write->local_endpoint();
+
+        // Loopback is used to run multiple members on one host. Our own
+        // datagrams are then filtered by their source address.
+        _loopback = Global::getIAttribute(
+                        Global::IATTR_RSP_MULTICAST_LOOPBACK ) != 0;
+        _read->set_option( ip::multicast::enable_loopback( _loopback ));
+        _write->set_option( ip::multicast::enable_loopback( _loopback ));
+        _initBatchIO();
     }
     catch( const boost::system::system_error& e )
     {
@@ -284,8 +486,15 @@ bool RSPConnection::listen()
 
     // init communication protocol thread
     _thread = new Thread( this );
+    _wide = _protocolVersion > EQ_RSP_LEGACY_VERSION;
     _bucketSize = 0;
     _sendRate = description->bandwidth;
+    _pacingRate = -1;
+    _sendTimes.assign( _buffers.size(), -1.f );
+    _adaptTime = _sendClock.getTimef();
+    _parityCount = 0;
+    _fecGroupSize = _fecMaxGroupSize;
+    _fecClean = 0;
 
     // waits until RSP protocol establishes connection to the multicast network
     if( !_thread->start( ) )
@@ -300,7 +509,8 @@ bool RSPConnection::listen()
 
     LBINFO << "Listening on " << description->getHostname() << ":"
            << description->port << " (" << description->toString() << " @"
-           << (void*)this << ")" << std::endl;
+           << (void*)this << "), " << _buffers.size() << " buffers, version "
+           << getProtocolVersion() << std::endl;
     return true;
 }
 
@@ -344,6 +554,8 @@ int64_t RSPConnection::readSync( void* buffer, const uint64_t bytes, const bool)
         if( !_readBuffer )
         {
             LBASSERT( _readBufferPos == 0 );
+            if( bytesLeft < bytes && _appBuffers.isEmpty( ))
+                break; // return the data available instead of waiting
             _readBuffer = _appBuffers.pop();
             if( !_readBuffer )
             {
@@ -392,9 +604,9 @@ int64_t RSPConnection::readSync( void* buffer, const uint64_t bytes, const bool)
     }
 
 #ifdef EQ_INSTRUMENT_RSP
-    nBytesRead += bytes;
+    nBytesRead += bytes - bytesLeft;
 #endif
-    return bytes;
+    return bytes - bytesLeft;
 }
 
 void RSPConnection::Thread::run()
@@ -429,7 +641,7 @@ void RSPConnection::_handleAcceptIDTimeout()
     {
         LBLOG( LOG_RSP ) << "Confirm " << _id << std::endl;
         _sendSimpleDatagram( ID_CONFIRM, _id );
-        _addConnection( _id );
+        _addConnection( _id, _protocolVersion );
         _idAccepted = true;
         _timeouts = 0;
         // send a first datagram to announce me and discover all other
@@ -461,10 +673,17 @@ void RSPConnection::_clearWriteQueues()
     {
         Buffer* buffer = 0;
         _threadBuffers.pop( buffer );
-        _writeBuffers.push_back( buffer );
+        const DatagramData* header =
+            reinterpret_cast< const DatagramData* >( buffer->getData( ));
+        if( header->type == REFERENCE )
+            _appBuffers.push( buffer );
+        else
+            _writeBuffers.push_back( buffer );
     }
+    _abortReference();
 
-    _finishWriteQueue( _sequence - 1 );
+    if( !_writeBuffers.empty( ))
+        _finishWriteQueue( _sequence - 1 );
     LBASSERT( _threadBuffers.isEmpty() && _writeBuffers.empty() );
 }
 
@@ -486,7 +705,8 @@ void RSPConnection::_handleConnectedTimeout()
         for( RSPConnectionsCIter i =_children.begin(); i !=_children.end(); ++i)
         {
             RSPConnectionPtr child = *i;
-            if ( child->_acked >= _sequence - _numBuffers && child->_id != _id )
+            if( uint32_t( _sequence - child->_acked ) <= _numBuffers &&
+                child->_id != _id )
             {
                 all = false;
                 break;
@@ -524,7 +744,7 @@ void RSPConnection::_handleConnectedTimeout()
             }
             else
             {
-                uint16_t wb = static_cast<uint16_t>( _writeBuffers.size( ));
+                uint32_t wb = static_cast<uint32_t>( _writeBuffers.size( ));
                 child->_acked = _sequence - wb;
                 ++i;
             }
@@ -537,20 +757,26 @@ void RSPConnection::_handleConnectedTimeout()
 RSPConnection::DatagramNode*
 RSPConnection::_getDatagramNode( const size_t bytes )
 {
-    if( bytes < sizeof( DatagramNode ))
+    // version 0 nodes do not send the maxVersion
+    const size_t minSize = sizeof( DatagramNode ) - sizeof( uint16_t );
+    if( bytes < minSize )
     {
         LBERROR << "DatagramNode size mismatch, got " << bytes << " instead of "
-                << sizeof( DatagramNode ) << " bytes" << std::endl;
+                << minSize << " bytes" << std::endl;
         //close();
         return 0;
     }
     DatagramNode& node =
                     *reinterpret_cast< DatagramNode* >( _recvBuffer.getData( ));
     node.byteswap();
-    if( node.protocolVersion != EQ_RSP_PROTOCOL_VERSION )
+    if( bytes < sizeof( DatagramNode ))
+        node.maxVersion = node.protocolVersion;
+
+    if( node.protocolVersion > EQ_RSP_PROTOCOL_VERSION )
     {
         LBERROR << "Protocol version mismatch, got " << node.protocolVersion
-                << " instead of " << EQ_RSP_PROTOCOL_VERSION << std::endl;
+                << " instead of " << EQ_RSP_LEGACY_VERSION << ".."
+                << EQ_RSP_PROTOCOL_VERSION << std::endl;
         //close();
         return 0;
     }
@@ -586,6 +812,14 @@ void RSPConnection::_setTimeout( const int32_t timeOut )
                                       placeholders::error ));
 }
 
+void RSPConnection::_setPacingTimeout( const int64_t delay )
+{
+    LBASSERT( delay > 0 );
+    _timeout.expires_from_now( boost::posix_time::microseconds( delay ));
+    _timeout.async_wait( boost::bind( &RSPConnection::_handleTimeout, this,
+                                      placeholders::error ));
+}
+
 void RSPConnection::_postWakeup()
 {
     _wakeup.expires_from_now( boost::posix_time::milliseconds( 0 ));
@@ -603,12 +837,23 @@ void RSPConnection::_processOutgoing()
     }
 #endif
 
-    if( !_repeatQueue.empty( ))
-        _repeatData();
-    else
-        _writeData();
+    if( _hasWriteData() || !_repeatQueue.empty( ))
+    {
+        // sleep until the send rate allows the next datagram
+        const int64_t delay = _getWriteDelay();
+        if( delay > 0 )
+        {
+            _setPacingTimeout( delay );
+            return;
+        }
 
-    if( !_threadBuffers.isEmpty() || !_repeatQueue.empty( ))
+        if( !_repeatQueue.empty( ))
+            _repeatData();
+        else
+            _writeData();
+    }
+
+    if( _hasWriteData() || !_repeatQueue.empty( ))
     {
         _setTimeout( 0 ); // call again to send remaining
         return;
@@ -643,64 +888,94 @@ void RSPConnection::_processOutgoing()
 void RSPConnection::_writeData()
 {
     Buffer* buffer = 0;
-    if( !_threadBuffers.pop( buffer )) // nothing to write
+    if( !_popWriteBuffer( buffer )) // nothing to write
         return;
 
     _timeouts = 0;
-    LBASSERT( buffer );
+    LBASSERT( _burst.empty( ));
+    while( true )
+    {
+        LBASSERT( buffer );
 
-    // write buffer
-    DatagramData* header = reinterpret_cast<DatagramData*>( buffer->getData( ));
-    header->sequence = _sequence++;
+        // write buffer
+        DatagramData* header =
+            reinterpret_cast<DatagramData*>( buffer->getData( ));
+        _sendTimes[ _sequence % _sendTimes.size() ] = _sendClock.getTimef();
+        header->setSequence( _sequence++ );
 
 #ifdef EQ_RSP_MERGE_WRITES
-    if( header->size < _payloadSize && !_threadBuffers.isEmpty( ))
-    {
-        std::vector< Buffer* > appBuffers;
-        while( header->size < _payloadSize && !_threadBuffers.isEmpty( ))
+        if( header->size < _payloadSize && !_threadBuffers.isEmpty( ))
         {
-            Buffer* buffer2 = 0;
-            LBCHECK( _threadBuffers.getFront( buffer2 ));
-            LBASSERT( buffer2 );
-            DatagramData* header2 =
-                reinterpret_cast<DatagramData*>( buffer2->getData( ));
-
-            if( uint32_t( header->size + header2->size ) > _payloadSize )
-                break;
+            std::vector< Buffer* > appBuffers;
+            while( header->size < _payloadSize && !_threadBuffers.isEmpty( ))
+            {
+                Buffer* buffer2 = 0;
+                LBCHECK( _threadBuffers.getFront( buffer2 ));
+                LBASSERT( buffer2 );
+                DatagramData* header2 =
+                    reinterpret_cast<DatagramData*>( buffer2->getData( ));
+
+                if( header2->type == REFERENCE ||
+                    uint32_t( header->size + header2->size ) > _payloadSize )
+                {
+                    break;
+                }
 
-            memcpy( reinterpret_cast<uint8_t*>( header + 1 ) + header->size,
-                    header2 + 1, header2->size );
-            header->size += header2->size;
-            LBCHECK( _threadBuffers.pop( buffer2 ));
-            appBuffers.push_back( buffer2 );
+                memcpy( reinterpret_cast<uint8_t*>( header + 1 ) + header->size,
+                        header2 + 1, header2->size );
+                header->size += header2->size;
+                LBCHECK( _threadBuffers.pop( buffer2 ));
+                appBuffers.push_back( buffer2 );
 #ifdef EQ_INSTRUMENT_RSP
-            ++nMergedDatagrams;
+                ++nMergedDatagrams;
 #endif
-        }
+            }
 
-        if( !appBuffers.empty( ))
-            _appBuffers.push( appBuffers );
-    }
+            if( !appBuffers.empty( ))
+                _appBuffers.push( appBuffers );
+        }
 #endif
 
-    // send data
-    //  Note 1: We could optimize the send away if we're all alone, but this is
-    //          not a use case for RSP, so we don't care.
-    //  Note 2: Data to myself will be 'written' in _finishWriteQueue once we
-    //          got all acks for the packet
-    const uint32_t size = header->size + sizeof( DatagramData );
+        // send data
+        //  Note 1: We could optimize the send away if we're all alone, but
+        //          this is not a use case for RSP, so we don't care.
+        //  Note 2: Data to myself will be 'written' in _finishWriteQueue once
+        //          we got all acks for the packet
+        const uint32_t size = header->size + sizeof( DatagramData );
 
-    _waitWritable( size ); // OPT: process incoming in between
-    header->byteswap();
-    _write->send( boost::asio::buffer( header, size ));
+        _consumeBucket( size );
+        if( _fecGroupSize > 0 && _wide )
+            _addParity( *header );
+        header->byteswap();
+        _addToBurst( header, size );
 
 #ifdef EQ_INSTRUMENT_RSP
-    ++nDatagrams;
-    nBytesWritten += header->size;
+        ++nDatagrams;
+        nBytesWritten += size - sizeof( DatagramData );
 #endif
 
-    // save datagram for repeats (and self)
-    _writeBuffers.push_back( buffer );
+        // save datagram for repeats (and self)
+        _writeBuffers.push_back( buffer );
+
+        if( _fecGroupSize > 0 && _wide && _parityCount >= _fecGroupSize )
+            _sendParity();
+
+        // Add the next datagram to the burst if the send rate allows to send
+        // it right away, otherwise send what we have. Leaves room for the
+        // parity of the last group.
+        if( _burst.size() + 1 >= EQ_RSP_MAX_BURST ||
+            _bucketSize < size_t( _mtu ) || !_popWriteBuffer( buffer ))
+        {
+            break;
+        }
+    }
+
+    // protect the tail of the data, the group continues otherwise
+    if( _parityCount > 1 && !_hasWriteData( ))
+        _sendParity();
+
+    _sendBurst();
+    _nParities = 0;
 
     if( _children.size() == 1 ) // We're all alone
     {
@@ -709,39 +984,230 @@ void RSPConnection::_writeData()
     }
 }
 
-void RSPConnection::_waitWritable( const uint64_t bytes )
+void RSPConnection::_addToBurst( DatagramData* header, const size_t size )
 {
-#ifdef EQ_INSTRUMENT_RSP
-    lunchbox::Clock clock;
-#endif
+    if( _wide )
+    {
+        _burst.push_back( boost::asio::const_buffer( header, size ));
+        return;
+    }
 
-    _bucketSize += static_cast< uint64_t >( _clock.resetTimef() * _sendRate );
-                                                     // opt omit: * 1024 / 1000;
-    _bucketSize = LB_MIN( _bucketSize, _maxBucketSize );
+    // send the version 0 header, the suffix of the current one
+    const uint8_t* legacy = reinterpret_cast< const uint8_t* >( header );
+    _burst.push_back( boost::asio::const_buffer( legacy + EQ_RSP_LEGACY_SHIFT,
+                                                 size - EQ_RSP_LEGACY_SHIFT ));
+}
 
-    const uint64_t size = LB_MIN( bytes, static_cast< uint64_t >( _mtu ));
-    while( _bucketSize < size )
+bool RSPConnection::_isWindowFull() const
+{
+    // version 0 sequences are only unique within half of their 16 bit space
+    return !_wide && _writeBuffers.size() >= EQ_RSP_MAX_LEGACY_WINDOW;
+}
+
+bool RSPConnection::_popWriteBuffer( Buffer*& buffer )
+{
+    if( _isWindowFull( ))
+        return false;
+
+    if( _reference ) // continue a large write using free write buffers
     {
-        lunchbox::Thread::yield();
-        float time = _clock.resetTimef();
+        if( !_appBuffers.tryPop( buffer ))
+            return false; // wait for acks to free buffers
+        _fillReference( buffer );
+        return true;
+    }
+
+    if( !_threadBuffers.pop( buffer ))
+        return false;
+
+    DatagramData* header = reinterpret_cast< DatagramData* >( buffer->getData( ));
+    if( header->type == REFERENCE ) // start of a large write
+    {
+        const uint8_t* range[ 2 ];
+        ::memcpy( range, header + 1, sizeof( range ));
+        _reference = range[ 0 ];
+        _referenceEnd = range[ 1 ];
+        _fillReference( buffer );
+    }
+    return true;
+}
+
+void RSPConnection::_fillReference( Buffer* buffer )
+{
+    LBASSERT( _reference && _reference < _referenceEnd );
+    const size_t size = LB_MIN( size_t( _referenceEnd - _reference ),
+                                size_t( _payloadSize ));
+
+    // The only copy of the data, which is needed for repeats and for the
+    // delivery to our own reader until all readers acked the datagram.
+    DatagramData* header = reinterpret_cast< DatagramData* >( buffer->getData( ));
+    header->set( _id, uint16_t( size ));
+    ::memcpy( header + 1, _reference, size );
+
+    _reference += size;
+    if( _reference < _referenceEnd )
+        return;
+
+    // the writer's memory is no longer used
+    _reference = 0;
+    _referenceEnd = 0;
+    _referenced = false;
+}
+
+void RSPConnection::_abortReference()
+{
+    if( _referenced == false )
+        return;
+
+    _reference = 0;
+    _referenceEnd = 0;
+    _referenceAborted = true;
+    _referenced = false;
+}
 
-        while( time == 0.f )
+void RSPConnection::_sendBurst()
+{
+#ifdef EQ_RSP_MMSG
+    if( _mmsg )
+    {
+        mmsghdr msgs[ EQ_RSP_MAX_BURST ];
+        iovec iovs[ EQ_RSP_MAX_BURST ];
+#  ifdef UDP_SEGMENT
+        union
         {
-            lunchbox::Thread::yield();
-            time = _clock.resetTimef();
+            char data[ CMSG_SPACE( sizeof( uint16_t )) ];
+            cmsghdr align;
+        } controls[ EQ_RSP_MAX_BURST ];
+#  endif
+
+        // One message per datagram, or per run of datagrams of the same size
+        // (but the last) which the kernel segments for us
+        size_t nMsgs = 0;
+        for( size_t i = 0; i < _burst.size(); ++nMsgs )
+        {
+            msghdr& msg = msgs[ nMsgs ].msg_hdr;
+            ::memset( &msg, 0, sizeof( msg ));
+            msg.msg_iov = &iovs[ i ];
+
+            const size_t segment = buffer_size( _burst[ i ]);
+            size_t bytes = 0;
+            do
+            {
+                iovs[ i ].iov_base = const_cast< void* >(
+                    buffer_cast< const void* >( _burst[ i ]));
+                iovs[ i ].iov_len = buffer_size( _burst[ i ]);
+                bytes += iovs[ i ].iov_len;
+                ++msg.msg_iovlen;
+                ++i;
+            }
+            while( _gso && i < _burst.size() &&
+                   iovs[ i - 1 ].iov_len == segment &&
+                   buffer_size( _burst[ i ]) <= segment &&
+                   bytes + buffer_size( _burst[ i ]) <= EQ_RSP_MAX_GSO_SIZE );
+
+#  ifdef UDP_SEGMENT
+            if( msg.msg_iovlen > 1 )
+            {
+                msg.msg_control = controls[ nMsgs ].data;
+                msg.msg_controllen = sizeof( controls[ nMsgs ].data );
+
+                cmsghdr* cmsg = CMSG_FIRSTHDR( &msg );
+                cmsg->cmsg_level = SOL_UDP;
+                cmsg->cmsg_type = UDP_SEGMENT;
+                cmsg->cmsg_len = CMSG_LEN( sizeof( uint16_t ));
+                const uint16_t gsoSize = uint16_t( segment );
+                ::memcpy( CMSG_DATA( cmsg ), &gsoSize, sizeof( gsoSize ));
+            }
+#  endif
         }
 
-        _bucketSize += static_cast< int64_t >( time * _sendRate );
-        _bucketSize = LB_MIN( _bucketSize, _maxBucketSize );
+        const int fd = _write->native_handle();
+        size_t sent = 0;
+        while( sent < nMsgs )
+        {
+            const int result = ::sendmmsg( fd, msgs + sent,
+                                           unsigned( nMsgs - sent ), 0 );
+            if( result > 0 )
+            {
+                sent += result;
+                continue;
+            }
+            if( errno == EINTR )
+                continue;
+
+            if( errno == ENOSYS )
+            {
+                LBINFO << "No sendmmsg support, using unbatched datagram I/O"
+                       << std::endl;
+                _mmsg = false;
+            }
+            else if( _gso && ( errno == EIO || errno == EINVAL ))
+            {
+                LBINFO << "UDP segmentation offload failed, disabling it: "
+                       << lunchbox::sysError << std::endl;
+                _gso = false;
+            }
+            else
+            {
+                // drop the remaining datagrams, they are repeated upon nack
+                LBWARN << "Datagram send failed: " << lunchbox::sysError
+                       << std::endl;
+                _burst.clear();
+                return;
+            }
+
+            // send the remaining datagrams one by one
+            for( ; sent < nMsgs; ++sent )
+            {
+                const msghdr& msg = msgs[ sent ].msg_hdr;
+                for( size_t i = 0; i < msg.msg_iovlen; ++i )
+                    _write->send( buffer( msg.msg_iov[ i ].iov_base,
+                                          msg.msg_iov[ i ].iov_len ));
+            }
+        }
+        _burst.clear();
+        return;
     }
-    _bucketSize -= size;
+#endif
+
+    for( size_t i = 0; i < _burst.size(); ++i )
+        _write->send( boost::asio::buffer( _burst[ i ] ));
+    _burst.clear();
+}
 
+void RSPConnection::_refillBucket()
+{
+    _bucketSize += static_cast< uint64_t >( _clock.resetTimef() * _sendRate );
+                                                     // opt omit: * 1024 / 1000;
+    _bucketSize = LB_MIN( _bucketSize, _maxBucketSize );
+}
+
+int64_t RSPConnection::_getWriteDelay()
+{
+    _refillBucket();
+    if( _bucketSize >= size_t( _mtu ))
+        return 0;
+
+    // KB/s are treated as bytes/ms, see _refillBucket
+    const int64_t missing = _mtu - int64_t( _bucketSize );
+    const int64_t delay = LB_MAX( missing * 1000 /
+                                  LB_MAX( _sendRate, int64_t( 1 )),
+                                  int64_t( 1 ));
 #ifdef EQ_INSTRUMENT_RSP
-    writeWaitTime += clock.getTimef();
+    writeWaitTime += float( delay ) * .001f;
 #endif
+    return delay;
+}
 
+void RSPConnection::_consumeBucket( const uint64_t bytes )
+{
+    const uint64_t size = LB_MIN( bytes, static_cast< uint64_t >( _mtu ));
+    LBASSERT( _bucketSize >= size );
+    _bucketSize -= size;
+
+    // Version 1 readers report their loss, see _adaptSendRate
     ConstConnectionDescriptionPtr description = getDescription();
-    if( _sendRate < description->bandwidth )
+    if( !_wide && _sendRate < description->bandwidth )
     {
         _sendRate += int64_t(
             float( Global::getIAttribute( Global::IATTR_RSP_ERROR_UPSCALE )) *
@@ -749,16 +1215,42 @@ void RSPConnection::_waitWritable( const uint64_t bytes )
         LBLOG( LOG_RSP ) << "speeding up to " << _sendRate << " KB/s"
                          << std::endl;
     }
+    _updatePacingRate();
+}
+
+void RSPConnection::_updatePacingRate()
+{
+#ifdef SO_MAX_PACING_RATE
+    // Let the kernel (fq qdisc) space out the datagrams of a burst. Only
+    // update it on larger changes, since the rate is adapted per datagram.
+    if( _pacingRate == 0 )
+        return;
+    const int64_t delta = _sendRate > _pacingRate ? _sendRate - _pacingRate :
+                                                    _pacingRate - _sendRate;
+    if( _pacingRate > 0 && delta * 16 < _pacingRate )
+        return;
+
+    const unsigned rate = unsigned( LB_MIN( _sendRate * 1024,
+                                            int64_t( 0xffffffffu )));
+    if( ::setsockopt( _write->native_handle(), SOL_SOCKET, SO_MAX_PACING_RATE,
+                      &rate, sizeof( rate )) == 0 )
+    {
+        _pacingRate = _sendRate;
+    }
+    else
+        _pacingRate = 0; // not supported, stop trying
+#endif
 }
 
 void RSPConnection::_repeatData()
 {
     _timeouts = 0;
+    LBASSERT( _burst.empty( ));
 
     while( !_repeatQueue.empty( ))
     {
         Nack& request = _repeatQueue.front();
-        const uint16_t distance = _sequence - request.start;
+        const uint32_t distance = _sequence - request.start;
         LBASSERT( distance != 0 );
 
         if( distance <= _writeBuffers.size( )) // not already acked
@@ -773,12 +1265,13 @@ void RSPConnection::_repeatData()
             DatagramData* header =
                 reinterpret_cast<DatagramData*>( buffer->getData( ));
             const uint32_t size = header->size + sizeof( DatagramData );
-            LBASSERT( header->sequence == request.start );
+            LBASSERT( header->getSequence() == request.start );
+            _sendTimes[ request.start % _sendTimes.size() ] = -1.f; // Karn
 
             // send data
-            _waitWritable( size ); // OPT: process incoming in between
+            _consumeBucket( size );
             // already done by _writeData: header->byteswap();
-            _write->send( boost::asio::buffer( header, size ) );
+            _addToBurst( header, size );
 #ifdef EQ_INSTRUMENT_RSP
             ++nRepeated;
 #endif
@@ -789,12 +1282,76 @@ void RSPConnection::_repeatData()
         else
             ++request.start;
 
-        if( distance <= _writeBuffers.size( )) // send something
-            return;
+        if( _burst.size() >= EQ_RSP_MAX_BURST || _bucketSize < size_t( _mtu ))
+            break;
     }
+
+    if( !_burst.empty( ))
+        _sendBurst();
+}
+
+void RSPConnection::_resetParity( const uint32_t sequence )
+{
+    ::memset( _parity.getData(), 0, _parity.getMaxSize( ));
+    _paritySequence = sequence;
+    _parityCount = 0;
+    _parityBytes = 0;
+    _parityMask = 0;
+}
+
+void RSPConnection::_addParity( const DatagramData& datagram )
+{
+    if( _parityCount == 0 )
+        _resetParity( datagram.getSequence( ));
+
+    DatagramParity* parity =
+        reinterpret_cast< DatagramParity* >( _parity.getData( ));
+    parity->size ^= datagram.size;
+    _xor( reinterpret_cast< uint8_t* >( parity + 1 ),
+          reinterpret_cast< const uint8_t* >( &datagram + 1 ), datagram.size );
+
+    _parityBytes = LB_MAX( _parityBytes, datagram.size );
+    ++_parityCount;
+    ++_fecClean;
 }
 
-void RSPConnection::_finishWriteQueue( const uint16_t sequence )
+void RSPConnection::_sendParity()
+{
+    LBASSERT( _parityCount > 0 );
+    if( _nParities == _parityBuffers.size( ))
+        _parityBuffers.push_back( new Buffer( _mtu ));
+
+    // the accumulated group is sent, the next one uses the spare buffer
+    Buffer* buffer = _parityBuffers[ _nParities++ ];
+    buffer->swap( _parity );
+
+    DatagramParity* parity =
+        reinterpret_cast< DatagramParity* >( buffer->getData( ));
+    parity->type = PARITY | WIDE;
+    parity->writerID = _id;
+    parity->sequence = _paritySequence;
+    parity->count = _parityCount;
+    parity->byteswap();
+
+    // The redundancy shares the send rate with the data. It is only sent if
+    // the data could be sent, so it may overdraw the bucket slightly.
+    const size_t size = sizeof( DatagramParity ) + _parityBytes;
+    _bucketSize -= LB_MIN( _bucketSize, size );
+    _burst.push_back( boost::asio::const_buffer( parity, size ));
+    _parityCount = 0;
+#ifdef EQ_INSTRUMENT_RSP
+    ++nParities;
+#endif
+
+    // use larger groups again while no losses are reported
+    if( _fecGroupSize < _fecMaxGroupSize && _fecClean >= _numBuffers )
+    {
+        ++_fecGroupSize;
+        _fecClean = 0;
+    }
+}
+
+void RSPConnection::_finishWriteQueue( const uint32_t sequence )
 {
     LBASSERT( !_writeBuffers.empty( ));
 
@@ -806,8 +1363,8 @@ void RSPConnection::_finishWriteQueue( const uint16_t sequence )
     Buffers readBuffers;
     Buffers freeBuffers;
 
-    const uint16_t size = _sequence - sequence - 1;
-    LBASSERTINFO( size <= uint16_t( _writeBuffers.size( )),
+    const uint32_t size = _sequence - sequence - 1;
+    LBASSERTINFO( size <= uint32_t( _writeBuffers.size( )),
                   size << " > " << _writeBuffers.size( ));
     LBLOG( LOG_RSP ) << "Got all remote acks for " << sequence << " current "
                      << _sequence << " advance " << _writeBuffers.size() - size
@@ -823,10 +1380,10 @@ void RSPConnection::_finishWriteQueue( const uint16_t sequence )
                          reinterpret_cast< DatagramData* >( buffer->getData( ));
         datagram->byteswap();
         LBASSERT( datagram->writerID == _id );
-        LBASSERTINFO( datagram->sequence ==
-                      uint16_t( connection->_sequence + readBuffers.size( )),
-                      datagram->sequence << ", " << connection->_sequence <<
-                      ", " << readBuffers.size( ));
+        LBASSERTINFO( datagram->getSequence() ==
+                      uint32_t( connection->_sequence + readBuffers.size( )),
+                      datagram->getSequence() << ", " << connection->_sequence
+                      << ", " << readBuffers.size( ));
       //LBLOG( LOG_RSP ) << "self receive " << datagram->sequence << std::endl;
 #endif
 
@@ -839,7 +1396,7 @@ void RSPConnection::_finishWriteQueue( const uint16_t sequence )
                              << connection->_sequence << std::endl;
 
             connection->_appBuffers.push( readBuffers );
-            connection->_sequence += uint16_t( readBuffers.size( ));
+            connection->_sequence += uint32_t( readBuffers.size( ));
             readBuffers.clear();
             connection->_event->set();
         }
@@ -865,11 +1422,11 @@ void RSPConnection::_finishWriteQueue( const uint16_t sequence )
 #endif
 
         connection->_appBuffers.push( readBuffers );
-        connection->_sequence += uint16_t( readBuffers.size( ));
+        connection->_sequence += uint32_t( readBuffers.size( ));
         connection->_event->set();
     }
 
-    connection->_acked = uint16_t( connection->_sequence - 1 );
+    connection->_acked = connection->_sequence - 1;
     LBASSERT( connection->_acked == sequence );
 
     _timeouts = 0;
@@ -878,27 +1435,144 @@ void RSPConnection::_finishWriteQueue( const uint16_t sequence )
 void RSPConnection::_handlePacket( const boost::system::error_code& /* error */,
                                    const size_t bytes )
 {
+    if( !_handleDatagram( bytes ))
+        return;
+
+    if( isListening( ))
+        _processOutgoing();
+
+    //LBLOG( LOG_RSP ) << "_handlePacket timeout " << timeout << std::endl;
+    _asyncReceiveFrom();
+}
+
+bool RSPConnection::_handleDatagram( const size_t bytes )
+{
+    if( _loopback && _readAddr == _writeAddr ) // looped back own datagram
+        return true;
+
     if( isListening( ))
     {
         _handleConnectedData( bytes );
 
         if( isListening( ))
-            _processOutgoing();
-        else
-        {
-            _ioService.stop();
-            return;
-        }
+            return true;
+
+        _ioService.stop();
+        return false;
     }
-    else if( bytes >= sizeof( DatagramNode ))
+
+    if( bytes >= sizeof( DatagramNode ) - sizeof( uint16_t ))
     {
         if( _idAccepted )
             _handleInitData( bytes, false );
         else
             _handleAcceptIDData( bytes );
     }
+    return true;
+}
 
-    //LBLOG( LOG_RSP ) << "_handlePacket timeout " << timeout << std::endl;
+void RSPConnection::_handleReadable( const boost::system::error_code& error )
+{
+#ifdef EQ_RSP_MMSG
+    const size_t nBuffers = _burstBuffers.size();
+    mmsghdr msgs[ EQ_RSP_MAX_BURST ];
+    iovec iovs[ EQ_RSP_MAX_BURST ];
+    sockaddr_in addrs[ EQ_RSP_MAX_BURST ];
+#  ifdef UDP_GRO
+    union
+    {
+        char data[ CMSG_SPACE( sizeof( int )) ];
+        cmsghdr align;
+    } controls[ EQ_RSP_MAX_BURST ];
+#  endif
+
+    // The socket is edge-triggered, drain it before waiting again
+    size_t nMsgs = nBuffers;
+    while( _mmsg && nMsgs == nBuffers )
+    {
+        ::memset( msgs, 0, nBuffers * sizeof( mmsghdr ));
+        for( size_t i = 0; i < nBuffers; ++i )
+        {
+            iovs[ i ].iov_base = _burstBuffers[ i ]->getData();
+            iovs[ i ].iov_len = _burstBuffers[ i ]->getMaxSize();
+
+            msghdr& msg = msgs[ i ].msg_hdr;
+            msg.msg_name = &addrs[ i ];
+            msg.msg_namelen = sizeof( sockaddr_in );
+            msg.msg_iov = &iovs[ i ];
+            msg.msg_iovlen = 1;
+#  ifdef UDP_GRO
+            msg.msg_control = controls[ i ].data;
+            msg.msg_controllen = sizeof( controls[ i ].data );
+#  endif
+        }
+
+        const int result = ::recvmmsg( _read->native_handle(), msgs,
+                                       unsigned( nBuffers ), MSG_DONTWAIT, 0 );
+        if( result <= 0 )
+        {
+            if( result < 0 && errno == ENOSYS )
+            {
+                LBINFO << "No recvmmsg support, using unbatched datagram I/O"
+                       << std::endl;
+                _mmsg = false;
+#  ifdef UDP_GRO
+                const int off = 0;
+                ::setsockopt( _read->native_handle(), SOL_UDP, UDP_GRO, &off,
+                              sizeof( off ));
+                _gro = false;
+#  endif
+            }
+            break;
+        }
+
+        nMsgs = size_t( result );
+        for( size_t i = 0; i < nMsgs; ++i )
+        {
+            const msghdr& msg = msgs[ i ].msg_hdr;
+            const size_t bytes = msgs[ i ].msg_len;
+            if( msg.msg_flags & MSG_TRUNC ) // not from us, ignore
+                continue;
+
+            ::memcpy( _readAddr.data(), &addrs[ i ], sizeof( sockaddr_in ));
+            if( !_gro )
+            {
+                // hand the filled buffer to the protocol without copying it
+                _recvBuffer.swap( *_burstBuffers[ i ] );
+                if( !_handleDatagram( bytes ))
+                    return;
+                continue;
+            }
+
+#  ifdef UDP_GRO
+            // split datagrams coalesced by the kernel
+            int segment = int( bytes );
+            for( cmsghdr* cmsg = CMSG_FIRSTHDR( &msgs[ i ].msg_hdr ); cmsg;
+                 cmsg = CMSG_NXTHDR( &msgs[ i ].msg_hdr, cmsg ))
+            {
+                if( cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO )
+                    ::memcpy( &segment, CMSG_DATA( cmsg ), sizeof( segment ));
+            }
+
+            const uint8_t* data = _burstBuffers[ i ]->getData();
+            for( size_t offset = 0; offset < bytes && segment > 0;
+                 offset += size_t( segment ))
+            {
+                const size_t size = LB_MIN( size_t( segment ), bytes - offset );
+                if( size > size_t( _mtu )) // not from us, ignore
+                    break;
+
+                ::memcpy( _recvBuffer.getData(), data + offset, size );
+                if( !_handleDatagram( size ))
+                    return;
+            }
+#  endif
+        }
+
+        if( isListening( ))
+            _processOutgoing();
+    }
+#endif
     _asyncReceiveFrom();
 }
 
@@ -955,13 +1629,13 @@ void RSPConnection::_handleInitData( const size_t bytes, const bool connected )
         case ID_CONFIRM:
             if( !connected )
                 _timeouts = 0;
-            _addConnection( node.connectionID );
+            _addConnection( node.connectionID, node.maxVersion );
             return;
 
         case COUNTNODE:
             LBLOG( LOG_RSP ) << "Got " << node.numConnections << " nodes from "
                              << node.connectionID << std::endl;
-            _addConnection( node.connectionID );
+            _addConnection( node.connectionID, node.maxVersion );
             return;
 
         case ID_EXIT:
@@ -974,7 +1648,7 @@ void RSPConnection::_handleInitData( const size_t bytes, const bool connected )
     }
 }
 
-void RSPConnection::_handleConnectedData( const size_t bytes )
+void RSPConnection::_handleConnectedData( size_t bytes )
 {
     if( bytes < sizeof( uint16_t ))
         return;
@@ -984,9 +1658,18 @@ void RSPConnection::_handleConnectedData( const size_t bytes )
 #ifdef COLLAGE_BIGENDIAN
     lunchbox::byteswap( type );
 #endif
-    switch( type )
+    if( type <= ACK ) // version 0 datagram with a 16 bit sequence
+    {
+        bytes = _widenDatagram( type, bytes );
+        if( bytes == 0 )
+            return;
+    }
+
+    switch( type & ~WIDE )
     {
         case DATA:
+            if( _dropInterval > 0 && ++_nDataDatagrams % _dropInterval == 0 )
+                break; // simulated loss, for testing
             LBCHECK( _handleData( bytes ));
             break;
 
@@ -1002,6 +1685,10 @@ void RSPConnection::_handleConnectedData( const size_t bytes )
             LBCHECK( _handleAckRequest( bytes ));
             break;
 
+        case PARITY:
+            LBCHECK( _handleParity( bytes ));
+            break;
+
         case ID_HELLO:
         case ID_CONFIRM:
         case ID_EXIT:
@@ -1017,8 +1704,126 @@ void RSPConnection::_handleConnectedData( const size_t bytes )
 
 }
 
+size_t RSPConnection::_widenDatagram( const uint16_t type, const size_t bytes )
+{
+    // The 16 bit sequences are unwrapped around the expected (reader) or next
+    // (writer) sequence. Datagrams for other writers are not used.
+    uint8_t* data = _recvBuffer.getData();
+    switch( type )
+    {
+        case DATA:
+        {
+            if( bytes < sizeof( DatagramData ) - EQ_RSP_LEGACY_SHIFT )
+                return 0;
+
+            // the version 0 header is the suffix of the current one
+            ::memmove( data + EQ_RSP_LEGACY_SHIFT, data, bytes );
+            DatagramData& datagram = *reinterpret_cast< DatagramData* >( data );
+            RSPConnectionPtr connection =
+                _findConnection( _swapped( datagram.writerID ));
+            if( !connection )
+                return 0;
+
+            const uint32_t sequence = _unwrap( connection->_sequence,
+                                           _swapped( datagram.sequenceLow ));
+            datagram.type = _swapped( uint16_t( DATA | WIDE ));
+            datagram.sequenceHigh = _swapped( uint16_t( sequence >> 16 ));
+            return bytes + EQ_RSP_LEGACY_SHIFT;
+        }
+
+        case ACKREQ:
+        {
+            if( bytes < sizeof( LegacyAckRequest ))
+                return 0;
+
+            LegacyAckRequest legacy;
+            ::memcpy( &legacy, data, sizeof( legacy ));
+            legacy.byteswap();
+            RSPConnectionPtr connection = _findConnection( legacy.writerID );
+            if( !connection )
+                return 0;
+
+            DatagramAckRequest& request =
+                *reinterpret_cast< DatagramAckRequest* >( data );
+            request.type = ACKREQ | WIDE;
+            request.writerID = legacy.writerID;
+            request.sequence = _unwrap( connection->_sequence,
+                                        legacy.sequence );
+            request.byteswap();
+            return sizeof( DatagramAckRequest );
+        }
+
+        case ACK:
+        {
+            if( bytes < sizeof( LegacyAck ))
+                return 0;
+
+            LegacyAck legacy;
+            ::memcpy( &legacy, data, sizeof( legacy ));
+            legacy.byteswap();
+            if( legacy.writerID != _id )
+                return 0;
+
+            DatagramAck& ack = *reinterpret_cast< DatagramAck* >( data );
+            ack.set( legacy.readerID, legacy.writerID,
+                     _unwrap( _sequence, legacy.sequence ), 0 );
+            const size_t size = ack.getSize();
+            ack.byteswap();
+            return size;
+        }
+
+        case NACK:
+        {
+            LegacyNack legacy;
+            const size_t headerSize = sizeof( legacy ) - sizeof( legacy.nacks );
+            if( bytes < headerSize )
+                return 0;
+
+            ::memcpy( &legacy, data, LB_MIN( bytes, sizeof( legacy )));
+            const uint16_t writerID = _swapped( legacy.writerID );
+            if( writerID != _id )
+                return 0;
+
+            // convert the received nacks which fit into the current datagram
+            const size_t nReceived = ( bytes - headerSize ) /
+                                     sizeof( legacy.nacks[0] );
+            size_t count = LB_MIN( size_t( _swapped( legacy.count )),
+                                   nReceived );
+            count = LB_MIN( count, size_t( EQ_RSP_MAX_NACKS ));
+            DatagramNack& nack = *reinterpret_cast< DatagramNack* >( data );
+            nack.set( _swapped( legacy.readerID ), writerID, uint16_t( count ));
+            for( size_t i = 0; i < count; ++i )
+            {
+                nack.nacks[i].start = _unwrap( _sequence,
+                                            _swapped( legacy.nacks[i].start ));
+                nack.nacks[i].end = _unwrap( _sequence,
+                                             _swapped( legacy.nacks[i].end ));
+            }
+            const size_t size = sizeof( DatagramNack ) -
+                                (EQ_RSP_MAX_NACKS - count) * sizeof( Nack );
+            nack.byteswap();
+            return size;
+        }
+
+        default:
+            LBUNREACHABLE;
+            return 0;
+    }
+}
+
 void RSPConnection::_asyncReceiveFrom()
 {
+#ifdef EQ_RSP_MMSG
+    if( _mmsg )
+    {
+        // wait for readability, _handleReadable receives all pending datagrams
+        _read->async_receive( null_buffers(),
+                              boost::bind( &RSPConnection::_handleReadable,
+                                           this, placeholders::error ));
+        return;
+    }
+#endif
+
     _read->async_receive_from(
         buffer( _recvBuffer.getData(), _mtu ), _readAddr,
         boost::bind( &RSPConnection::_handlePacket, this,
@@ -1026,6 +1831,34 @@ void RSPConnection::_asyncReceiveFrom()
                      placeholders::bytes_transferred ));
 }
 
+void RSPConnection::_initBatchIO()
+{
+#ifdef EQ_RSP_MMSG
+    _mmsg = true;
+
+#  ifdef UDP_SEGMENT
+    // probe for segmentation offload support, the size is set per send
+    const int noSegment = 0;
+    _gso = ::setsockopt( _write->native_handle(), SOL_UDP, UDP_SEGMENT,
+                         &noSegment, sizeof( noSegment )) == 0;
+#  endif
+#  ifdef UDP_GRO
+    const int on = 1;
+    _gro = ::setsockopt( _read->native_handle(), SOL_UDP, UDP_GRO,
+                         &on, sizeof( on )) == 0;
+#  endif
+
+    // coalesced datagrams need large buffers and are copied out of them
+    const size_t nBuffers = _gro ? EQ_RSP_MAX_GRO_BURST : EQ_RSP_MAX_BURST;
+    const size_t size = _gro ? LB_64KB : size_t( _mtu + EQ_RSP_LEGACY_SHIFT );
+    while( _burstBuffers.size() < nBuffers )
+        _burstBuffers.push_back( new Buffer( size ));
+
+    LBLOG( LOG_RSP ) << "Batched datagram I/O, GSO " << _gso << " GRO "
+                     << _gro << std::endl;
+#endif
+}
+
 bool RSPConnection::_handleData( const size_t bytes )
 {
     if( bytes < sizeof( DatagramData ))
@@ -1056,7 +1889,7 @@ bool RSPConnection::_handleData( const size_t bytes )
     }
     LBASSERT( connection->_id == writerID );
 
-    const uint16_t sequence = datagram.sequence;
+    const uint32_t sequence = datagram.getSequence();
 //  LBLOG( LOG_RSP ) << "rcvd " << sequence << " from " << writerID <<std::endl;
 
     if( connection->_sequence == sequence ) // in-order packet
@@ -1065,8 +1898,12 @@ bool RSPConnection::_handleData( const size_t bytes )
         if( !newBuffer ) // no more data buffers, drop packet
             return true;
 
+        connection->_updateLossRate( sequence );
+        connection->_addReceivedParity(
+            *reinterpret_cast< const DatagramData* >( newBuffer->getData( )));
+
         lunchbox::ScopedWrite mutex( connection->_mutexEvent );
-        connection->_pushDataBuffer( newBuffer );
+        connection->_pushDataBuffer( newBuffer, true );
 
         while( !connection->_recvBuffers.empty( )) // enqueue ready pending data
         {
@@ -1075,7 +1912,7 @@ bool RSPConnection::_handleData( const size_t bytes )
                 break;
 
             connection->_recvBuffers.pop_front();
-            connection->_pushDataBuffer( newBuffer );
+            connection->_pushDataBuffer( newBuffer, false );
         }
 
         if( !connection->_recvBuffers.empty() &&
@@ -1088,8 +1925,7 @@ bool RSPConnection::_handleData( const size_t bytes )
         return true;
     }
 
-    if( connection->_sequence > sequence ||
-        uint16_t( connection->_sequence - sequence ) <= _numBuffers )
+    if( uint32_t( connection->_sequence - sequence ) <= _numBuffers )
     {
         // ignore it if it's a repetition for another reader
         return true;
@@ -1097,7 +1933,7 @@ bool RSPConnection::_handleData( const size_t bytes )
 
     // else out of order
 
-    const uint16_t size = sequence - connection->_sequence;
+    const uint32_t size = sequence - connection->_sequence;
     LBASSERT( size != 0 );
     LBASSERTINFO( size <= _numBuffers, size << " > " << _numBuffers );
 
@@ -1116,10 +1952,21 @@ bool RSPConnection::_handleData( const size_t bytes )
 
     LBASSERT( !connection->_recvBuffers[ i ] );
     connection->_recvBuffers[ i ] = newBuffer;
+    connection->_updateLossRate( sequence );
+    connection->_addReceivedParity(
+        *reinterpret_cast< const DatagramData* >( newBuffer->getData( )));
+
+    // the parity of the current group may repair the hole, see _handleParity
+    if( connection->_parityActive &&
+        uint32_t( connection->_sequence - connection->_paritySequence ) <
+            EQ_RSP_MAX_FEC_GROUP )
+    {
+        return true;
+    }
 
     // early nack: request missing packets before current
     --i;
-    Nack nack = { connection->_sequence, uint16_t( sequence - 1 ) };
+    Nack nack = { connection->_sequence, sequence - 1 };
     if( i > 0 )
     {
         if( connection->_recvBuffers[i] ) // got previous packet
@@ -1133,7 +1980,7 @@ bool RSPConnection::_handleData( const size_t bytes )
         {
             const DatagramData* last =
                 reinterpret_cast<const DatagramData*>( lastBuffer->getData( ));
-            nack.start = last->sequence + 1;
+            nack.start = last->getSequence() + 1;
         }
     }
 
@@ -1143,7 +1990,7 @@ bool RSPConnection::_handleData( const size_t bytes )
 
     if( nack.end < nack.start )
         // OPT: don't drop nack 0..nack.end, but it doesn't happen often
-        nack.end = std::numeric_limits< uint16_t >::max();
+        nack.end = std::numeric_limits< uint32_t >::max();
 
     _sendNack( writerID, &nack, 1 );
     return true;
@@ -1151,7 +1998,8 @@ bool RSPConnection::_handleData( const size_t bytes )
 
 RSPConnection::Buffer* RSPConnection::_newDataBuffer( Buffer& inBuffer )
 {
-    LBASSERT( static_cast< int32_t >( inBuffer.getMaxSize( )) == _mtu );
+    LBASSERT( static_cast< int32_t >( inBuffer.getMaxSize( )) ==
+              _mtu + EQ_RSP_LEGACY_SHIFT );
 
     Buffer* buffer = 0;
     if( _threadBuffers.pop( buffer ))
@@ -1174,15 +2022,52 @@ RSPConnection::Buffer* RSPConnection::_newDataBuffer( Buffer& inBuffer )
     return 0;
 }
 
-void RSPConnection::_pushDataBuffer( Buffer* buffer )
+void RSPConnection::_resizeBuffers( const size_t size )
+{
+    // only before the buffers are handed out, see listen and _addConnection
+    LBASSERT( _threadBuffers.isEmpty( ));
+    LBASSERT( _appBuffers.isEmpty( ));
+    if( size <= _buffers.size( ))
+        return;
+
+    _threadBuffers.resize( int32_t( size ));
+    _buffers.reserve( size );
+    while( _buffers.size() < size )
+        _buffers.push_back( new Buffer( _mtu + EQ_RSP_LEGACY_SHIFT ));
+}
+
+void RSPConnection::_updateLossRate( const uint32_t sequence )
+{
+    // Repeated and late datagrams are not counted, they are older than the
+    // newest one. The average spans about 256 datagrams.
+    if( !_hasHighest ) // the first datagram may have any sequence
+    {
+        _highest = sequence;
+        _hasHighest = true;
+        return;
+    }
+
+    const uint32_t ahead = sequence - _highest;
+    if( ahead == 0 || ahead > _numBuffers )
+        return;
+
+    _highest = sequence;
+    const uint32_t nLost = LB_MIN( ahead - 1, 1024u );
+    for( uint32_t i = 0; i < nLost; ++i )
+        _lossRate += ( 1.f - _lossRate ) * ( 1.f / 256.f );
+    _lossRate -= _lossRate * ( 1.f / 256.f );
+}
+
+void RSPConnection::_pushDataBuffer( Buffer* buffer, const bool timely )
 {
     LBASSERT( _parent );
-    LBASSERTINFO( ((DatagramData*)buffer->getData( ))->sequence == _sequence,
-                  ((DatagramData*)buffer->getData( ))->sequence << " != " <<
-                  _sequence );
+    LBASSERTINFO( ((DatagramData*)buffer->getData( ))->getSequence() ==
+                  _sequence,
+                  ((DatagramData*)buffer->getData( ))->getSequence() << " != "
+                  << _sequence );
 
     if( (( _sequence + _parent->_id ) % _ackFreq ) == 0 )
-        _parent->_sendAck( _id, _sequence );
+        _parent->_sendAck( _id, _sequence, 0, 0, timely );
 
     LBLOG( LOG_RSP ) << "post buffer " << _sequence << std::endl;
     ++_sequence;
@@ -1191,11 +2076,16 @@ void RSPConnection::_pushDataBuffer( Buffer* buffer )
 
 bool RSPConnection::_handleAck( const size_t bytes )
 {
-    if( bytes < sizeof( DatagramAck ))
+    if( bytes < sizeof( DatagramAck ) - EQ_RSP_MAX_SACK * sizeof( uint32_t ))
         return false;
     DatagramAck& ack =
                      *reinterpret_cast< DatagramAck* >( _recvBuffer.getData( ));
+    const uint16_t count = _swapped( ack.count );
+    if( count > EQ_RSP_MAX_SACK * 32 )
+        return false;
     ack.byteswap();
+    if( bytes < ack.getSize( ))
+        return false;
 
 #ifdef EQ_INSTRUMENT_RSP
     ++nAcksRead;
@@ -1206,7 +2096,8 @@ bool RSPConnection::_handleAck( const size_t bytes )
 
     LBLOG( LOG_RSP ) << "got ack from " << ack.readerID << " for "
                      << ack.writerID << " sequence " << ack.sequence
-                     << " current " << _sequence << std::endl;
+                     << " current " << _sequence << " selective "
+                     << ack.count << std::endl;
 
     // find destination connection, update ack data if needed
     RSPConnectionPtr connection = _findConnection( ack.readerID );
@@ -1216,8 +2107,14 @@ bool RSPConnection::_handleAck( const size_t bytes )
         return false;
     }
 
-    if( connection->_acked >= ack.sequence &&
-        connection->_acked - ack.sequence <= _numBuffers )
+    _handleFeedback( connection, ack );
+    if( ack.count > 0 )
+    {
+        _timeouts = 0;
+        _addRepeat( ack );
+    }
+
+    if( uint32_t( connection->_acked - ack.sequence ) <= _numBuffers )
     {
         // I have received a later ack previously from the reader
         LBLOG( LOG_RSP ) << "Late ack" << std::endl;
@@ -1231,7 +2128,7 @@ bool RSPConnection::_handleAck( const size_t bytes )
     _timeouts = 0; // reset timeout counter
 
     // Check if we can advance _acked
-    uint16_t acked = ack.sequence;
+    uint32_t acked = ack.sequence;
 
     for( RSPConnectionsCIter i = _children.begin(); i != _children.end(); ++i )
     {
@@ -1239,18 +2136,84 @@ bool RSPConnection::_handleAck( const size_t bytes )
         if( child->_id == _id )
             continue;
 
-        const uint16_t distance = child->_acked - acked;
+        const uint32_t distance = child->_acked - acked;
         if( distance > _numBuffers )
             acked = child->_acked;
     }
 
     RSPConnectionPtr selfChild = _findConnection( _id );
-    const uint16_t distance = acked - selfChild->_acked;
+    const uint32_t distance = acked - selfChild->_acked;
     if( distance <= _numBuffers )
         _finishWriteQueue( acked );
     return true;
 }
 
+void RSPConnection::_handleFeedback( RSPConnectionPtr reader,
+                                     const DatagramAck& ack )
+{
+    if( !_wide ) // version 0 readers do not report their loss
+        return;
+
+    reader->_lossRate = float( ack.lossRate ) / 65535.f;
+
+    // Only datagrams sent once and received in order give a precise sample
+    const uint32_t age = _sequence - ack.sequence;
+    if( ack.timely && age > 0 && age <= _sendTimes.size( ))
+    {
+        const float sent = _sendTimes[ ack.sequence % _sendTimes.size() ];
+        if( sent >= 0.f )
+        {
+            const float rtt = _sendClock.getTimef() - sent;
+            reader->_rtt = reader->_rtt > 0.f ?
+                           .875f * reader->_rtt + .125f * rtt : rtt;
+        }
+    }
+
+    reader->_fairRate = _getFairRate( reader->_lossRate, reader->_rtt, _mtu );
+    _adaptSendRate();
+}
+
+void RSPConnection::_adaptSendRate()
+{
+    // The most limiting reader decides, like the CLR of TFMCC. The minimum
+    // send rate bounds the influence of a single lossy reader.
+    ConstConnectionDescriptionPtr description = getDescription();
+    int64_t rate = description->bandwidth;
+    float rtt = 0.f;
+    for( RSPConnectionsCIter i = _children.begin(); i != _children.end(); ++i )
+    {
+        RSPConnectionPtr child = *i;
+        if( child->_id == _id )
+            continue;
+        rate = LB_MIN( rate, child->_fairRate );
+        rtt = LB_MAX( rtt, child->_rtt );
+    }
+    const int64_t minRate = description->bandwidth >>
+        Global::getIAttribute( Global::IATTR_RSP_MIN_SENDRATE_SHIFT );
+    rate = LB_MAX( rate, minRate );
+
+    const float time = _sendClock.getTimef();
+    const float elapsed = time - _adaptTime;
+    _adaptTime = time;
+
+    if( rate < _sendRate )
+    {
+        _sendRate = rate;
+        LBLOG( LOG_RSP ) << "slowing down to " << _sendRate << " KB/s"
+                         << std::endl;
+    }
+    else if( rate > _sendRate )
+    {
+        // at most double the rate per round trip
+        const int64_t step = int64_t( float( _sendRate ) * elapsed /
+                                      LB_MAX( rtt, .1f ));
+        _sendRate = LB_MIN( rate, _sendRate + LB_MAX( step, int64_t( 1 )));
+        LBLOG( LOG_RSP ) << "speeding up to " << _sendRate << " KB/s"
+                         << std::endl;
+    }
+    _updatePacingRate();
+}
+
 bool RSPConnection::_handleNack( const size_t bytes )
 {
     DatagramNack& nack =
@@ -1286,7 +2249,33 @@ bool RSPConnection::_handleNack( const size_t bytes )
     return true;
 }
 
-void RSPConnection::_addRepeat( const Nack* nacks, uint16_t num )
+void RSPConnection::_addRepeat( const DatagramAck& ack )
+{
+    // the bits of the received datagrams are set, repeat the others
+    std::vector< Nack > nacks;
+    for( uint32_t i = 0; i < ack.count; ++i )
+    {
+        if( ack.received[ i >> 5 ] & ( 1u << ( i & 31 )))
+            continue;
+
+        const uint32_t sequence = ack.sequence + 1 + i;
+        if( !nacks.empty() && sequence != 0 &&
+            nacks.back().end + 1 == sequence )
+        {
+            nacks.back().end = sequence;
+        }
+        else
+        {
+            const Nack nack = { sequence, sequence };
+            nacks.push_back( nack );
+        }
+    }
+
+    if( !nacks.empty( ))
+        _addRepeat( &nacks.front(), nacks.size( ));
+}
+
+void RSPConnection::_addRepeat( const Nack* nacks, const size_t num )
 {
     LBLOG( LOG_RSP ) << lunchbox::disableFlush << "Queue repeat requests ";
     size_t lost = 0;
@@ -1323,14 +2312,22 @@ void RSPConnection::_addRepeat( const Nack* nacks, uint16_t num )
 
         if( !merged )
         {
-            lost += uint16_t( nack.end - nack.start ) + 1;
+            lost += size_t( nack.end - nack.start ) + 1;
             LBASSERT( lost <= _numBuffers );
             _repeatQueue.push_back( nack );
         }
     }
 
+    // residual loss which was not repaired by the parity: add redundancy
+    if( _fecGroupSize > 1 && lost > 0 && _fecClean >= _fecGroupSize )
+    {
+        _fecGroupSize = LB_MAX( _fecGroupSize >> 1, 1 );
+        _fecClean = 0;
+        LBLOG( LOG_RSP ) << ", " << _fecGroupSize << " datagrams per parity";
+    }
+
     ConstConnectionDescriptionPtr description = getDescription();
-    if( _sendRate >
+    if( !_wide && _sendRate >
         ( description->bandwidth >>
           Global::getIAttribute( Global::IATTR_RSP_MIN_SENDRATE_SHIFT )))
     {
@@ -1373,23 +2370,49 @@ bool RSPConnection::_handleAckRequest( const size_t bytes )
         return false;
     }
 
-    const uint16_t reqID = ackRequest.sequence;
-    const uint16_t gotID = connection->_sequence - 1;
-    const uint16_t distance = reqID - gotID;
+    const uint32_t reqID = ackRequest.sequence;
+    const uint32_t gotID = connection->_sequence - 1;
+    const uint32_t distance = reqID - gotID;
 
     LBLOG( LOG_RSP ) << "ack request "  << reqID << " from " << writerID
                      << " got " << gotID << " missing " << distance
                      << std::endl;
 
-    if( (reqID == gotID) ||
-        (gotID > reqID && gotID - reqID <= _numBuffers) ||
-        (gotID < reqID && distance > _numBuffers) )
-    {
+    if( distance == 0 || distance > _numBuffers )
         _sendAck( connection->_id, gotID );
-        return true;
+    else if( _wide )
+        _sendSelectiveAck( connection, reqID );
+    else
+        _sendNacks( connection, reqID );
+    return true;
+}
+
+void RSPConnection::_sendSelectiveAck( RSPConnectionPtr connection,
+                                       const uint32_t reqID )
+{
+    // One bit per datagram after the last one received in order. The first
+    // one is missing, the following ones are in the out-of-order buffers.
+    const uint32_t gotID = connection->_sequence - 1;
+    const uint16_t nBits = uint16_t( LB_MIN( reqID - gotID,
+                                             uint32_t( EQ_RSP_MAX_SACK * 32 )));
+    uint32_t received[ EQ_RSP_MAX_SACK ];
+    ::memset( received, 0, (( nBits + 31 ) >> 5 ) * sizeof( uint32_t ));
+
+    const size_t nBuffers = LB_MIN( connection->_recvBuffers.size(),
+                                    size_t( nBits - 1 ));
+    for( size_t i = 0; i < nBuffers; ++i )
+    {
+        if( connection->_recvBuffers[ i ] )
+            received[ ( i + 1 ) >> 5 ] |= 1u << (( i + 1 ) & 31 );
     }
-    // else find all missing datagrams
 
+    _sendAck( connection->_id, gotID, received, nBits );
+}
+
+void RSPConnection::_sendNacks( RSPConnectionPtr connection,
+                                const uint32_t reqID )
+{
+    // find all missing datagrams
     const uint16_t max = EQ_RSP_MAX_NACKS - 2;
     Nack nacks[ EQ_RSP_MAX_NACKS ];
     uint16_t i = 0;
@@ -1411,7 +2434,7 @@ bool RSPConnection::_handleAckRequest( const size_t bytes )
                 LBASSERT( nacks[ i ].end < _numBuffers );
                 nacks[ i + 1 ].start = 0;
                 nacks[ i + 1 ].end = nacks[ i ].end;
-                nacks[ i ].end = std::numeric_limits< uint16_t >::max();
+                nacks[ i ].end = std::numeric_limits< uint32_t >::max();
                 ++i;
             }
             ++i;
@@ -1434,7 +2457,7 @@ bool RSPConnection::_handleAckRequest( const size_t bytes )
         LBLOG( LOG_RSP ) << nacks[i].end;
         ++i;
     }
-    else if( uint16_t( reqID - nacks[i-1].end ) < _numBuffers )
+    else if( uint32_t( reqID - nacks[i-1].end ) < _numBuffers )
     {
         nacks[i].start = nacks[i-1].end + 1;
         nacks[i].end = reqID;
@@ -1446,7 +2469,7 @@ bool RSPConnection::_handleAckRequest( const size_t bytes )
         LBASSERT( nacks[ i - 1 ].end < _numBuffers );
         nacks[ i ].start = 0;
         nacks[ i ].end = nacks[ i - 1 ].end;
-        nacks[ i - 1 ].end = std::numeric_limits< uint16_t >::max();
+        nacks[ i - 1 ].end = std::numeric_limits< uint32_t >::max();
         ++i;
     }
 
@@ -1455,9 +2478,143 @@ bool RSPConnection::_handleAckRequest( const size_t bytes )
 
     LBASSERT( i > 0 );
     _sendNack( connection->_id, nacks, i );
+}
+
+bool RSPConnection::_handleParity( const size_t bytes )
+{
+    if( bytes < sizeof( DatagramParity ))
+        return false;
+    DatagramParity& parity =
+                  *reinterpret_cast< DatagramParity* >( _recvBuffer.getData( ));
+    parity.byteswap();
+
+    const uint16_t writerID = parity.writerID;
+    if( writerID == _id ) // see _handleData
+        return true;
+
+    RSPConnectionPtr connection = _findConnection( writerID );
+    if( !connection )
+    {
+        LBASSERTINFO( false, "Can't find connection with id " << writerID );
+        return false;
+    }
+
+    const uint32_t first = parity.sequence;
+    const uint16_t count = parity.count;
+    if( count == 0 || count > EQ_RSP_MAX_FEC_GROUP )
+        return false;
+
+    // The group can be repaired if only one datagram is missing, and all others
+    // are part of the parity accumulated by the reader
+    const uint64_t mask = connection->_parityMask;
+    bool complete = connection->_parityActive &&
+                    connection->_paritySequence == first &&
+                    ( count == EQ_RSP_MAX_FEC_GROUP || ( mask >> count ) == 0 );
+    uint16_t nMissing = 0;
+    uint32_t missing = 0;
+    for( uint16_t i = 0; i < count; ++i )
+    {
+        const uint32_t sequence = first + i;
+        if( !connection->_hasDatagram( sequence ))
+        {
+            ++nMissing;
+            missing = sequence;
+        }
+        else if( !( mask & ( uint64_t( 1 ) << i )))
+            complete = false;
+    }
+
+    const uint16_t size = parity.size ^
+        reinterpret_cast< const DatagramParity* >(
+            connection->_parity.getData( ))->size;
+    const size_t parityBytes = bytes - sizeof( DatagramParity );
+
+    if( nMissing == 1 && complete && size <= parityBytes )
+    {
+        uint8_t* payload = reinterpret_cast< uint8_t* >( &parity + 1 );
+        _xor( payload, reinterpret_cast< const uint8_t* >(
+                  connection->_parity.getData( )) + sizeof( DatagramParity ),
+              parityBytes );
+        connection->_resetParity( first + count );
+
+        // rebuild the missing datagram in place and receive it
+        DatagramData* datagram =
+            reinterpret_cast< DatagramData* >( _recvBuffer.getData( ));
+        ::memmove( datagram + 1, payload, size );
+        datagram->set( writerID, size );
+        datagram->setSequence( missing );
+        datagram->byteswap();
+
+        LBLOG( LOG_RSP ) << "recovered " << missing << " from " << writerID
+                         << std::endl;
+        ++_nRecovered;
+#ifdef EQ_INSTRUMENT_RSP
+        ++nRecovered;
+#endif
+        return _handleData( sizeof( DatagramData ) + size );
+    }
+
+    connection->_resetParity( first + count );
+    connection->_parityActive = true;
+    if( nMissing == 0 )
+        return true;
+
+    // request the datagrams of the group which could not be repaired
+    Nack nacks[ EQ_RSP_MAX_FEC_GROUP ];
+    uint16_t nNacks = 0;
+    for( uint16_t i = 0; i < count; ++i )
+    {
+        const uint32_t sequence = first + i;
+        if( connection->_hasDatagram( sequence ))
+            continue;
+
+        if( nNacks > 0 && sequence != 0 &&
+            nacks[ nNacks - 1 ].end + 1 == sequence )
+        {
+            nacks[ nNacks - 1 ].end = sequence;
+        }
+        else
+        {
+            nacks[ nNacks ].start = sequence;
+            nacks[ nNacks ].end = sequence;
+            ++nNacks;
+        }
+    }
+
+    LBLOG( LOG_RSP ) << "can't repair " << nMissing << " datagrams from "
+                     << first << ", send " << nNacks << " nacks" << std::endl;
+    _sendNack( writerID, nacks, nNacks );
     return true;
 }
 
+void RSPConnection::_addReceivedParity( const DatagramData& datagram )
+{
+    if( !_parityActive )
+        return;
+
+    const uint32_t offset = datagram.getSequence() - _paritySequence;
+    if( offset >= EQ_RSP_MAX_FEC_GROUP ) // not in the current group
+        return;
+
+    _parityMask |= uint64_t( 1 ) << offset;
+    DatagramParity* parity =
+        reinterpret_cast< DatagramParity* >( _parity.getData( ));
+    parity->size ^= datagram.size;
+    _xor( reinterpret_cast< uint8_t* >( parity + 1 ),
+          reinterpret_cast< const uint8_t* >( &datagram + 1 ), datagram.size );
+}
+
+bool RSPConnection::_hasDatagram( const uint32_t sequence ) const
+{
+    const uint32_t behind = _sequence - sequence;
+    if( behind != 0 && behind <= _numBuffers ) // already read
+        return true;
+
+    const uint32_t ahead = sequence - _sequence;
+    return ahead != 0 && ahead <= _recvBuffers.size() &&
+           _recvBuffers[ ahead - 1 ];
+}
+
 void RSPConnection::_checkNewID( uint16_t id )
 {
     // look if the new ID exist in another connection
@@ -1478,18 +2635,21 @@ RSPConnectionPtr RSPConnection::_findConnection( const uint16_t id )
     return 0;
 }
 
-bool RSPConnection::_addConnection( const uint16_t id )
+bool RSPConnection::_addConnection( const uint16_t id,
+                                    const uint16_t version )
 {
     if( _findConnection( id ))
         return false;
 
-    LBINFO << "add connection " << id << std::endl;
+    LBINFO << "add connection " << id << " version " << version << std::endl;
     RSPConnectionPtr connection = new RSPConnection();
     connection->_id = id;
     connection->_parent = this;
+    connection->_protocolVersion = LB_MIN( version, EQ_RSP_PROTOCOL_VERSION );
     connection->_setState( STATE_CONNECTED );
     connection->_setDescription( _getDescription( ));
     LBASSERT( connection->_appBuffers.isEmpty( ));
+    connection->_resizeBuffers( _buffers.size( ));
 
     // Make all buffers available for reading
     for( BuffersCIter i = connection->_buffers.begin();
@@ -1500,6 +2660,7 @@ bool RSPConnection::_addConnection( const uint16_t id )
     }
 
     _children.push_back( connection );
+    _negotiateVersion();
     _sendCountNode();
 
     lunchbox::ScopedWrite mutex( _mutexConnection );
@@ -1530,9 +2691,31 @@ void RSPConnection::_removeConnection( const uint16_t id )
         }
     }
 
+    _negotiateVersion();
     _sendCountNode();
 }
 
+void RSPConnection::_negotiateVersion()
+{
+    uint16_t version = _protocolVersion;
+    for( RSPConnectionsCIter i = _children.begin(); i != _children.end(); ++i )
+        version = LB_MIN( version, (*i)->_protocolVersion );
+
+    // Readers handle both versions at any time, only the sender switches
+    const bool wide = version > EQ_RSP_LEGACY_VERSION;
+    if( wide == _wide )
+        return;
+
+    LBINFO << "Using RSP protocol version " << version << std::endl;
+    _wide = wide;
+    _parityCount = 0; // parity is only sent with version 1
+}
+
+uint16_t RSPConnection::getProtocolVersion() const
+{
+    return _wide ? EQ_RSP_PROTOCOL_VERSION : EQ_RSP_LEGACY_VERSION;
+}
+
 int64_t RSPConnection::write( const void* inData, const uint64_t bytes )
 {
     if( _parent )
@@ -1542,13 +2725,16 @@ int64_t RSPConnection::write( const void* inData, const uint64_t bytes )
     if( !_write )
         return -1;
 
+    const uint8_t* data = reinterpret_cast< const uint8_t* >( inData );
+    if( bytes >= EQ_RSP_MIN_REFERENCE * uint64_t( _payloadSize ))
+        return _writeReference( data, bytes );
+
     // compute number of datagrams
     uint64_t nDatagrams = bytes  / _payloadSize;
     if( nDatagrams * _payloadSize != bytes )
         ++nDatagrams;
 
     // queue each datagram (might block if buffers are exhausted)
-    const uint8_t* data = reinterpret_cast< const uint8_t* >( inData );
     const uint8_t* end = data + bytes;
     for( uint64_t i = 0; i < nDatagrams; ++i )
     {
@@ -1575,9 +2761,7 @@ int64_t RSPConnection::write( const void* inData, const uint64_t bytes )
         // prepare packet header (sequence is done by thread)
         DatagramData* header =
             reinterpret_cast< DatagramData* >( buffer->getData( ));
-        header->type = DATA;
-        header->size = uint16_t( packetSize );
-        header->writerID = _id;
+        header->set( _id, uint16_t( packetSize ));
 
         memcpy( header + 1, data, packetSize );
         data += packetSize;
@@ -1590,6 +2774,50 @@ int64_t RSPConnection::write( const void* inData, const uint64_t bytes )
     return bytes;
 }
 
+int64_t RSPConnection::_writeReference( const uint8_t* data,
+                                        const uint64_t bytes )
+{
+    if( _appBuffers.isEmpty( ))
+        _postWakeup();
+
+    Buffer* buffer;
+    if( !_appBuffers.timedPop( _writeTimeOut, buffer ))
+    {
+        LBERROR << "Timeout while writing" << std::endl;
+        buffer = 0;
+    }
+
+    if( !buffer )
+    {
+        close();
+        return -1;
+    }
+
+    // Queue the data range instead of the data. The protocol thread chunks it
+    // into the free write buffers when sending, saving the per-datagram
+    // handover to the thread.
+    DatagramData* header = reinterpret_cast< DatagramData* >( buffer->getData( ));
+    const uint8_t* range[ 2 ] = { data, data + bytes };
+    header->type = REFERENCE;
+    ::memcpy( header + 1, range, sizeof( range ));
+
+    _referenceAborted = false;
+    _referenced = true;
+    LBCHECK( _threadBuffers.push( buffer ));
+    _postWakeup();
+
+    _referenced.waitEQ( false );
+    if( _referenceAborted )
+    {
+        close();
+        return -1;
+    }
+
+    LBLOG( LOG_RSP ) << "queued " << bytes << " bytes by reference"
+                     << std::endl;
+    return bytes;
+}
+
 void RSPConnection::finish()
 {
     if( _parent.isValid( ))
@@ -1607,8 +2835,8 @@ void RSPConnection::_sendCountNode()
         return;
 
     LBLOG( LOG_RSP ) << _children.size() << " nodes" << std::endl;
-    DatagramNode count = { COUNTNODE, EQ_RSP_PROTOCOL_VERSION, _id,
-                           uint16_t( _children.size( )) };
+    DatagramNode count = { COUNTNODE, EQ_RSP_LEGACY_VERSION, _id,
+                           uint16_t( _children.size( )), _protocolVersion };
     count.byteswap();
     _write->send( buffer( &count, sizeof( count )) );
 }
@@ -1616,13 +2844,16 @@ void RSPConnection::_sendCountNode()
 void RSPConnection::_sendSimpleDatagram( const DatagramType type,
                                          const uint16_t id )
 {
-    DatagramNode simple = { uint16_t( type ), EQ_RSP_PROTOCOL_VERSION, id, 0 };
+    DatagramNode simple = { uint16_t( type ), EQ_RSP_LEGACY_VERSION, id, 0,
+                            _protocolVersion };
     simple.byteswap();
     _write->send( buffer( &simple, sizeof( simple )) );
 }
 
 void RSPConnection::_sendAck( const uint16_t writerID,
-                              const uint16_t sequence )
+                              const uint32_t sequence,
+                              const uint32_t* received, const uint16_t nBits,
+                              const bool timely )
 {
     LBASSERT( _id != writerID );
 #ifdef EQ_INSTRUMENT_RSP
@@ -1630,9 +2861,25 @@ void RSPConnection::_sendAck( const uint16_t writerID,
 #endif
 
     LBLOG( LOG_RSP ) << "send ack " << sequence << std::endl;
-    DatagramAck ack = { ACK, _id, writerID, sequence };
+    if( !_wide )
+    {
+        LBASSERT( nBits == 0 );
+        LegacyAck ack = { ACK, _id, writerID, uint16_t( sequence ) };
+        ack.byteswap();
+        _write->send( buffer( &ack, sizeof( ack )) );
+        return;
+    }
+
+    RSPConnectionPtr connection = _findConnection( writerID );
+    DatagramAck ack;
+    ack.set( _id, writerID, sequence, nBits );
+    ack.lossRate = connection ? uint16_t( connection->_lossRate * 65535.f ) : 0;
+    ack.timely = timely;
+    memcpy( ack.received, received,
+            (( nBits + 31 ) >> 5 ) * sizeof( uint32_t ));
+    const size_t size = ack.getSize();
     ack.byteswap();
-    _write->send( buffer( &ack, sizeof( ack )) );
+    _write->send( buffer( &ack, size ));
 }
 
 void RSPConnection::_sendNack( const uint16_t writerID, const Nack* nacks,
@@ -1650,6 +2897,40 @@ void RSPConnection::_sendNack( const uint16_t writerID, const Nack* nacks,
          return;
     }
 
+    if( !_wide )
+    {
+        // 16 bit ranges, split at the wrap around
+        LegacyNack packet;
+        packet.type = NACK;
+        packet.readerID = _id;
+        packet.writerID = writerID;
+        packet.count = 0;
+        for( uint16_t i = 0; i < count; ++i )
+        {
+            const uint16_t start = uint16_t( nacks[i].start );
+            const uint16_t end = uint16_t( nacks[i].end );
+            if( end < start && packet.count < EQ_RSP_MAX_LEGACY_NACKS - 1 )
+            {
+                packet.nacks[ packet.count ].start = start;
+                packet.nacks[ packet.count ].end =
+                    std::numeric_limits< uint16_t >::max();
+                packet.nacks[ ++packet.count ].start = 0;
+                packet.nacks[ packet.count++ ].end = end;
+            }
+            else if( end >= start && packet.count < EQ_RSP_MAX_LEGACY_NACKS )
+            {
+                packet.nacks[ packet.count ].start = start;
+                packet.nacks[ packet.count++ ].end = end;
+            }
+        }
+
+        const size_t size = sizeof( LegacyNack ) - sizeof( packet.nacks[0] ) *
+                            ( EQ_RSP_MAX_LEGACY_NACKS - packet.count );
+        packet.byteswap();
+        _write->send( buffer( &packet, size ));
+        return;
+    }
+
     const size_t size = sizeof( DatagramNack ) -
                         (EQ_RSP_MAX_NACKS - count) * sizeof( Nack );
 
@@ -1666,9 +2947,17 @@ void RSPConnection::_sendAckRequest()
 #ifdef EQ_INSTRUMENT_RSP
     ++nAckRequests;
 #endif
-    LBLOG( LOG_RSP ) << "send ack request for " << uint16_t( _sequence -1 )
+    LBLOG( LOG_RSP ) << "send ack request for " << uint32_t( _sequence -1 )
                      << std::endl;
-    DatagramAckRequest ackRequest = { ACKREQ, _id, uint16_t( _sequence - 1 ) };
+    if( !_wide )
+    {
+        LegacyAckRequest ackRequest = { ACKREQ, _id, uint16_t( _sequence - 1 )};
+        ackRequest.byteswap();
+        _write->send( buffer( &ackRequest, sizeof( ackRequest )) );
+        return;
+    }
+
+    DatagramAckRequest ackRequest = { ACKREQ | WIDE, _id, _sequence - 1 };
     ackRequest.byteswap();
     _write->send( buffer( &ackRequest, sizeof( DatagramAckRequest )) );
 }
@@ -1690,7 +2979,8 @@ std::ostream& operator << ( std::ostream& os,
        << float( nBytesRead ) / mbps << " / " << float( nBytesWritten ) / mbps
        <<  " MB/s r/w using " << nDatagrams << " dgrams " << nRepeated
        << " repeats " << nMergedDatagrams
-       << " merged"
+       << " merged " << nParities << " parities " << nRecovered
+       << " recovered"
        << std::endl;
 
     os.precision( prec );
@@ -1707,6 +2997,8 @@ std::ostream& operator << ( std::ostream& os,
     nDatagrams = 0;
     nRepeated = 0;
     nMergedDatagrams = 0;
+    nParities = 0;
+    nRecovered = 0;
     nAckRequests = 0;
     nAcksSend = 0;
     nAcksRead = 0;
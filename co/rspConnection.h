@@ -28,6 +28,7 @@
 #include <lunchbox/buffer.h>  // member
 #include <lunchbox/clock.h>   // member
 #include <lunchbox/lfQueue.h> // member
+#include <lunchbox/monitor.h> // member
 #include <lunchbox/mtQueue.h> // member
 
 #pragma warning(push)
@@ -73,6 +74,35 @@ namespace co
         /** @internal @return current send speed in kilobyte per second. */
         int64_t getSendRate() const { return _sendRate; }
 
+        /**
+         * @internal
+         * @return the loss rate (0..1) measured by this reader, or reported by
+         *         it to the writer of the group.
+         */
+        float getLossRate() const { return _lossRate; }
+
+        /** @internal @return the round-trip time in ms to this reader. */
+        float getRoundTripTime() const { return _rtt; }
+
+        /** @internal @return the send rate in KB/s allowed by this reader. */
+        int64_t getFairRate() const { return _fairRate; }
+
+        /** @internal @return the number of datagrams repaired using parity. */
+        uint64_t getNumRecovered() const { return _nRecovered; }
+
+        /** @internal Drop every nth received data datagram, for testing. */
+        void setDropInterval( const uint32_t n ) { _dropInterval = n; }
+
+        /**
+         * @internal Speak at most the given protocol version, for testing the
+         * interoperability with older peers. Call before listen().
+         */
+        void setProtocolVersion( const uint16_t version )
+            { _protocolVersion = version; }
+
+        /** @internal @return the protocol version used to send to the group */
+        uint16_t getProtocolVersion() const;
+
         /**
          * @internal
          * @return the unique identifier of this connection within the multicast
@@ -112,18 +142,26 @@ namespace co
             ID_DENY,   //!< deny the id, already used
             ID_CONFIRM,//!< a new node is connected
             ID_EXIT,   //!< a node is disconnected
-            COUNTNODE  //!< send to other the number of nodes which I have found
+            COUNTNODE, //!< send to other the number of nodes which I have found
+            PARITY,    //!< XOR of a group of data datagrams
+            REFERENCE, //!< never sent, queues a large write by reference
+            WIDE = 0x80 //!< flag for 32 bit sequence datagrams (version 1)
             // NOTE: Do not use more than 255 types here, since the endianness
             // detection magic relies on only using the LSB.
         };
 
-        /** ID_HELLO, ID_DENY, ID_CONFIRM, ID_EXIT or COUNTNODE packet */
+        /**
+         * ID_HELLO, ID_DENY, ID_CONFIRM, ID_EXIT or COUNTNODE packet. The
+         * protocolVersion is the oldest version the sender speaks, maxVersion
+         * the newest one. Version 0 nodes do not send maxVersion.
+         */
         struct DatagramNode
         {
             uint16_t type;
             uint16_t protocolVersion;
             uint16_t connectionID;  // clientID for type COUNTNODE
             uint16_t numConnections;
+            uint16_t maxVersion;
 
             void byteswap()
             {
@@ -132,6 +170,7 @@ namespace co
                 lunchbox::byteswap( protocolVersion );
                 lunchbox::byteswap( connectionID );
                 lunchbox::byteswap( numConnections );
+                lunchbox::byteswap( maxVersion );
 #endif
             }
         };
@@ -141,7 +180,7 @@ namespace co
         {
             uint16_t type;
             uint16_t writerID;
-            uint16_t sequence;
+            uint32_t sequence;
 
             void byteswap()
             {
@@ -156,17 +195,17 @@ namespace co
         /** Missing packets from start..end sequence */
         struct Nack
         {
-            uint16_t start;
-            uint16_t end;
+            uint32_t start;
+            uint32_t end;
         };
 
-#       define EQ_RSP_MAX_NACKS 300 // fits in a single IP frame
+#       define EQ_RSP_MAX_NACKS 180 // fits in a single IP frame
         /** Request resend of lost packets */
         struct DatagramNack
         {
             void set( uint16_t rID, uint16_t wID, uint16_t n )
             {
-                type       = NACK;
+                type       = NACK | WIDE;
                 readerID   = rID;
                 writerID   = wID;
                 count      = n;
@@ -194,13 +233,39 @@ namespace co
             }
         };
 
-        /** Acknowledge reception of all packets including sequence .*/
+#       define EQ_RSP_MAX_SACK 256 // words of the selective ack bitmap
+        /**
+         * Acknowledge reception of all packets including sequence. A selective
+         * ack has one bit per following packet, set if it was received.
+         */
         struct DatagramAck
         {
+            void set( uint16_t rID, uint16_t wID, uint32_t seq, uint16_t n )
+            {
+                type       = ACK | WIDE;
+                readerID   = rID;
+                writerID   = wID;
+                count      = n;
+                sequence   = seq;
+                lossRate   = 0;
+                timely     = 0;
+            }
+
+            /** @return the size of the datagram with count bits. */
+            size_t getSize() const
+            {
+                return sizeof( DatagramAck ) - sizeof( uint32_t ) *
+                       ( EQ_RSP_MAX_SACK - (( count + 31 ) >> 5 ));
+            }
+
             uint16_t        type;
             uint16_t        readerID;
             uint16_t        writerID;
-            uint16_t        sequence;
+            uint16_t        count;      //!< number of bits in the bitmap
+            uint32_t        sequence;
+            uint16_t        lossRate;   //!< reader's loss rate, 1/65535ths
+            uint16_t        timely;     //!< sequence was just received
+            uint32_t        received[ EQ_RSP_MAX_SACK ];
 
             void byteswap()
             {
@@ -208,25 +273,75 @@ namespace co
                 lunchbox::byteswap( type );
                 lunchbox::byteswap( readerID );
                 lunchbox::byteswap( writerID );
+                lunchbox::byteswap( count );
                 lunchbox::byteswap( sequence );
+                lunchbox::byteswap( lossRate );
+                lunchbox::byteswap( timely );
+                for( uint16_t i = 0; i < (( count + 31 ) >> 5 ); ++i )
+                    lunchbox::byteswap( received[i] );
 #endif
             }
         };
 
-        /** Data packet */
+        /**
+         * Data packet. The version 0 header, which has only the lower 16 bits
+         * of the sequence, is its suffix starting at legacyType.
+         */
         struct DatagramData
         {
+            void set( uint16_t wID, uint16_t n )
+            {
+                type       = DATA | WIDE;
+                legacyType = DATA;
+                size       = n;
+                writerID   = wID;
+            }
+
+            uint32_t getSequence() const
+                { return ( uint32_t( sequenceHigh ) << 16 ) | sequenceLow; }
+
+            void setSequence( const uint32_t sequence )
+            {
+                sequenceHigh = uint16_t( sequence >> 16 );
+                sequenceLow  = uint16_t( sequence );
+            }
+
             uint16_t    type;
+            uint16_t    sequenceHigh;
+            uint16_t    legacyType;
             uint16_t    size;
             uint16_t    writerID;
-            uint16_t    sequence;
+            uint16_t    sequenceLow;
 
             void byteswap()
             {
 #ifdef COLLAGE_BIGENDIAN
                 lunchbox::byteswap( type );
+                lunchbox::byteswap( sequenceHigh );
+                lunchbox::byteswap( legacyType );
                 lunchbox::byteswap( size );
                 lunchbox::byteswap( writerID );
+                lunchbox::byteswap( sequenceLow );
+#endif
+            }
+        };
+
+        /** Parity packet, followed by the XOR of the group's payloads */
+        struct DatagramParity
+        {
+            uint16_t    type;
+            uint16_t    size;     //!< XOR of the datagram sizes
+            uint16_t    writerID;
+            uint16_t    count;    //!< number of datagrams in the group
+            uint32_t    sequence; //!< first datagram of the group
+
+            void byteswap()
+            {
+#ifdef COLLAGE_BIGENDIAN
+                lunchbox::byteswap( type );
+                lunchbox::byteswap( size );
+                lunchbox::byteswap( writerID );
+                lunchbox::byteswap( count );
                 lunchbox::byteswap( sequence );
 #endif
             }
@@ -248,6 +363,8 @@ namespace co
         int32_t  _ackFreq;
         uint32_t _payloadSize;
         int32_t  _timeouts;
+        uint16_t _protocolVersion; //!< newest version spoken by this member
+        bool     _wide; //!< all members speak version 1, send 32 bit sequences
 
         typedef lunchbox::RefPtr< EventConnection > EventConnectionPtr;
         EventConnectionPtr _event;
@@ -256,6 +373,11 @@ namespace co
         boost::asio::ip::udp::socket*  _read;
         boost::asio::ip::udp::socket*  _write;
         boost::asio::ip::udp::endpoint _readAddr;
+        boost::asio::ip::udp::endpoint _writeAddr; //!< source of own datagrams
+        bool _loopback; //!< receive multicast from processes on this host
+        bool _mmsg;     //!< use batched datagram I/O (sendmmsg, recvmmsg)
+        bool _gso;      //!< send bursts using UDP segmentation offload
+        bool _gro;      //!< receive datagrams coalesced by the kernel
         boost::asio::deadline_timer    _timeout;
         boost::asio::deadline_timer    _wakeup;
 
@@ -263,11 +385,21 @@ namespace co
         uint64_t        _maxBucketSize;
         size_t          _bucketSize;
         int64_t         _sendRate;
+        int64_t         _pacingRate; //!< kernel pacing, 0 if n/a, -1 if unset
+
+        lunchbox::Clock      _sendClock; //!< time base of _sendTimes
+        std::vector< float > _sendTimes; //!< per sequence, -1 if repeated
+        float    _adaptTime; //!< last send rate adaption
+        float    _lossRate;  //!< measured (reader) or reported (writer)
+        float    _rtt;       //!< smoothed round-trip time in ms (writer)
+        int64_t  _fairRate;  //!< send rate allowed by the reader (writer)
+        uint32_t _highest;   //!< newest sequence received (reader)
+        bool     _hasHighest; //!< _highest is set from a datagram (reader)
 
         Thread*      _thread;
         lunchbox::Lock   _mutexConnection;
         lunchbox::Lock   _mutexEvent;
-        uint16_t     _acked;        // sequence ID of last confirmed ack
+        uint32_t     _acked;        // sequence ID of last confirmed ack
 
         typedef lunchbox::Bufferb Buffer;
         typedef std::vector< Buffer* > Buffers;
@@ -282,16 +414,39 @@ namespace co
 
         Buffer _recvBuffer;                      //!< Receive (thread) buffer
         std::deque< Buffer* > _recvBuffers;      //!< out-of-order buffers
+        Buffers _burstBuffers;                   //!< batched receive buffers
 
         Buffer* _readBuffer;                     //!< Read (app) buffer
         uint64_t _readBufferPos;                 //!< Current read index
 
-        uint16_t _sequence; //!< the next usable (write) or expected (read)
+        uint32_t _sequence; //!< the next usable (write) or expected (read)
         std::deque< Buffer* > _writeBuffers;    //!< Written buffers, not acked
+        /** Datagrams of the current write burst, sent using one system call */
+        std::vector< boost::asio::const_buffer > _burst;
 
         typedef std::deque< Nack > RepeatQueue;
         RepeatQueue _repeatQueue; //!< nacks to repeat
 
+        Buffer _parity;            //!< XOR of the current group's datagrams
+        Buffers _parityBuffers;    //!< parity datagrams of the current burst
+        size_t _nParities;         //!< used parity buffers in the current burst
+        uint32_t _paritySequence;  //!< first datagram of the current group
+        uint16_t _parityCount;     //!< datagrams in the current (write) group
+        uint16_t _parityBytes;     //!< largest payload in the current group
+        uint64_t _parityMask;      //!< datagrams in the current (read) group
+        bool _parityActive;        //!< got a parity, the group start is known
+        const uint16_t _fecMaxGroupSize; //!< 0 if no parity is sent
+        uint16_t _fecGroupSize;    //!< current datagrams per parity
+        uint32_t _fecClean;        //!< datagrams sent since last loss
+        uint64_t _nRecovered;      //!< datagrams repaired using parity
+        uint32_t _dropInterval;    //!< drop every nth data datagram (testing)
+        uint32_t _nDataDatagrams;  //!< received data datagrams (testing)
+
+        const uint8_t* _reference;    //!< next byte of a large write, or 0
+        const uint8_t* _referenceEnd; //!< end of the large write
+        lunchbox::Monitorb _referenced; //!< a large write is in progress
+        bool _referenceAborted;       //!< the large write was not sent
+
         const unsigned _writeTimeOut;
 
         void _close();
@@ -299,16 +454,31 @@ namespace co
 
         void _processOutgoing();
         void _writeData();
+        int64_t _writeReference( const uint8_t* data, const uint64_t bytes );
+        bool _popWriteBuffer( Buffer*& buffer );
+        void _fillReference( Buffer* buffer );
+        void _abortReference();
+        void _sendBurst();
         void _repeatData();
-        void _finishWriteQueue( const uint16_t sequence );
+        void _finishWriteQueue( const uint32_t sequence );
+        void _addToBurst( DatagramData* header, const size_t size );
+        bool _isWindowFull() const;
 
         bool _handleData( const size_t bytes );
         bool _handleAck( const size_t bytes );
         bool _handleNack( const size_t bytes );
         bool _handleAckRequest( const size_t bytes );
+        bool _handleParity( const size_t bytes );
+
+        /** Convert a version 0 datagram in place, @return its new size */
+        size_t _widenDatagram( const uint16_t type, const size_t bytes );
 
         Buffer* _newDataBuffer( Buffer& inBuffer );
-        void _pushDataBuffer( Buffer* buffer );
+        void _resizeBuffers( const size_t size );
+        void _pushDataBuffer( Buffer* buffer, const bool timely );
+
+        /** Account the datagrams skipped by a newly received one as lost */
+        void _updateLossRate( const uint32_t sequence );
 
         /* Run the reader thread */
         void _runThread();
@@ -320,6 +490,10 @@ namespace co
         /* handle data about the comunication state */
         void _handlePacket( const boost::system::error_code& error,
                             const size_t bytes );
+        /* receive and handle all available datagrams using one system call */
+        void _handleReadable( const boost::system::error_code& error );
+        /* @return false if the protocol thread has been stopped */
+        bool _handleDatagram( const size_t bytes );
         void _handleConnectedData( const size_t bytes );
         void _handleInitData( const size_t bytes, const bool connected );
         void _handleAcceptIDData( const size_t bytes );
@@ -337,13 +511,46 @@ namespace co
         /** find the connection corresponding to the identifier */
         RSPConnectionPtr _findConnection( const uint16_t id );
 
-        /** Sleep until allowed to send according to send rate */
-        void _waitWritable( const uint64_t bytes );
+        /** Add the send budget accumulated since the last call */
+        void _refillBucket();
+
+        /** @return the time in us until the next datagram may be sent */
+        int64_t _getWriteDelay();
+
+        /** Take the budget for sending a datagram, adapting the send rate */
+        void _consumeBucket( const uint64_t bytes );
+
+        /** Update the reader's statistics from the feedback in its ack */
+        void _handleFeedback( RSPConnectionPtr reader, const DatagramAck& ack );
+
+        /** Follow the send rate allowed by the most limiting reader */
+        void _adaptSendRate();
+
+        /** Pass the send rate to the kernel for pacing, if supported */
+        void _updatePacingRate();
 
         /** format and send a datagram count node */
         void _sendCountNode();
 
-        void _addRepeat( const Nack* nacks, const uint16_t num );
+        void _addRepeat( const Nack* nacks, const size_t num );
+
+        /** Queue repeats for the datagrams missing in a selective ack */
+        void _addRepeat( const DatagramAck& ack );
+
+        /** Restart the parity group at the given sequence */
+        void _resetParity( const uint32_t sequence );
+
+        /** Add a datagram to the parity of the current group */
+        void _addParity( const DatagramData& datagram );
+
+        /** Add a received datagram to the current group, if it belongs to it */
+        void _addReceivedParity( const DatagramData& datagram );
+
+        /** Queue the parity of the current group in the current burst */
+        void _sendParity();
+
+        /** @return true if the datagram has been received by this reader */
+        bool _hasDatagram( const uint32_t sequence ) const;
 
         /** format and send an simple request which use only type and id field*/
         void _sendSimpleDatagram( const DatagramType type, const uint16_t id );
@@ -351,8 +558,17 @@ namespace co
         /** format and send an ack request for the current sequence */
         void _sendAckRequest();
 
-        /** format and send a positive ack */
-        void _sendAck( const uint16_t writerID, const uint16_t sequence );
+        /** format and send a positive, optionally selective ack */
+        void _sendAck( const uint16_t writerID, const uint32_t sequence,
+                       const uint32_t* received = 0, const uint16_t nBits = 0,
+                       const bool timely = false );
+
+        /** format and send a selective ack for an ack request */
+        void _sendSelectiveAck( RSPConnectionPtr connection,
+                                const uint32_t sequence );
+
+        /** format and send negative acks for an ack request (version 0) */
+        void _sendNacks( RSPConnectionPtr connection, const uint32_t sequence );
 
         /** format and send a negative ack */
         void _sendNack( const uint16_t toWriterID, const Nack* nacks,
@@ -361,14 +577,23 @@ namespace co
         void _checkNewID( const uint16_t id );
 
         /* add a new connection detected in the multicast network */
-        bool _addConnection( const uint16_t id );
+        bool _addConnection( const uint16_t id, const uint16_t version );
         void _removeConnection( const uint16_t id );
 
+        /** Use the newest protocol version spoken by all members */
+        void _negotiateVersion();
+
+        void _initBatchIO();
         void _setTimeout( const int32_t timeOut );
+        void _setPacingTimeout( const int64_t delay );
         void _postWakeup();
         void _asyncReceiveFrom();
         bool _isWriting() const
-            { return !_threadBuffers.isEmpty() || !_writeBuffers.empty(); }
+            { return !_threadBuffers.isEmpty() || !_writeBuffers.empty() ||
+                     _reference; }
+        bool _hasWriteData() const
+            { return !_isWindowFull() && ( !_threadBuffers.isEmpty() ||
+                     ( _reference && !_appBuffers.isEmpty( ))); }
     };
 
     std::ostream& operator << ( std::ostream&, const RSPConnection& );
@@ -0,0 +1,587 @@
+
+/* Copyright (c) 2026, The Collage Authors
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "shmConnection.h"
+
+#include "byteRing.h"
+#include "connectionDescription.h"
+#include "exception.h"
+#include "global.h"
+#include "log.h"
+
+#include <lunchbox/os.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sstream>
+#include <stddef.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace co
+{
+namespace
+{
+/** The shared memory segment, followed by the data of both rings. */
+struct Segment
+{
+    uint64_t size;  //!< of the data of one ring, a power of two
+    uint8_t pad[ 64 - sizeof( uint64_t ) ];
+    ByteRing::State rings[ 2 ]; //!< written by the connecting, accepting side
+};
+
+/** The file descriptors passed to the accepting side. */
+enum FD
+{
+    FD_SEGMENT,
+    FD_DATA0,  //!< ring 0 has data, read by the accepting side
+    FD_SPACE0, //!< ring 0 has space, waited on by the connecting side
+    FD_DATA1,  //!< ring 1 has data, read by the connecting side
+    FD_SPACE1, //!< ring 1 has space, waited on by the accepting side
+    FD_ALL
+};
+
+void _closeFD( int& fd )
+{
+    if( fd >= 0 )
+        ::close( fd );
+    fd = -1;
+}
+
+int _getTimeout()
+{
+    const uint32_t timeout = Global::getTimeout();
+    return timeout == LB_TIMEOUT_INDEFINITE ? -1 : int( timeout );
+}
+
+std::string _getHostname()
+{
+    char hostname[ 256 ] = { 0 };
+    if( ::gethostname( hostname, sizeof( hostname ) - 1 ) != 0 )
+        return std::string();
+    return hostname;
+}
+
+/** Fill in the Unix socket address in the abstract namespace for name. */
+socklen_t _getAddress( const std::string& name, sockaddr_un& address )
+{
+    ::memset( &address, 0, sizeof( address ));
+    address.sun_family = AF_UNIX;
+
+    const size_t length = LB_MIN( name.length(),
+                                  sizeof( address.sun_path ) - 1 );
+    ::memcpy( address.sun_path + 1, name.c_str(), length );
+    return socklen_t( offsetof( sockaddr_un, sun_path ) + 1 + length );
+}
+
+bool _createSegment( int* fds )
+{
+    for( size_t i = 0; i < FD_ALL; ++i )
+        fds[ i ] = -1;
+
+    const uint64_t wanted =
+        uint64_t( Global::getIAttribute( Global::IATTR_SHM_RING_SIZE_KB )) <<10;
+    uint64_t size = 4096;
+    while( size < wanted )
+        size <<= 1;
+
+    std::ostringstream name;
+    name << "/Collage." << UUID( true );
+    fds[ FD_SEGMENT ] = ::shm_open( name.str().c_str(),
+                                    O_RDWR | O_CREAT | O_EXCL, 0600 );
+    if( fds[ FD_SEGMENT ] < 0 )
+    {
+        LBWARN << "Can't create shared memory segment: " << lunchbox::sysError
+               << std::endl;
+        return false;
+    }
+    ::shm_unlink( name.str().c_str( )); // passed by descriptor only
+
+    if( ::ftruncate( fds[ FD_SEGMENT ], sizeof( Segment ) + 2 * size ) != 0 )
+    {
+        LBWARN << "Can't size shared memory segment: " << lunchbox::sysError
+               << std::endl;
+        return false;
+    }
+
+    for( size_t i = FD_DATA0; i < FD_ALL; ++i )
+    {
+        fds[ i ] = ::eventfd( 0, EFD_CLOEXEC | EFD_NONBLOCK );
+        if( fds[ i ] < 0 )
+        {
+            LBWARN << "Can't create eventfd: " << lunchbox::sysError
+                   << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool _sendFDs( const int socket, const int* fds )
+{
+    char byte = 0;
+    iovec iov = { &byte, 1 };
+    char control[ CMSG_SPACE( FD_ALL * sizeof( int )) ];
+
+    msghdr message;
+    ::memset( &message, 0, sizeof( message ));
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof( control );
+
+    cmsghdr* header = CMSG_FIRSTHDR( &message );
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN( FD_ALL * sizeof( int ));
+    ::memcpy( CMSG_DATA( header ), fds, FD_ALL * sizeof( int ));
+
+    return ::sendmsg( socket, &message, MSG_NOSIGNAL ) == 1;
+}
+
+bool _recvFDs( const int socket, int* fds )
+{
+    pollfd pollFD = { socket, POLLIN, 0 };
+    if( ::poll( &pollFD, 1, _getTimeout( )) != 1 )
+        return false;
+
+    char byte = 0;
+    iovec iov = { &byte, 1 };
+    char control[ CMSG_SPACE( FD_ALL * sizeof( int )) ];
+
+    msghdr message;
+    ::memset( &message, 0, sizeof( message ));
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof( control );
+
+    if( ::recvmsg( socket, &message, MSG_CMSG_CLOEXEC ) != 1 )
+        return false;
+
+    const cmsghdr* header = CMSG_FIRSTHDR( &message );
+    if( !header || header->cmsg_level != SOL_SOCKET ||
+        header->cmsg_type != SCM_RIGHTS ||
+        header->cmsg_len != CMSG_LEN( FD_ALL * sizeof( int )))
+    {
+        return false;
+    }
+    ::memcpy( fds, CMSG_DATA( header ), FD_ALL * sizeof( int ));
+    return true;
+}
+}
+
+namespace detail
+{
+class SHMConnection
+{
+public:
+    SHMConnection()
+        : socket( -1 )
+        , notifier( -1 )
+        , inDataFD( -1 )
+        , inSpaceFD( -1 )
+        , outDataFD( -1 )
+        , outSpaceFD( -1 )
+        , segment( 0 )
+        , mapSize( 0 )
+    {}
+
+    ~SHMConnection() { unmap(); }
+
+    void unmap()
+    {
+        if( segment )
+            ::munmap( segment, mapSize );
+        segment = 0;
+    }
+
+    void closeFDs()
+    {
+        _closeFD( notifier );
+        _closeFD( inDataFD );
+        _closeFD( inSpaceFD );
+        _closeFD( outDataFD );
+        _closeFD( outSpaceFD );
+        _closeFD( socket );
+    }
+
+    /** @return true if the peer closed its end or died. */
+    bool isPeerClosed() const
+    {
+        if( in.isClosed( ))
+            return true;
+
+        char byte;
+        const ssize_t result = ::recv( socket, &byte, 1,
+                                       MSG_PEEK | MSG_DONTWAIT );
+        return result == 0 ||
+               ( result < 0 && errno != EAGAIN && errno != EWOULDBLOCK );
+    }
+
+    /** Wait for fd or the peer, @return -1 on error, 0 on timeout. */
+    int wait( const int fd ) const
+    {
+        pollfd fds[ 2 ] = {{ fd, POLLIN, 0 },
+                           { socket, POLLIN | POLLRDHUP, 0 }};
+        const int result = ::poll( fds, 2, _getTimeout( ));
+        if( result < 0 && errno == EINTR )
+            return 1;
+        return result;
+    }
+
+    int socket;   //!< the listener, or the rendezvous socket to the peer
+    int notifier; //!< epoll set of the socket and the incoming data eventfd
+    int inDataFD;
+    int inSpaceFD;
+    int outDataFD;
+    int outSpaceFD;
+
+    Segment* segment;
+    size_t mapSize;
+    ByteRing in;
+    ByteRing out;
+};
+}
+
+SHMConnection::SHMConnection()
+    : _impl( new detail::SHMConnection )
+{
+    ConnectionDescriptionPtr description = _getDescription();
+    description->type = CONNECTIONTYPE_SHM;
+    description->bandwidth = 4096000;
+}
+
+SHMConnection::~SHMConnection()
+{
+    _close();
+    delete _impl;
+}
+
+Connection::Notifier SHMConnection::getNotifier() const
+{
+    return isListening() ? _impl->socket : _impl->notifier;
+}
+
+bool SHMConnection::isLocal( ConstConnectionDescriptionPtr description )
+{
+    return description->type == CONNECTIONTYPE_SHM &&
+           description->getHostname() == _getHostname();
+}
+
+//----------------------------------------------------------------------
+// connect
+//----------------------------------------------------------------------
+bool SHMConnection::connect()
+{
+    ConstConnectionDescriptionPtr description = getDescription();
+    LBASSERT( description->type == CONNECTIONTYPE_SHM );
+    if( !isClosed( ))
+        return false;
+
+    _setState( STATE_CONNECTING );
+
+    sockaddr_un address;
+    const socklen_t length = _getAddress( description->getFilename(),
+                                          address );
+    _impl->socket = ::socket( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0 );
+    if( _impl->socket < 0 ||
+        ::connect( _impl->socket, reinterpret_cast< sockaddr* >( &address ),
+                   length ) != 0 )
+    {
+        LBINFO << "Can't connect to '" << description->getFilename()
+               << "': " << lunchbox::sysError << std::endl;
+        _close();
+        return false;
+    }
+
+    int fds[ FD_ALL ];
+    if( !_createSegment( fds ))
+    {
+        for( size_t i = 0; i < FD_ALL; ++i )
+            _closeFD( fds[ i ] );
+        _close();
+        return false;
+    }
+
+    // _setup takes ownership of the eventfds
+    const bool ok = _setup( fds, true ) && _sendFDs( _impl->socket, fds );
+    _closeFD( fds[ FD_SEGMENT ] );
+    if( !ok )
+    {
+        LBWARN << "Can't set up shared memory connection to '"
+               << description->getFilename() << "'" << std::endl;
+        _close();
+        return false;
+    }
+
+    _setState( STATE_CONNECTED );
+    LBINFO << "Connected " << description->toString() << std::endl;
+    return true;
+}
+
+bool SHMConnection::_setup( const int* fds, const bool connecting )
+{
+    _impl->unmap();
+    _impl->inDataFD = fds[ connecting ? FD_DATA1 : FD_DATA0 ];
+    _impl->inSpaceFD = fds[ connecting ? FD_SPACE1 : FD_SPACE0 ];
+    _impl->outDataFD = fds[ connecting ? FD_DATA0 : FD_DATA1 ];
+    _impl->outSpaceFD = fds[ connecting ? FD_SPACE0 : FD_SPACE1 ];
+    for( size_t i = FD_DATA0; i < FD_ALL; ++i )
+        if( fds[ i ] < 0 )
+            return false;
+
+    struct stat status;
+    if( ::fstat( fds[ FD_SEGMENT ], &status ) != 0 ||
+        size_t( status.st_size ) < sizeof( Segment ))
+    {
+        return false;
+    }
+
+    void* memory = ::mmap( 0, status.st_size, PROT_READ | PROT_WRITE,
+                           MAP_SHARED, fds[ FD_SEGMENT ], 0 );
+    if( memory == MAP_FAILED )
+    {
+        LBWARN << "Can't map shared memory segment: " << lunchbox::sysError
+               << std::endl;
+        return false;
+    }
+
+    Segment* segment = static_cast< Segment* >( memory );
+    _impl->segment = segment;
+    _impl->mapSize = status.st_size;
+
+    const uint64_t size = ( status.st_size - sizeof( Segment )) / 2;
+    if( connecting )
+    {
+        segment->size = size;
+        ByteRing::init( segment->rings[ 0 ] );
+        ByteRing::init( segment->rings[ 1 ] );
+    }
+    else if( segment->size != size || ( size & ( size - 1 )) != 0 )
+    {
+        LBWARN << "Invalid shared memory segment of " << status.st_size
+               << " bytes" << std::endl;
+        return false;
+    }
+
+    uint8_t* data = reinterpret_cast< uint8_t* >( segment + 1 );
+    _impl->in.setup( &segment->rings[ connecting ? 1 : 0 ],
+                     data + ( connecting ? size : 0 ), size,
+                     _impl->inDataFD, _impl->inSpaceFD );
+    _impl->out.setup( &segment->rings[ connecting ? 0 : 1 ],
+                      data + ( connecting ? 0 : size ), size,
+                      _impl->outDataFD, _impl->outSpaceFD );
+
+    _impl->notifier = ::epoll_create1( EPOLL_CLOEXEC );
+    if( _impl->notifier < 0 )
+        return false;
+
+    epoll_event event;
+    event.events = EPOLLIN;
+    event.data.fd = _impl->inDataFD;
+    if( ::epoll_ctl( _impl->notifier, EPOLL_CTL_ADD, _impl->inDataFD,
+                     &event ) != 0 )
+    {
+        return false;
+    }
+    event.events = EPOLLIN | EPOLLRDHUP;
+    event.data.fd = _impl->socket;
+    return ::epoll_ctl( _impl->notifier, EPOLL_CTL_ADD, _impl->socket,
+                        &event ) == 0;
+}
+
+//----------------------------------------------------------------------
+// listen
+//----------------------------------------------------------------------
+bool SHMConnection::listen()
+{
+    ConnectionDescriptionPtr description = _getDescription();
+    LBASSERT( description->type == CONNECTIONTYPE_SHM );
+    if( !isClosed( ))
+        return false;
+
+    _setState( STATE_CONNECTING );
+
+    if( description->getFilename().empty() ||
+        description->getFilename() == "default" )
+    {
+        std::ostringstream name;
+        name << "Collage." << UUID( true );
+        description->setFilename( name.str( ));
+    }
+    if( description->getHostname().empty( ))
+        description->setHostname( _getHostname( ));
+
+    sockaddr_un address;
+    const socklen_t length = _getAddress( description->getFilename(),
+                                          address );
+    _impl->socket = ::socket( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0 );
+    if( _impl->socket < 0 ||
+        ::bind( _impl->socket, reinterpret_cast< sockaddr* >( &address ),
+                length ) != 0 ||
+        ::listen( _impl->socket, SOMAXCONN ) != 0 )
+    {
+        LBWARN << "Can't listen on '" << description->getFilename() << "': "
+               << lunchbox::sysError << std::endl;
+        _close();
+        return false;
+    }
+
+    _setState( STATE_LISTENING );
+    LBINFO << "Listening on " << description->toString() << std::endl;
+    return true;
+}
+
+ConnectionPtr SHMConnection::acceptSync()
+{
+    if( !isListening( ))
+        return 0;
+
+    const int fd = ::accept4( _impl->socket, 0, 0, SOCK_CLOEXEC );
+    if( fd < 0 )
+    {
+        LBWARN << "Accept failed: " << lunchbox::sysError << std::endl;
+        return 0;
+    }
+
+    lunchbox::RefPtr< SHMConnection > connection = new SHMConnection;
+    ConstConnectionDescriptionPtr description = getDescription();
+    ConnectionDescriptionPtr newDescription = connection->_getDescription();
+    newDescription->bandwidth = description->bandwidth;
+    newDescription->setHostname( description->getHostname( ));
+    newDescription->setFilename( description->getFilename( ));
+
+    connection->_setState( STATE_CONNECTING );
+    connection->_impl->socket = fd;
+
+    int fds[ FD_ALL ] = { -1, -1, -1, -1, -1 };
+    const bool ok = _recvFDs( fd, fds ) && connection->_setup( fds, false );
+    _closeFD( fds[ FD_SEGMENT ] );
+    if( !ok )
+    {
+        LBWARN << "Can't set up shared memory connection on '"
+               << description->getFilename() << "'" << std::endl;
+        connection->_close();
+        return 0;
+    }
+
+    connection->_setState( STATE_CONNECTED );
+    LBINFO << "Accepted " << newDescription->toString() << std::endl;
+    return connection;
+}
+
+void SHMConnection::_close()
+{
+    if( isClosed( ))
+        return;
+
+    // Keep the segment mapped until destruction, another thread might still
+    // access it. The peer also notices a closed socket if we die.
+    if( _impl->segment )
+    {
+        _impl->in.close();
+        _impl->out.close();
+    }
+    _impl->closeFDs();
+    _setState( STATE_CLOSED );
+}
+
+//----------------------------------------------------------------------
+// read
+//----------------------------------------------------------------------
+int64_t SHMConnection::readSync( void* buffer, const uint64_t bytes,
+                                 const bool )
+{
+    if( !isConnected( ))
+        return -1;
+
+    for( ;; )
+    {
+        const uint64_t size = _impl->in.read( buffer, bytes );
+        if( size == ByteRing::CORRUPTED )
+        {
+            close();
+            return -1;
+        }
+        if( size > 0 )
+            return size;
+
+        if( _impl->isPeerClosed( ))
+        {
+            LBINFO << "Peer closed, closing " << getDescription()->toString()
+                   << std::endl;
+            close();
+            return -1;
+        }
+
+        const int result = _impl->wait( _impl->inDataFD );
+        if( result < 0 )
+        {
+            LBWARN << "Error during read: " << lunchbox::sysError << std::endl;
+            return -1;
+        }
+        if( result == 0 )
+            throw Exception( Exception::TIMEOUT_READ );
+    }
+}
+
+//----------------------------------------------------------------------
+// write
+//----------------------------------------------------------------------
+int64_t SHMConnection::write( const void* buffer, const uint64_t bytes )
+{
+    if( !isConnected( ) || _impl->out.isClosed( ))
+        return -1;
+
+    for( ;; )
+    {
+        const uint64_t size = _impl->out.write( buffer, bytes );
+        if( size == ByteRing::CORRUPTED )
+        {
+            close();
+            return -1;
+        }
+        if( size > 0 )
+            return size;
+
+        if( _impl->out.isClosed() || _impl->isPeerClosed( ))
+        {
+            LBINFO << "Peer closed during write" << std::endl;
+            return -1;
+        }
+
+        const int result = _impl->wait( _impl->outSpaceFD );
+        if( result < 0 )
+        {
+            LBWARN << "Write error: " << lunchbox::sysError << std::endl;
+            return -1;
+        }
+        if( result == 0 )
+            throw Exception( Exception::TIMEOUT_WRITE );
+    }
+}
+}
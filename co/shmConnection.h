@@ -0,0 +1,78 @@
+
+/* Copyright (c) 2026, The Collage Authors
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef CO_SHMCONNECTION_H
+#define CO_SHMCONNECTION_H
+
+#include <co/connection.h>
+
+namespace co
+{
+#ifndef __linux__
+#  error SHMConnection only supported on Linux
+#endif
+
+namespace detail { class SHMConnection; }
+
+/**
+ * A connection between two processes on the same host using shared memory.
+ *
+ * Each direction is a single-producer, single-consumer byte ring in a POSIX
+ * shared memory segment. The reader and a writer waiting for space are woken
+ * using eventfds, which are only signalled when the other side sleeps.
+ *
+ * The listener is a Unix domain socket named by the description's filename in
+ * the abstract namespace. The connecting side creates the segment and passes
+ * it together with the eventfds over this socket. The socket is kept open to
+ * detect when the peer closes or dies.
+ */
+class SHMConnection : public Connection
+{
+public:
+    SHMConnection();
+
+    virtual bool connect();
+    virtual bool listen();
+    virtual void close() { _close(); }
+
+    virtual void acceptNB() { /* nop */ }
+    virtual ConnectionPtr acceptSync();
+
+    virtual Notifier getNotifier() const;
+
+    /** @return true if the description names a listener on this host. */
+    static bool isLocal( ConstConnectionDescriptionPtr description );
+
+protected:
+    virtual ~SHMConnection();
+
+    virtual void readNB( void*, const uint64_t ) { /* NOP */ }
+    virtual int64_t readSync( void* buffer, const uint64_t bytes,
+                              const bool ignored );
+    virtual int64_t write( const void* buffer, const uint64_t bytes );
+
+private:
+    detail::SHMConnection* const _impl;
+
+    bool _setup( const int* fds, bool connecting );
+    void _close();
+};
+}
+
+#endif //CO_SHMCONNECTION_H
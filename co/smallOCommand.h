@@ -0,0 +1,115 @@
+
+/* Copyright (c) 2026, The Collage Authors
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef CO_SMALLOCOMMAND_H
+#define CO_SMALLOCOMMAND_H
+
+#include <co/commands.h>   // for COMMANDTYPE_NODE
+#include <co/connection.h> // used inline
+#include <co/node.h>       // used inline
+#include <lunchbox/nonCopyable.h>
+
+#include <string.h>
+
+namespace co
+{
+/**
+ * A stack-allocated builder for small commands.
+ *
+ * Produces the same bytes on the wire as an OCommand carrying the same plain
+ * data, without the data stream, its compressor and buffer allocation. Only
+ * commands smaller than COMMAND_MINSIZE can be built. The command is send
+ * during destruction, like an OCommand.
+ */
+class SmallOCommand : public lunchbox::NonCopyable
+{
+public:
+    /** Construct a command to be send on the given connection. */
+    SmallOCommand( ConnectionPtr connection, const uint32_t cmd,
+                   const uint32_t type = COMMANDTYPE_NODE )
+        : _connection( connection )
+        , _size( 0 )
+    {
+        LBASSERT( connection );
+        *this << uint64_t( 0 ) /* size */ << type << cmd;
+    }
+
+    /** Construct a command to be send to the given node, like Node::send. */
+    SmallOCommand( NodePtr node, const uint32_t cmd,
+                   const uint32_t type = COMMANDTYPE_NODE )
+        : _connection( node->_getConnection( false ))
+        , _size( 0 )
+    {
+        LBASSERT( _connection );
+        *this << uint64_t( 0 ) /* size */ << type << cmd;
+    }
+
+    /** Send the command, padded to COMMAND_MINSIZE if the peer needs it. */
+    ~SmallOCommand()
+    {
+        if( !_connection )
+            return;
+
+        uint8_t* bytes = reinterpret_cast< uint8_t* >( _data );
+        if( _connection->hasUnpaddedCommands( ))
+        {
+            _data[ 0 ] = _size | COMMAND_UNPADDED;
+            _connection->send( bytes, _size );
+            return;
+        }
+
+        _data[ 0 ] = _size;
+        ::memset( bytes + _size, 0, COMMAND_MINSIZE - _size );
+        _connection->send( bytes, COMMAND_MINSIZE );
+    }
+
+    /** Write a plain data item. */
+    template< class T > SmallOCommand& operator << ( const T& value )
+        { _write( &value, sizeof( value )); return *this; }
+
+    /** Write a std::string. */
+    SmallOCommand& operator << ( const std::string& value )
+    {
+        const uint64_t nElems = value.length();
+        _write( &nElems, sizeof( nElems ));
+        _write( value.c_str(), nElems );
+        return *this;
+    }
+
+private:
+    ConnectionPtr _connection;
+    uint64_t _size;
+    uint64_t _data[ COMMAND_MINSIZE / sizeof( uint64_t ) ];
+
+    void _write( const void* data, const uint64_t size )
+    {
+        LBASSERTINFO( _size + size <= COMMAND_MINSIZE,
+                      "Command too large, use OCommand" );
+        if( _size + size > COMMAND_MINSIZE )
+        {
+            _connection = 0; // do not send a truncated command
+            return;
+        }
+        ::memcpy( reinterpret_cast< uint8_t* >( _data ) + _size, data, size );
+        _size += size;
+    }
+};
+}
+
+#endif //CO_SMALLOCOMMAND_H
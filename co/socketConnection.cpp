@@ -24,8 +24,10 @@
 #include "exception.h"
 #include "global.h"
 
+#include <lunchbox/clock.h>
 #include <lunchbox/os.h>
 #include <lunchbox/log.h>
+#include <lunchbox/scopedMutex.h>
 #include <lunchbox/sleep.h>
 #include <co/exception.h>
 
@@ -45,11 +47,32 @@
 #  include <netdb.h>
 #  include <netinet/tcp.h>
 #  include <sys/errno.h>
+#  include <poll.h>
 #  include <sys/socket.h>
+#  include <unistd.h>
 #  ifndef AF_INET_SDP
 #    define AF_INET_SDP 27
 #  endif
 #endif
+#ifdef __linux__
+#  include <linux/errqueue.h>
+#  ifndef SO_BUSY_POLL
+#    define SO_BUSY_POLL 46
+#  endif
+#  ifndef SO_ZEROCOPY
+#    define SO_ZEROCOPY 60
+#  endif
+#  ifndef MSG_ZEROCOPY
+#    define MSG_ZEROCOPY 0x4000000
+#  endif
+#  ifndef SO_EE_ORIGIN_ZEROCOPY
+#    define SO_EE_ORIGIN_ZEROCOPY 5
+#  endif
+#  ifndef SO_EE_CODE_ZEROCOPY_COPIED
+#    define SO_EE_CODE_ZEROCOPY_COPIED 1
+#  endif
+#  define ZEROCOPY_WAIT_SLICE 1 /*ms*/
+#endif
 
 namespace co
 {
@@ -58,6 +81,12 @@ SocketConnection::SocketConnection( const ConnectionType type )
         : _overlappedAcceptData( 0 )
         , _overlappedSocket( INVALID_SOCKET )
         , _overlappedDone( 0 )
+#else
+        : _zeroCopyPinned( 0 )
+        , _zeroCopyBudget( 0 )
+        , _zeroCopySent( 0 )
+        , _zeroCopyDone( 0 )
+        , _zeroCopy( false )
 #endif
 {
 #ifdef _WIN32
@@ -106,6 +135,25 @@ static bool _parseAddress( ConstConnectionDescriptionPtr description,
            << ntohs( address.sin_port ) << std::endl;
     return true;
 }
+
+/** @return the socket buffer size, or 0 to leave it to the OS. */
+static int _getBufferSize( ConstConnectionDescriptionPtr description )
+{
+    const int32_t rtt =
+        Global::getIAttribute( Global::IATTR_TCPIP_BUFFER_RTT_US );
+    if( rtt > 0 ) // bandwidth-delay product, the bandwidth is in KB/s
+    {
+        const uint64_t size = uint64_t( LB_MAX( description->bandwidth, 0 )) *
+                              1024 * rtt / 1000000;
+        return int( LB_MIN( LB_MAX( size, uint64_t( LB_64KB )),
+                            uint64_t( 1 << 30 )));
+    }
+#ifdef _WIN32
+    return 128768;
+#else
+    return 0; // autotuned by the kernel
+#endif
+}
 }
 
 //----------------------------------------------------------------------
@@ -181,6 +229,9 @@ bool SocketConnection::connect()
     }
 
     _initAIORead();
+#ifndef _WIN32
+    _initZeroCopy();
+#endif
     _setState( STATE_CONNECTED );
     LBINFO << "Connected " << description->toString() << std::endl;
     return true;
@@ -259,6 +310,35 @@ void SocketConnection::_exitAIORead()
         _overlappedWrite.hEvent = 0;
     }
 }
+#elif defined CO_USE_LIBURING
+void SocketConnection::_initAIOAccept(){ /* NOP */ }
+void SocketConnection::_exitAIOAccept(){ /* NOP */ }
+
+void SocketConnection::_initAIORead()
+{
+    if( Global::getIAttribute( Global::IATTR_TCPIP_IO_URING ))
+        _read = IORing::newRead();
+}
+
+void SocketConnection::_exitAIORead()
+{
+    if( !_read )
+        return;
+
+    // Complete a pending receive. The queued requests name the socket by its
+    // descriptor, hand it over to them and close a duplicate instead.
+    ::shutdown( _readFD, SHUT_RDWR );
+    const Socket fd = ::dup( _readFD );
+    if( fd == INVALID_SOCKET )
+        LBWARN << "Can't duplicate socket: " << lunchbox::sysError << std::endl;
+    else
+    {
+        IORing::release( *_read, _readFD );
+        _readFD = fd;
+        _writeFD = fd;
+    }
+    _read = 0;
+}
 #else
 void SocketConnection::_initAIOAccept(){ /* NOP */ }
 void SocketConnection::_exitAIOAccept(){ /* NOP */ }
@@ -399,6 +479,8 @@ ConnectionPtr SocketConnection::acceptSync()
 
     newConnection->_readFD      = fd;
     newConnection->_writeFD     = fd;
+    newConnection->_initAIORead();
+    newConnection->_initZeroCopy();
     newConnection->_setState( STATE_CONNECTED );
     ConnectionDescriptionPtr newDescription = newConnection->_getDescription();
     newDescription->bandwidth = description->bandwidth;
@@ -414,6 +496,247 @@ ConnectionPtr SocketConnection::acceptSync()
 #endif // !_WIN32
 
 
+#ifdef CO_USE_LIBURING
+//----------------------------------------------------------------------
+// io_uring read
+//----------------------------------------------------------------------
+Connection::Notifier SocketConnection::getNotifier() const
+{
+    return _read ? _read->getNotifier() : _readFD;
+}
+
+void SocketConnection::readNB( void* buffer, const uint64_t bytes )
+{
+    if( _read && !isClosed( ))
+        IORing::queue( _read, _readFD, buffer, bytes );
+}
+
+int64_t SocketConnection::_readRing( IORing::Read& read, const uint64_t bytes,
+                                     const bool block )
+{
+    if( !IORing::wait( read, block ))
+        return READ_TIMEOUT;
+
+    const int64_t result = read.getResult();
+    if( result > 0 )
+        return result;
+
+    if( result == 0 ) // EOF
+    {
+        LBINFO << "Got EOF, closing " << getDescription()->toString()
+               << std::endl;
+        close();
+        return -1;
+    }
+
+    if( result == -EINTR ) // if interrupted, try again
+        return 0;
+
+    LBWARN << "Error during read: " << strerror( -result ) << ", " << bytes
+           << "b on fd " << _readFD << std::endl;
+    return -1;
+}
+#endif
+
+#ifndef _WIN32
+//----------------------------------------------------------------------
+// read
+//----------------------------------------------------------------------
+int64_t SocketConnection::readSync( void* buffer, const uint64_t bytes,
+                                    const bool block )
+{
+#ifdef CO_USE_LIBURING
+    IORing::ReadPtr read = _read; // may be released by close()
+    const int64_t got = read ? _readRing( *read, bytes, block ) :
+                               FDConnection::readSync( buffer, bytes, block );
+#else
+    const int64_t got = FDConnection::readSync( buffer, bytes, block );
+#endif
+
+#ifdef __linux__
+    // Quick ack mode is left by the kernel on its own, re-enable it
+    if( got > 0 && Global::getIAttribute( Global::IATTR_TCPIP_QUICKACK ))
+    {
+        const int on = 1;
+        setsockopt( _readFD, IPPROTO_TCP, TCP_QUICKACK, &on, sizeof( on ));
+    }
+#endif
+    return got;
+}
+
+//----------------------------------------------------------------------
+// write
+//----------------------------------------------------------------------
+int64_t SocketConnection::write( const void* buffer, const uint64_t bytes )
+{
+    const int32_t zeroCopySize =
+        Global::getIAttribute( Global::IATTR_TCPIP_ZEROCOPY_SIZE );
+    if( _zeroCopy && zeroCopySize > 0 && bytes >= uint64_t( zeroCopySize ))
+        return _writeZeroCopy( buffer, bytes );
+    return FDConnection::write( buffer, bytes );
+}
+
+#ifdef __linux__
+void SocketConnection::_initZeroCopy()
+{
+    if( Global::getIAttribute( Global::IATTR_TCPIP_ZEROCOPY_SIZE ) <= 0 )
+        return;
+
+    const int on = 1;
+    if( setsockopt( _writeFD, SOL_SOCKET, SO_ZEROCOPY, &on, sizeof( on )) != 0 )
+    {
+        LBINFO << "Can't enable zero copy send: " << lunchbox::sysError
+               << std::endl;
+        return;
+    }
+
+    // Pin at most twice the send buffer, the kernel can't queue more anyway
+    int size = 0;
+    socklen_t length = sizeof( size );
+    if( getsockopt( _writeFD, SOL_SOCKET, SO_SNDBUF, &size, &length ) != 0 )
+        size = 0;
+    _zeroCopyBudget = LB_MAX( 2 * uint64_t( size ), uint64_t( LB_1MB ));
+    _zeroCopy = true;
+}
+
+int64_t SocketConnection::_writeZeroCopy( const void* buffer,
+                                          const uint64_t bytes )
+{
+    if( !isConnected() || _writeFD < 1 )
+        return -1;
+
+    // Send at most half of the budget at once, so that the next send overlaps
+    // with the completion of the previous one.
+    const uint64_t size = LB_MIN( bytes, _zeroCopyBudget / 2 );
+    if( !_waitZeroCopy( _zeroCopyBudget - size ))
+        return -1;
+
+    const ssize_t sent = ::send( _writeFD, buffer, size, MSG_ZEROCOPY );
+    if( sent < 0 )
+    {
+        if( errno == ENOBUFS ) // out of pinned memory
+            return FDConnection::write( buffer, bytes );
+        if( errno == EINTR ) // if interrupted, try again
+            return 0;
+
+        LBWARN << "Error during write: " << lunchbox::sysError << std::endl;
+        return -1;
+    }
+    {
+        lunchbox::ScopedMutex<> mutex( _zeroCopyLock );
+        ++_zeroCopySent;
+        _zeroCopySizes.push_back( sent );
+        _zeroCopyPinned = _zeroCopyPinned.get() + sent;
+        if( _reapZeroCopy() < 0 )
+            return -1;
+    }
+
+    // The caller may reuse the buffer once it has been written, wait until the
+    // kernel released its pages.
+    if( uint64_t( sent ) == bytes && !_waitZeroCopy( 0 ))
+        return -1;
+    return sent;
+}
+
+bool SocketConnection::reapZeroCopy()
+{
+    lunchbox::ScopedMutex<> mutex( _zeroCopyLock );
+    return _reapZeroCopy() > 0;
+}
+
+bool SocketConnection::_waitZeroCopy( const uint64_t pinned )
+{
+    const uint32_t timeout = Global::getTimeout();
+    lunchbox::Clock clock;
+    while( true )
+    {
+        {
+            lunchbox::ScopedMutex<> mutex( _zeroCopyLock );
+            if( _reapZeroCopy() < 0 )
+                return false;
+            if( _zeroCopyPinned <= pinned )
+                return true;
+        }
+
+        // The ConnectionSet watching the socket reaps completions and signals
+        // them. Completions of unwatched sockets are reaped above after each
+        // wait slice.
+        if( _zeroCopyPinned.timedWaitLE( pinned, ZEROCOPY_WAIT_SLICE ))
+            return true;
+        if( timeout != LB_TIMEOUT_INDEFINITE && clock.getTime64() > timeout )
+            throw Exception( Exception::TIMEOUT_WRITE );
+    }
+}
+
+int SocketConnection::_reapZeroCopy()
+{
+    int reaped = 0;
+    while( true )
+    {
+        char control[ CMSG_SPACE( sizeof( sock_extended_err )) + 64 ];
+        msghdr message;
+        memset( &message, 0, sizeof( message ));
+        message.msg_control = control;
+        message.msg_controllen = sizeof( control );
+        if( ::recvmsg( _writeFD, &message, MSG_ERRQUEUE | MSG_DONTWAIT ) < 0 )
+        {
+            if( errno == EAGAIN || errno == EWOULDBLOCK )
+                return reaped;
+            if( errno == EINTR )
+                continue;
+            LBWARN << "Can't read zero copy completion: " << lunchbox::sysError
+                   << std::endl;
+            return -1;
+        }
+
+        const cmsghdr* header = CMSG_FIRSTHDR( &message );
+        const sock_extended_err* error = header ?
+            reinterpret_cast< const sock_extended_err* >( CMSG_DATA( header )) :
+            0;
+        if( !error || error->ee_origin != SO_EE_ORIGIN_ZEROCOPY ||
+            error->ee_errno != 0 )
+        {
+            LBWARN << "Socket error on " << getDescription()->toString()
+                   << ": " << ( error ? strerror( error->ee_errno ) : "unknown" )
+                   << std::endl;
+            return -1;
+        }
+
+        // completions cover the send range [ee_info, ee_data]
+        const uint32_t done = error->ee_data + 1;
+        uint64_t pinned = _zeroCopyPinned.get();
+        while( int32_t( done - _zeroCopyDone ) > 0 && !_zeroCopySizes.empty( ))
+        {
+            pinned -= _zeroCopySizes.front();
+            _zeroCopySizes.pop_front();
+            ++_zeroCopyDone;
+        }
+        _zeroCopyPinned = pinned; // wakes waiting senders
+        ++reaped;
+
+        if( error->ee_code & SO_EE_CODE_ZEROCOPY_COPIED && _zeroCopy )
+        {
+            LBINFO << "Kernel copies zero copy sends on "
+                   << getDescription()->toString() << ", disabling them"
+                   << std::endl;
+            _zeroCopy = false;
+        }
+    }
+}
+#else
+void SocketConnection::_initZeroCopy(){ /* NOP */ }
+
+int64_t SocketConnection::_writeZeroCopy( const void* buffer,
+                                          const uint64_t bytes )
+{
+    return FDConnection::write( buffer, bytes );
+}
+
+bool SocketConnection::reapZeroCopy() { return false; }
+bool SocketConnection::_waitZeroCopy( const uint64_t ) { return true; }
+int SocketConnection::_reapZeroCopy() { return 0; }
+#endif // __linux__
+#endif // !_WIN32
 
 #ifdef _WIN32
 //----------------------------------------------------------------------
@@ -619,12 +942,24 @@ void SocketConnection::_tuneSocket( const Socket fd )
     setsockopt( fd, SOL_SOCKET, SO_REUSEADDR,
                 reinterpret_cast<const char*>( &on ), sizeof( on ));
 
-#ifdef _WIN32
-    const int size = 128768;
-    setsockopt( fd, SOL_SOCKET, SO_RCVBUF,
-                reinterpret_cast<const char*>( &size ), sizeof( size ));
-    setsockopt( fd, SOL_SOCKET, SO_SNDBUF,
-                reinterpret_cast<const char*>( &size ), sizeof( size ));
+    const int size = _getBufferSize( getDescription( ));
+    if( size > 0 )
+    {
+        setsockopt( fd, SOL_SOCKET, SO_RCVBUF,
+                    reinterpret_cast<const char*>( &size ), sizeof( size ));
+        setsockopt( fd, SOL_SOCKET, SO_SNDBUF,
+                    reinterpret_cast<const char*>( &size ), sizeof( size ));
+    }
+
+#ifdef __linux__
+    const int busyPoll =
+        Global::getIAttribute( Global::IATTR_TCPIP_BUSY_POLL_US );
+    if( busyPoll > 0 && setsockopt( fd, SOL_SOCKET, SO_BUSY_POLL, &busyPoll,
+                                    sizeof( busyPoll )) != 0 )
+    {
+        LBINFO << "Can't enable busy polling: " << lunchbox::sysError
+               << std::endl;
+    }
 #endif
 }
 
@@ -23,6 +23,8 @@
 #include <co/connectionType.h> // enum
 #include <lunchbox/api.h>
 #include <lunchbox/buffer.h> // member
+#include <lunchbox/lock.h> // member
+#include <lunchbox/monitor.h> // member
 #include <lunchbox/os.h>
 #include <lunchbox/thread.h> // for LB_TS_VAR
 
@@ -32,6 +34,10 @@
 #else
 #  include "fdConnection.h"
 #  include <netinet/in.h>
+#  include <deque>
+#  ifdef CO_USE_LIBURING
+#    include "ioRing.h"
+#  endif
 #endif
 
 
@@ -64,6 +70,18 @@ namespace co
 #ifdef WIN32
         /** @sa Connection::getNotifier */
         virtual Notifier getNotifier() const { return _overlappedRead.hEvent; }
+#elif defined CO_USE_LIBURING
+        /** @sa Connection::getNotifier */
+        virtual Notifier getNotifier() const;
+#endif
+#ifndef WIN32
+        /**
+         * @internal Reap the completed zero copy sends without blocking.
+         *
+         * @return true if completions were reaped, false if the error queue
+         *         was empty or held a socket error.
+         */
+        bool reapZeroCopy();
 #endif
 
     protected:
@@ -77,6 +95,13 @@ namespace co
 
         typedef UINT_PTR Socket;
 #else
+#  ifdef CO_USE_LIBURING
+        virtual void readNB( void* buffer, const uint64_t bytes );
+#  endif
+        virtual int64_t readSync( void* buffer, const uint64_t bytes,
+                                  const bool block );
+        virtual int64_t write( const void* buffer, const uint64_t bytes );
+
         //! @cond IGNORE
         typedef int    Socket;
         enum
@@ -87,6 +112,8 @@ namespace co
 #endif
 
     private:
+        friend class StripedConnection; // uses the sockets of its streams
+
         void _initAIOAccept();
         void _exitAIOAccept();
         void _initAIORead();
@@ -111,6 +138,23 @@ namespace co
         DWORD      _overlappedDone;
 
         LB_TS_VAR( _recvThread );
+#else
+#  ifdef CO_USE_LIBURING
+        IORing::ReadPtr _read; //!< io_uring receive, 0 if not used
+        int64_t _readRing( IORing::Read& read, uint64_t bytes, bool block );
+#  endif
+        lunchbox::Lock _zeroCopyLock; //!< sender and ConnectionSet reap
+        std::deque< uint64_t > _zeroCopySizes; //!< uncompleted sends
+        lunchbox::Monitor< uint64_t > _zeroCopyPinned; //!< uncompleted bytes
+        uint64_t _zeroCopyBudget; //!< maximum of pinned bytes
+        uint32_t _zeroCopySent; //!< MSG_ZEROCOPY sends issued
+        uint32_t _zeroCopyDone; //!< MSG_ZEROCOPY sends completed
+        bool _zeroCopy;
+
+        void _initZeroCopy();
+        int64_t _writeZeroCopy( const void* buffer, uint64_t bytes );
+        bool _waitZeroCopy( uint64_t pinned );
+        int _reapZeroCopy(); // call with _zeroCopyLock held
 #endif
 
         void _close();
@@ -0,0 +1,855 @@
+
+/* Copyright (c) 2026, The Collage Authors
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "stripedConnection.h"
+
+#include "connectionDescription.h"
+#include "exception.h"
+#include "global.h"
+#include "log.h"
+#include "socketConnection.h"
+
+#include <lunchbox/clock.h>
+#include <lunchbox/os.h>
+
+#include <algorithm>
+#include <errno.h>
+#include <list>
+#include <map>
+#include <poll.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#define MAX_STREAMS 64
+
+namespace co
+{
+namespace
+{
+const uint64_t _magic = 0x436f5374726970ull; // "CoStrip"
+const uint64_t _stripedBit = 1ull << 63;
+
+/** Sent first on each socket, to group the sockets on the accepting side. */
+struct Hello
+{
+    uint64_t magic;
+    uint64_t idHigh;   //!< identifier of the connection
+    uint64_t idLow;
+    uint32_t index;    //!< 0 for the control socket
+    uint32_t nStreams; //!< number of data sockets
+};
+
+int _getTimeout()
+{
+    const uint32_t timeout = Global::getTimeout();
+    return timeout == LB_TIMEOUT_INDEFINITE ? -1 : int( timeout );
+}
+
+uint32_t _getNStreams()
+{
+    const int32_t nStreams =
+        Global::getIAttribute( Global::IATTR_STRIPED_STREAMS );
+    return uint32_t( LB_MIN( LB_MAX( nStreams, 1 ), MAX_STREAMS ));
+}
+
+/** @return the start of stripe i of n of a write. */
+uint64_t _getStripeStart( const uint64_t bytes, const size_t i,
+                          const size_t n )
+{
+    return bytes * i / n;
+}
+
+/**
+ * Receive up to bytes from a socket.
+ * @return the bytes received, 0 on EOF, -1 on error.
+ * @throw Exception on timeout.
+ */
+int64_t _recv( const int fd, void* buffer, const uint64_t bytes )
+{
+    for( ;; )
+    {
+        const ssize_t result = ::recv( fd, buffer, bytes, MSG_DONTWAIT );
+        if( result >= 0 )
+            return result;
+        if( errno == EINTR )
+            continue;
+        if( errno != EAGAIN && errno != EWOULDBLOCK )
+        {
+            LBWARN << "Error during read: " << lunchbox::sysError << std::endl;
+            return -1;
+        }
+
+        pollfd pollFD = { fd, POLLIN, 0 };
+        const int ready = ::poll( &pollFD, 1, _getTimeout( ));
+        if( ready == 0 )
+            throw Exception( Exception::TIMEOUT_READ );
+        if( ready < 0 && errno != EINTR )
+        {
+            LBWARN << "Error during read: " << lunchbox::sysError << std::endl;
+            return -1;
+        }
+    }
+}
+
+/** Receive exactly bytes, @return false on EOF or error. */
+bool _recvAll( const int fd, void* buffer, const uint64_t bytes )
+{
+    uint8_t* ptr = static_cast< uint8_t* >( buffer );
+    uint64_t left = bytes;
+    while( left > 0 )
+    {
+        const int64_t result = _recv( fd, ptr, left );
+        if( result <= 0 )
+            return false;
+        ptr += result;
+        left -= result;
+    }
+    return true;
+}
+
+/** Send the given buffers completely, @return false on error. */
+bool _sendAll( const int fd, iovec* iov, size_t count )
+{
+    while( count > 0 )
+    {
+        msghdr message;
+        ::memset( &message, 0, sizeof( message ));
+        message.msg_iov = iov;
+        message.msg_iovlen = count;
+
+        const ssize_t result = ::sendmsg( fd, &message, MSG_NOSIGNAL );
+        if( result < 0 )
+        {
+            if( errno == EINTR )
+                continue;
+            LBWARN << "Write error: " << lunchbox::sysError << std::endl;
+            return false;
+        }
+
+        size_t sent = result;
+        while( count > 0 && sent >= iov->iov_len )
+        {
+            sent -= iov->iov_len;
+            ++iov;
+            --count;
+        }
+        if( count > 0 )
+        {
+            iov->iov_base = static_cast< uint8_t* >( iov->iov_base ) + sent;
+            iov->iov_len -= sent;
+        }
+    }
+    return true;
+}
+
+ConnectionDescriptionPtr _getTCPDescription(
+    ConstConnectionDescriptionPtr description )
+{
+    ConnectionDescriptionPtr tcp = new ConnectionDescription;
+    tcp->type = CONNECTIONTYPE_TCPIP;
+    tcp->port = description->port;
+    tcp->setHostname( description->getHostname( ));
+    tcp->setInterface( description->getInterface( ));
+    return tcp;
+}
+}
+
+namespace detail
+{
+class StripedConnection
+{
+public:
+    /** An accepted socket, until its hello has been received. */
+    struct Accepted
+    {
+        ConnectionPtr stream;
+        Hello hello;
+        int socket;
+        size_t received; //!< bytes of the hello
+        int64_t time;    //!< of the accept
+    };
+    typedef std::list< Accepted > AcceptedList;
+
+    /** The identified sockets of a connection being accepted. */
+    struct Partial
+    {
+        Connections streams;
+        int64_t time; //!< of the first socket
+    };
+    typedef std::map< uint128_t, Partial > Pending;
+
+    StripedConnection()
+        : notifier( -1 )
+        , armed( -1 )
+        , size( 0 )
+        , remaining( 0 )
+        , stripe( 0 )
+        , stripeLeft( 0 )
+        , striped( false )
+    {}
+
+    size_t getNStripes() const { return sockets.size() - 1; }
+
+    /**
+     * Receive the available part of the hello of an accepted socket.
+     *
+     * Moves the socket to its pending connection once the hello is complete,
+     * and closes it on errors.
+     *
+     * @return all sockets of the connection, if it is complete.
+     */
+    Connections receiveHello( AcceptedList::iterator i )
+    {
+        Accepted& entry = *i;
+        uint8_t* data = reinterpret_cast< uint8_t* >( &entry.hello );
+        const ssize_t result = ::recv( entry.socket, data + entry.received,
+                                       sizeof( Hello ) - entry.received,
+                                       MSG_DONTWAIT );
+        if( result < 0 && ( errno == EAGAIN || errno == EWOULDBLOCK ||
+                            errno == EINTR ))
+        {
+            return Connections();
+        }
+        if( result > 0 )
+            entry.received += result;
+
+        const bool complete = entry.received == sizeof( Hello );
+        if( !complete && result > 0 )
+            return Connections();
+        ::epoll_ctl( notifier, EPOLL_CTL_DEL, entry.socket, 0 );
+
+        const Hello& hello = entry.hello;
+        if( !complete || hello.magic != _magic || hello.nStreams == 0 ||
+            hello.nStreams > MAX_STREAMS || hello.index > hello.nStreams )
+        {
+            LBWARN << "Invalid striped connection handshake" << std::endl;
+            entry.stream->close();
+            accepted.erase( i );
+            return Connections();
+        }
+
+        const uint128_t id( hello.idHigh, hello.idLow );
+        Pending::iterator j = pending.find( id );
+        if( j == pending.end( ))
+        {
+            j = pending.insert( std::make_pair( id, Partial( ))).first;
+            j->second.streams.resize( hello.nStreams + 1 );
+            j->second.time = entry.time;
+        }
+
+        Connections& streams = j->second.streams;
+        if( streams.size() != hello.nStreams + 1 || streams[ hello.index ] )
+        {
+            LBWARN << "Invalid striped connection handshake" << std::endl;
+            entry.stream->close();
+            accepted.erase( i );
+            return Connections();
+        }
+        streams[ hello.index ] = entry.stream;
+        accepted.erase( i );
+
+        if( std::find( streams.begin(), streams.end(), ConnectionPtr( )) !=
+            streams.end( ))
+        {
+            return Connections();
+        }
+
+        const Connections all = streams;
+        pending.erase( j );
+        return all;
+    }
+
+    /** Close the sockets of handshakes older than the keepalive timeout. */
+    void expire()
+    {
+        const int64_t timeout = Global::getKeepaliveTimeout();
+        const int64_t time = clock.getTime64();
+
+        for( AcceptedList::iterator i = accepted.begin();
+             i != accepted.end(); )
+        {
+            if( time - i->time < timeout )
+            {
+                ++i;
+                continue;
+            }
+            LBINFO << "Timeout waiting for the hello of a striped connection"
+                   << std::endl;
+            ::epoll_ctl( notifier, EPOLL_CTL_DEL, i->socket, 0 );
+            i->stream->close();
+            i = accepted.erase( i );
+        }
+
+        for( Pending::iterator i = pending.begin(); i != pending.end(); )
+        {
+            if( time - i->second.time < timeout )
+            {
+                ++i;
+                continue;
+            }
+            LBINFO << "Timeout waiting for the streams of a striped connection"
+                   << std::endl;
+            const Connections& streams = i->second.streams;
+            for( Connections::const_iterator j = streams.begin();
+                 j != streams.end(); ++j )
+            {
+                if( *j )
+                    (*j)->close();
+            }
+            pending.erase( i++ );
+        }
+    }
+
+    /** @return the socket carrying the next bytes of the stream. */
+    int getNextSocket()
+    {
+        if( remaining == 0 || !striped )
+            return sockets.front();
+
+        while( stripeLeft == 0 ) // empty stripes of small messages
+        {
+            ++stripe;
+            stripeLeft = getStripeSize( stripe );
+        }
+        return sockets[ stripe + 1 ];
+    }
+
+    /**
+     * Let the notifier only signal data on the given socket.
+     *
+     * Data on the other sockets, e.g., a stripe arriving before its header,
+     * is not signalled until it is read. Hangups and errors are signalled for
+     * all sockets.
+     */
+    bool arm( const int fd )
+    {
+        if( fd == armed )
+            return true;
+
+        epoll_event event;
+        event.events = 0;
+        event.data.fd = armed;
+        if( armed >= 0 &&
+            ::epoll_ctl( notifier, EPOLL_CTL_MOD, armed, &event ) != 0 )
+        {
+            return false;
+        }
+
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.fd = fd;
+        if( ::epoll_ctl( notifier, EPOLL_CTL_MOD, fd, &event ) != 0 )
+            return false;
+        armed = fd;
+        return true;
+    }
+
+    /** @return true if a socket other than the armed one hung up. */
+    bool hasHangup() const
+    {
+        epoll_event events[ MAX_STREAMS + 1 ];
+        const int nEvents = ::epoll_wait( notifier, events, MAX_STREAMS + 1,
+                                          0 );
+        for( int i = 0; i < nEvents; ++i )
+            if( events[ i ].data.fd != armed &&
+                events[ i ].events & ( EPOLLHUP | EPOLLERR ))
+            {
+                return true;
+            }
+        return false;
+    }
+
+    /** @return the size of the given stripe of the current message. */
+    uint64_t getStripeSize( const size_t i ) const
+    {
+        const size_t n = getNStripes();
+        return _getStripeStart( size, i + 1, n ) -
+               _getStripeStart( size, i, n );
+    }
+
+    ConnectionPtr listener;
+    AcceptedList accepted;
+    Pending pending;
+    lunchbox::Clock clock;
+
+    Connections streams;       //!< the control stream, then the data streams
+    std::vector< int > sockets; //!< of the streams
+    int notifier;               //!< epoll set of all sockets
+    int armed;                  //!< the socket signalling data
+
+    // the message currently received
+    uint64_t size;
+    uint64_t remaining;
+    size_t stripe;
+    uint64_t stripeLeft; //!< in the current stripe
+    bool striped;
+};
+}
+
+StripedConnection::StripedConnection()
+    : _impl( new detail::StripedConnection )
+{
+    ConnectionDescriptionPtr description = _getDescription();
+    description->type = CONNECTIONTYPE_STRIPED;
+    description->bandwidth = 102400 * _getNStreams();
+}
+
+StripedConnection::~StripedConnection()
+{
+    _close();
+    delete _impl;
+}
+
+Connection::Notifier StripedConnection::getNotifier() const
+{
+    return _impl->notifier;
+}
+
+int StripedConnection::_getSocket( ConnectionPtr stream )
+{
+    return static_cast< SocketConnection* >( stream.get( ))->_readFD;
+}
+
+//----------------------------------------------------------------------
+// connect
+//----------------------------------------------------------------------
+bool StripedConnection::connect()
+{
+    ConstConnectionDescriptionPtr description = getDescription();
+    LBASSERT( description->type == CONNECTIONTYPE_STRIPED );
+    if( !isClosed() || description->port == 0 )
+        return false;
+
+    _setState( STATE_CONNECTING );
+
+    const UUID id( true );
+    Hello hello;
+    hello.magic = _magic;
+    hello.idHigh = id.high();
+    hello.idLow = id.low();
+    hello.nStreams = _getNStreams();
+
+    Connections streams;
+    for( uint32_t i = 0; i <= hello.nStreams; ++i )
+    {
+        ConnectionPtr stream =
+            Connection::create( _getTCPDescription( description ));
+        hello.index = i;
+        if( !stream || !stream->connect() ||
+            !stream->send( &hello, sizeof( hello )))
+        {
+            LBINFO << "Can't connect stream " << i << " to "
+                   << description->getHostname() << ":" << description->port
+                   << std::endl;
+            for( size_t j = 0; j < streams.size(); ++j )
+                streams[ j ]->close();
+            _setState( STATE_CLOSED );
+            return false;
+        }
+        streams.push_back( stream );
+    }
+
+    if( !_setup( streams ))
+    {
+        LBWARN << "Can't set up striped connection to "
+               << description->getHostname() << ":" << description->port
+               << std::endl;
+        _close();
+        return false;
+    }
+
+    _setState( STATE_CONNECTED );
+    LBINFO << "Connected " << description->toString() << std::endl;
+    return true;
+}
+
+bool StripedConnection::_setup( const Connections& streams )
+{
+    _impl->streams = streams;
+    _impl->notifier = ::epoll_create1( EPOLL_CLOEXEC );
+    if( _impl->notifier < 0 )
+        return false;
+
+    for( Connections::const_iterator i = streams.begin();
+         i != streams.end(); ++i )
+    {
+        const int fd = _getSocket( *i );
+        _impl->sockets.push_back( fd );
+
+        epoll_event event;
+        event.events = 0;
+        event.data.fd = fd;
+        if( ::epoll_ctl( _impl->notifier, EPOLL_CTL_ADD, fd, &event ) != 0 )
+            return false;
+    }
+    return _impl->arm( _impl->sockets.front( ));
+}
+
+//----------------------------------------------------------------------
+// listen
+//----------------------------------------------------------------------
+bool StripedConnection::listen()
+{
+    ConnectionDescriptionPtr description = _getDescription();
+    LBASSERT( description->type == CONNECTIONTYPE_STRIPED );
+    if( !isClosed( ))
+        return false;
+
+    _setState( STATE_CONNECTING );
+
+    ConnectionDescriptionPtr tcp = _getTCPDescription( description );
+    _impl->listener = Connection::create( tcp );
+    if( !_impl->listener || !_impl->listener->listen( ))
+    {
+        LBWARN << "Can't listen on " << description->toString() << std::endl;
+        _impl->listener = 0;
+        _setState( STATE_CLOSED );
+        return false;
+    }
+    description->port = tcp->port;
+
+    // Signals new sockets on the listener and hellos on accepted sockets
+    _impl->notifier = ::epoll_create1( EPOLL_CLOEXEC );
+    epoll_event event;
+    event.events = EPOLLIN;
+    event.data.fd = _impl->listener->getNotifier();
+    if( _impl->notifier < 0 ||
+        ::epoll_ctl( _impl->notifier, EPOLL_CTL_ADD, event.data.fd,
+                     &event ) != 0 )
+    {
+        LBWARN << "Can't create listener notifier: " << lunchbox::sysError
+               << std::endl;
+        _close();
+        return false;
+    }
+
+    _setState( STATE_LISTENING );
+    LBINFO << "Listening on " << description->toString() << std::endl;
+    return true;
+}
+
+void StripedConnection::acceptNB()
+{
+    if( isListening( ))
+        _impl->listener->acceptNB();
+}
+
+ConnectionPtr StripedConnection::acceptSync()
+{
+    if( !isListening( ))
+        return 0;
+
+    _impl->expire();
+
+    // Sockets with incomplete hellos signal the notifier until they are read,
+    // therefore handle at most one new connection per call.
+    detail::StripedConnection::AcceptedList& accepted = _impl->accepted;
+    for( detail::StripedConnection::AcceptedList::iterator i =
+             accepted.begin(); i != accepted.end(); )
+    {
+        const Connections streams = _impl->receiveHello( i++ );
+        if( !streams.empty( ))
+            return _newConnection( streams );
+    }
+
+    pollfd pollFD = { _impl->listener->getNotifier(), POLLIN, 0 };
+    while( ::poll( &pollFD, 1, 0 ) == 1 )
+    {
+        ConnectionPtr stream = _impl->listener->acceptSync();
+        _impl->listener->acceptNB();
+        if( !stream )
+            return 0;
+
+        detail::StripedConnection::Accepted entry;
+        entry.stream = stream;
+        entry.socket = _getSocket( stream );
+        entry.received = 0;
+        entry.time = _impl->clock.getTime64();
+
+        epoll_event event;
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.fd = entry.socket;
+        if( ::epoll_ctl( _impl->notifier, EPOLL_CTL_ADD, entry.socket,
+                         &event ) != 0 )
+        {
+            LBWARN << "Can't watch striped connection socket: "
+                   << lunchbox::sysError << std::endl;
+            stream->close();
+            continue;
+        }
+
+        const Connections streams = _impl->receiveHello(
+            accepted.insert( accepted.end(), entry ));
+        if( !streams.empty( ))
+            return _newConnection( streams );
+    }
+    return 0;
+}
+
+ConnectionPtr StripedConnection::_newConnection( const Connections& streams )
+{
+    lunchbox::RefPtr< StripedConnection > connection = new StripedConnection;
+    ConstConnectionDescriptionPtr description = getDescription();
+    ConnectionDescriptionPtr newDescription = connection->_getDescription();
+    newDescription->bandwidth = description->bandwidth;
+    newDescription->port = description->port;
+    newDescription->setHostname(
+        streams.front()->getDescription()->getHostname( ));
+
+    connection->_setState( STATE_CONNECTING );
+    if( !connection->_setup( streams ))
+    {
+        LBWARN << "Can't set up striped connection" << std::endl;
+        connection->_close();
+        return 0;
+    }
+
+    connection->_setState( STATE_CONNECTED );
+    LBINFO << "Accepted " << newDescription->toString() << std::endl;
+    return connection;
+}
+
+void StripedConnection::_close()
+{
+    if( isClosed( ))
+        return;
+
+    if( _impl->listener )
+        _impl->listener->close();
+    _impl->listener = 0;
+
+    for( detail::StripedConnection::AcceptedList::const_iterator i =
+             _impl->accepted.begin(); i != _impl->accepted.end(); ++i )
+    {
+        i->stream->close();
+    }
+    _impl->accepted.clear();
+
+    for( detail::StripedConnection::Pending::const_iterator i =
+             _impl->pending.begin(); i != _impl->pending.end(); ++i )
+    {
+        const Connections& streams = i->second.streams;
+        for( Connections::const_iterator j = streams.begin();
+             j != streams.end(); ++j )
+        {
+            if( *j )
+                (*j)->close();
+        }
+    }
+    _impl->pending.clear();
+
+    for( Connections::const_iterator i = _impl->streams.begin();
+         i != _impl->streams.end(); ++i )
+    {
+        (*i)->close();
+    }
+    _impl->streams.clear();
+    _impl->sockets.clear();
+
+    if( _impl->notifier >= 0 )
+        ::close( _impl->notifier );
+    _impl->notifier = -1;
+    _impl->armed = -1;
+    _impl->remaining = 0;
+    _setState( STATE_CLOSED );
+}
+
+//----------------------------------------------------------------------
+// read
+//----------------------------------------------------------------------
+int64_t StripedConnection::readSync( void* buffer, const uint64_t bytes,
+                                     const bool block )
+{
+    if( !isConnected( ))
+        return -1;
+
+    for( ;; )
+    {
+        // Data on a data socket is always announced on the control socket
+        // first, therefore reading the stripes in order never waits for a
+        // later message.
+        const int fd = _impl->getNextSocket();
+        if( !_impl->arm( fd ))
+        {
+            LBWARN << "Can't update striped connection notifier: "
+                   << lunchbox::sysError << std::endl;
+            close();
+            return -1;
+        }
+
+        const bool isHeader = _impl->remaining == 0;
+        uint64_t header = 0;
+        uint8_t* data = isHeader ? reinterpret_cast< uint8_t* >( &header ) :
+                                   static_cast< uint8_t* >( buffer );
+        const uint64_t size = isHeader ? sizeof( header ) :
+                                         LB_MIN( bytes, _impl->stripeLeft );
+
+        ssize_t result = ::recv( fd, data, size, MSG_DONTWAIT );
+        if( result < 0 && ( errno == EAGAIN || errno == EWOULDBLOCK ||
+                            errno == EINTR ))
+        {
+            if( !block )
+            {
+                if( !_impl->hasHangup( ))
+                    return READ_TIMEOUT;
+                LBINFO << "Stream hung up, closing "
+                       << getDescription()->toString() << std::endl;
+                close();
+                return -1;
+            }
+            result = _recv( fd, data, size );
+        }
+
+        // the rest of a started header is on its way
+        if( isHeader && result > 0 && uint64_t( result ) < sizeof( header ) &&
+            !_recvAll( fd, data + result, sizeof( header ) - result ))
+        {
+            result = 0;
+        }
+
+        if( result <= 0 )
+        {
+            LBINFO << "Peer closed, closing " << getDescription()->toString()
+                   << std::endl;
+            close();
+            return -1;
+        }
+
+        if( !isHeader )
+        {
+            _impl->remaining -= result;
+            _impl->stripeLeft -= result;
+            if( !_impl->arm( _impl->getNextSocket( )))
+            {
+                LBWARN << "Can't update striped connection notifier: "
+                       << lunchbox::sysError << std::endl;
+                close();
+                return -1;
+            }
+            return result;
+        }
+
+        _impl->striped = ( header & _stripedBit ) != 0;
+        _impl->size = header & ~_stripedBit;
+        _impl->remaining = _impl->size;
+        _impl->stripe = 0;
+        if( _impl->striped && _impl->getNStripes() == 0 )
+        {
+            LBWARN << "Striped message without data streams" << std::endl;
+            close();
+            return -1;
+        }
+        _impl->stripeLeft = _impl->striped ? _impl->getStripeSize( 0 ) :
+                                             _impl->size;
+    }
+}
+
+//----------------------------------------------------------------------
+// write
+//----------------------------------------------------------------------
+int64_t StripedConnection::write( const void* buffer, const uint64_t bytes )
+{
+    if( !isConnected( ))
+        return -1;
+
+    const int32_t minSize =
+        Global::getIAttribute( Global::IATTR_STRIPED_MIN_SIZE_KB );
+    const bool striped = _impl->getNStripes() > 0 && minSize > 0 &&
+                         bytes >= ( uint64_t( minSize ) << 10 );
+
+    uint64_t header = bytes | ( striped ? _stripedBit : 0 );
+    iovec iov[ 2 ];
+    iov[ 0 ].iov_base = &header;
+    iov[ 0 ].iov_len = sizeof( header );
+    iov[ 1 ].iov_base = const_cast< void* >( buffer );
+    iov[ 1 ].iov_len = bytes;
+
+    if( !_sendAll( _impl->sockets.front(), iov, striped ? 1 : 2 ))
+        return -1;
+    if( striped &&
+        !_writeStripes( static_cast< const uint8_t* >( buffer ), bytes ))
+    {
+        return -1;
+    }
+    return bytes;
+}
+
+bool StripedConnection::_writeStripes( const uint8_t* data,
+                                       const uint64_t bytes )
+{
+    const size_t n = _impl->getNStripes();
+    std::vector< uint64_t > positions( n );
+    for( size_t i = 0; i < n; ++i )
+        positions[ i ] = _getStripeStart( bytes, i, n );
+
+    std::vector< pollfd > fds( n );
+    for( ;; )
+    {
+        bool done = true;
+        for( size_t i = 0; i < n; ++i )
+        {
+            const bool pending = positions[ i ] < _getStripeStart( bytes, i + 1,
+                                                                  n );
+            fds[ i ].fd = pending ? _impl->sockets[ i + 1 ] : -1;
+            fds[ i ].events = POLLOUT;
+            fds[ i ].revents = 0;
+            done = done && !pending;
+        }
+        if( done )
+            return true;
+
+        const int ready = ::poll( &fds.front(), n, _getTimeout( ));
+        if( ready == 0 )
+            throw Exception( Exception::TIMEOUT_WRITE );
+        if( ready < 0 )
+        {
+            if( errno == EINTR )
+                continue;
+            LBWARN << "Write error: " << lunchbox::sysError << std::endl;
+            return false;
+        }
+
+        for( size_t i = 0; i < n; ++i )
+        {
+            if( fds[ i ].revents == 0 )
+                continue;
+            if( fds[ i ].revents & ( POLLERR | POLLHUP | POLLNVAL ))
+            {
+                LBINFO << "Peer closed during write" << std::endl;
+                return false;
+            }
+
+            const uint64_t end = _getStripeStart( bytes, i + 1, n );
+            const ssize_t result = ::send( fds[ i ].fd, data + positions[ i ],
+                                           end - positions[ i ],
+                                           MSG_DONTWAIT | MSG_NOSIGNAL );
+            if( result < 0 )
+            {
+                if( errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR )
+                    continue;
+                LBWARN << "Write error: " << lunchbox::sysError << std::endl;
+                return false;
+            }
+            positions[ i ] += result;
+        }
+    }
+}
+}
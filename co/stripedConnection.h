@@ -0,0 +1,86 @@
+
+/* Copyright (c) 2026, The Collage Authors
+ *
+ * This file is part of Collage <https://github.com/Eyescale/Collage>
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef CO_STRIPEDCONNECTION_H
+#define CO_STRIPEDCONNECTION_H
+
+#include <co/connection.h>
+
+namespace co
+{
+#ifndef __linux__
+#  error StripedConnection only supported on Linux
+#endif
+
+namespace detail { class StripedConnection; }
+
+/**
+ * A connection striping large writes over several TCP sockets.
+ *
+ * The connection consists of one control socket and IATTR_STRIPED_STREAMS data
+ * sockets to the same peer. Each write is announced by a header on the control
+ * socket. Writes smaller than IATTR_STRIPED_MIN_SIZE_KB follow their header on
+ * the control socket, larger writes are split into one contiguous stripe per
+ * data socket, which are sent concurrently. The reader follows the headers on
+ * the control socket, which keeps the byte stream, and therefore the command
+ * order, intact. The notifier only signals data on the socket carrying the next
+ * bytes of the stream.
+ *
+ * The listener accepts on a single TCP port. Each socket identifies itself and
+ * its connection in a hello message. acceptSync() does not block: it accepts
+ * the waiting sockets, reads the available hellos and returns the connection
+ * once all its sockets have been identified, 0 otherwise. The notifier of the
+ * listener signals new sockets and hellos. Incomplete handshakes are dropped
+ * after the keepalive timeout.
+ */
+class StripedConnection : public Connection
+{
+public:
+    StripedConnection();
+
+    virtual bool connect();
+    virtual bool listen();
+    virtual void close() { _close(); }
+
+    virtual void acceptNB();
+    virtual ConnectionPtr acceptSync();
+
+    virtual Notifier getNotifier() const;
+
+protected:
+    virtual ~StripedConnection();
+
+    virtual void readNB( void*, const uint64_t ) { /* NOP */ }
+    virtual int64_t readSync( void* buffer, const uint64_t bytes,
+                              const bool block );
+    virtual int64_t write( const void* buffer, const uint64_t bytes );
+
+private:
+    detail::StripedConnection* const _impl;
+
+    bool _setup( const Connections& streams );
+    ConnectionPtr _newConnection( const Connections& streams );
+    bool _writeStripes( const uint8_t* data, uint64_t bytes );
+    void _close();
+
+    static int _getSocket( ConnectionPtr stream );
+};
+}
+
+#endif //CO_STRIPEDCONNECTION_H
@@ -133,6 +133,11 @@ typedef ICommands::iterator                        ICommandsIter;
 /** A const iterator for a vector of input commands. */
 typedef ICommands::const_iterator                  ICommandsCIter;
 
+/** A vector of request identifiers. */
+typedef std::vector< uint32_t >                    RequestIDs;
+/** A const iterator for a vector of request identifiers. */
+typedef RequestIDs::const_iterator                 RequestIDsCIter;
+
 /** @cond IGNORE */
 class BufferListener;
 class MasterCMCommand;
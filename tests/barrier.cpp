@@ -18,10 +18,13 @@
 #include <test.h>
 
 #include <co/barrier.h>
+#include <co/barrierCommand.h>
 #include <co/connection.h>
 #include <co/connectionDescription.h>
+#include <co/global.h>
 #include <co/init.h>
 #include <co/node.h>
+#include <co/objectICommand.h>
 #include <lunchbox/monitor.h>
 #include <lunchbox/rng.h>
 
@@ -83,6 +86,127 @@ private:
     bool _master;
 };
 
+static const uint32_t _groupHeight = 3;
+static const size_t _groupRounds = 10;
+lunchbox::Monitor< bool > _groupRegistered( false );
+lunchbox::Monitor< uint32_t > _groupLeft( 0 );
+static co::UUID _groupID;
+
+/** Counts the releases received through one multicast reply. */
+class GroupBarrier : public co::Barrier
+{
+public:
+    GroupBarrier() : multicastReleases( 0 ) {}
+
+    virtual bool dispatchCommand( co::ICommand& command )
+        {
+            co::ObjectICommand objectCommand( command );
+            if( objectCommand.getCommand() == co::CMD_BARRIER_ENTER_REPLY &&
+                objectCommand.getInstanceID() == EQ_INSTANCE_NONE )
+            {
+                ++multicastReleases;
+            }
+            return co::Barrier::dispatchCommand( command );
+        }
+
+    size_t multicastReleases;
+};
+
+/** Barrier over multiple mapped instances, using a tree or multicast. */
+class GroupNodeThread : public lunchbox::Thread
+{
+public:
+    GroupNodeThread( const uint16_t index, const bool multicast )
+        : _index( index ), _multicast( multicast ) {}
+
+    virtual void run()
+        {
+            const uint16_t port = _port + ( _multicast ? 2 + _groupHeight : 2 );
+            co::ConnectionDescriptionPtr description =
+                new co::ConnectionDescription;
+            description->type = co::CONNECTIONTYPE_TCPIP;
+            description->port = port + _index;
+
+            co::LocalNodePtr node = new co::LocalNode;
+            node->addConnectionDescription( description );
+            if( _multicast )
+            {
+                description = new co::ConnectionDescription;
+                description->type = co::CONNECTIONTYPE_RSP;
+                description->setHostname( "239.255.12.35" );
+                description->port = port;
+                node->addConnectionDescription( description );
+            }
+            TEST( node->listen( ));
+
+            const co::Barrier::Algorithm algorithm = _multicast ?
+                co::Barrier::ALGORITHM_CENTRAL : co::Barrier::ALGORITHM_TREE;
+            if( _index == 0 )
+            {
+                co::Barrier barrier( node, _groupHeight );
+                barrier.setAlgorithm( algorithm, 1 );
+                TEST( barrier.getAlgorithm() == algorithm );
+                TEST( node->registerObject( &barrier ));
+                _groupID = barrier.getID();
+                _groupRegistered = true;
+
+                // first tree round is central and distributes the tree
+                for( size_t i = 0; i < _groupRounds; ++i )
+                    barrier.enter();
+
+                _groupLeft.waitEQ( _groupHeight - 1 );
+                node->deregisterObject( &barrier );
+            }
+            else
+            {
+                _groupRegistered.waitEQ( true );
+
+                co::NodePtr server = new co::Node;
+                co::ConnectionDescriptionPtr serverDesc =
+                    new co::ConnectionDescription;
+                serverDesc->port = port;
+                server->addConnectionDescription( serverDesc );
+                TEST( node->connect( server ));
+
+                GroupBarrier barrier;
+                TEST( node->mapObject( &barrier, _groupID ));
+                TEST( barrier.getAlgorithm() == algorithm );
+
+                for( size_t i = 0; i < _groupRounds; ++i )
+                    barrier.enter();
+
+                node->unmapObject( &barrier );
+                // the multicast group releases with one reply to all slaves
+                TEST( _multicast == ( barrier.multicastReleases > 0 ));
+                ++_groupLeft;
+            }
+
+            node->close();
+        }
+
+private:
+    const uint16_t _index;
+    const bool _multicast;
+};
+
+static void _testGroup( const bool multicast )
+{
+    _groupRegistered = false;
+    _groupLeft = 0;
+
+    GroupNodeThread* nodes[ _groupHeight ];
+    for( uint16_t i = 0; i < _groupHeight; ++i )
+    {
+        nodes[i] = new GroupNodeThread( i, multicast );
+        nodes[i]->start();
+    }
+    for( uint16_t i = 0; i < _groupHeight; ++i )
+    {
+        TEST( nodes[i]->join( ));
+        delete nodes[i];
+    }
+}
+
 int main( int argc, char **argv )
 {
     TEST( co::init( argc, argv ));
@@ -97,6 +221,12 @@ int main( int argc, char **argv )
     server.join();
     node.join();
 
+    _testGroup( false ); // tree
+
+    // all members run in this process, let them receive each other's datagrams
+    co::Global::setIAttribute( co::Global::IATTR_RSP_MULTICAST_LOOPBACK, 1 );
+    _testGroup( true );  // release over loopback multicast
+
     co::exit();
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,165 @@
+
+/* Copyright (c) 2026, The Collage Authors
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests that nodes negotiate unpadded commands during the handshake, and
+// reports the bytes on the wire for typical control commands with and without
+// padding to COMMAND_MINSIZE.
+// Usage: ./commandFraming
+
+#include <test.h>
+
+#include <co/buffer.h>
+#include <co/commands.h>
+#include <co/connection.h>
+#include <co/connectionDescription.h>
+#include <co/init.h>
+#include <co/localNode.h>
+#include <co/nodeCommand.h> // private header
+#include <co/oCommand.h>
+#include <co/smallOCommand.h> // private header
+#include <lunchbox/rng.h>
+
+#include <iostream>
+
+#define N_COMMANDS 1000
+#define LOCKED_SIZE 20
+
+namespace
+{
+// Reads one command like LocalNode: the header first, then the remainder
+uint64_t _receive( co::ConnectionPtr reader, const uint64_t expectedSize )
+{
+    co::Buffer buffer;
+    co::BufferPtr syncBuffer;
+    reader->recvNB( &buffer, co::OCommand::getSize( ));
+    TEST( reader->recvSync( syncBuffer ));
+
+    uint64_t size = *reinterpret_cast< const uint64_t* >( buffer.getData( ));
+    const bool padded = !( size & co::COMMAND_UNPADDED );
+    size &= ~co::COMMAND_UNPADDED;
+    TESTINFO( size == expectedSize, size << " != " << expectedSize );
+
+    const uint64_t wireSize = padded ? LB_MAX( size, co::COMMAND_MINSIZE ) :
+                                       size;
+    if( wireSize > buffer.getSize( ))
+    {
+        reader->recvNB( &buffer, wireSize - buffer.getSize( ));
+        TEST( reader->recvSync( syncBuffer ));
+    }
+    TEST( buffer.getSize() == wireSize );
+    return wireSize;
+}
+
+uint64_t _send( co::ConnectionPtr writer, co::ConnectionPtr reader,
+                const bool unpadded )
+{
+    writer->setUnpaddedCommands( unpadded );
+
+    const co::Connections connections( 1, writer );
+    const co::uint128_t id( 17, 42 );
+    const uint8_t data[ LOCKED_SIZE ] = { 0 };
+    const uint64_t header = co::OCommand::getSize();
+
+    uint64_t bytes = 0;
+    for( uint32_t i = 0; i < N_COMMANDS; ++i )
+    {
+        co::SmallOCommand( writer, co::CMD_NODE_ACK_REQUEST ) << i;
+        bytes += _receive( reader, header + sizeof( i ));
+
+        co::SmallOCommand( writer, co::CMD_NODE_PING );
+        bytes += _receive( reader, header );
+
+        co::OCommand( connections, co::CMD_NODE_MAP_OBJECT_SUCCESS )
+            << id << id << i << i;
+        bytes += _receive( reader,
+                           header + 2 * sizeof( id ) + 2 * sizeof( i ));
+
+        {
+            co::OCommand command( connections, co::CMD_NODE_COMMAND );
+            command << i;
+            command.sendHeader( LOCKED_SIZE );
+            TEST( writer->send( data, LOCKED_SIZE, true /*locked*/ ));
+        }
+        bytes += _receive( reader, header + sizeof( i ) + LOCKED_SIZE );
+    }
+    return bytes;
+}
+
+void _testWire()
+{
+    co::ConnectionDescriptionPtr desc = new co::ConnectionDescription;
+    desc->type = co::CONNECTIONTYPE_PIPE;
+
+    co::ConnectionPtr writer = co::Connection::create( desc );
+    TEST( writer->connect( ));
+    co::ConnectionPtr reader = writer->acceptSync();
+
+    const uint64_t padded = _send( writer, reader, false );
+    const uint64_t unpadded = _send( writer, reader, true );
+    const size_t nCommands = 4 * N_COMMANDS;
+    TEST( padded == nCommands * co::COMMAND_MINSIZE );
+    TESTINFO( unpadded < padded / 4, unpadded << " of " << padded );
+
+    std::cout << nCommands << " control commands: " << padded
+              << " bytes padded, " << unpadded << " bytes unpadded ("
+              << 100.f - float( unpadded ) / float( padded ) * 100.f
+              << "% less on the wire)" << std::endl;
+
+    writer->close();
+    reader->close();
+}
+
+void _testHandshake()
+{
+    lunchbox::RNG rng;
+    co::ConnectionDescriptionPtr desc = new co::ConnectionDescription;
+    desc->type = co::CONNECTIONTYPE_TCPIP;
+    desc->port = (rng.get< uint16_t >() % 60000) + 1024;
+    desc->setHostname( "localhost" );
+
+    co::LocalNodePtr server = new co::LocalNode;
+    server->addConnectionDescription( desc );
+    TEST( server->listen( ));
+
+    co::NodePtr serverProxy = new co::Node;
+    serverProxy->addConnectionDescription( desc );
+
+    desc = new co::ConnectionDescription;
+    desc->type = co::CONNECTIONTYPE_TCPIP;
+    desc->setHostname( "localhost" );
+
+    co::LocalNodePtr client = new co::LocalNode;
+    client->addConnectionDescription( desc );
+    TEST( client->listen( ));
+    TEST( client->connect( serverProxy ));
+    TEST( serverProxy->getConnection()->hasUnpaddedCommands( ));
+
+    // round-trip with unpadded commands in both directions
+    TEST( client->disconnect( serverProxy ));
+    TEST( client->close( ));
+    TEST( server->close( ));
+}
+}
+
+int main( int argc, char **argv )
+{
+    TEST( co::init( argc, argv ));
+    _testWire();
+    _testHandshake();
+    co::exit();
+    return EXIT_SUCCESS;
+}
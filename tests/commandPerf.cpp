@@ -0,0 +1,132 @@
+
+/* Copyright (c) 2026, The Collage Authors
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests that ICommand copies are independent, and measures the command
+// throughput of the dispatch path: parse, dispatch to a queue, pop, invoke.
+// Usage: ./commandPerf
+
+#include <test.h>
+
+#include <co/buffer.h>
+#include <co/bufferCache.h>
+#include <co/commandFunc.h>
+#include <co/commandQueue.h>
+#include <co/dispatcher.h>
+#include <co/iCommand.h>
+#include <co/init.h>
+#include <co/oCommand.h>
+#include <lunchbox/clock.h>
+
+#include <iostream>
+
+#define N_COMMANDS 1000000
+#define N_BATCH 64
+
+namespace
+{
+class Handler : public co::Dispatcher
+{
+public:
+    Handler() : nCalls( 0 )
+    {
+        registerCommand( 0u, co::CommandFunc< Handler >( this,
+                                                         &Handler::_cmd ),
+                         &queue );
+    }
+
+    co::CommandQueue queue;
+    size_t nCalls;
+
+private:
+    bool _cmd( co::ICommand& command )
+    {
+        TEST( command.get< uint32_t >() == 42 );
+        ++nCalls;
+        return true;
+    }
+};
+
+co::BufferPtr _newCommand( co::BufferCache& cache )
+{
+    const uint64_t size = co::OCommand::getSize() + sizeof( uint32_t );
+    co::BufferPtr buffer = cache.alloc( co::COMMAND_ALLOCSIZE );
+    buffer->resize( size );
+
+    uint8_t* data = buffer->getData();
+    reinterpret_cast< uint64_t* >( data )[ 0 ] = size;
+    reinterpret_cast< uint32_t* >( data + 8 )[ 0 ] = co::COMMANDTYPE_CUSTOM;
+    reinterpret_cast< uint32_t* >( data + 12 )[ 0 ] = 0;
+    reinterpret_cast< uint32_t* >( data + co::OCommand::getSize( ))[ 0 ] = 42;
+    return buffer;
+}
+
+void _testCopies( co::BufferCache& cache )
+{
+    co::ICommand command( 0, 0, _newCommand( cache ), false /*swap*/ );
+    co::ICommand copy( command );
+    TEST( copy.getCommand() == 0 );
+    TEST( copy.getType() == co::COMMANDTYPE_CUSTOM );
+
+    // modifying a copy does not change the original
+    copy.setCommand( 1 );
+    TEST( copy.getCommand() == 1 );
+    TEST( command.getCommand() == 0 );
+
+    // each copy reads the payload from its start
+    TEST( command.get< uint32_t >() == 42 );
+    TEST( copy.get< uint32_t >() == 42 );
+
+    co::ICommand assigned;
+    assigned = command;
+    TEST( assigned.getCommand() == 0 );
+    TEST( assigned.get< uint32_t >() == 42 );
+    assigned.clear();
+    TEST( !assigned.isValid( ));
+    TEST( command.isValid( ));
+}
+}
+
+int main( int argc, char **argv )
+{
+    TEST( co::init( argc, argv ));
+    {
+        co::BufferCache cache( 100 );
+        _testCopies( cache );
+
+        Handler handler;
+        lunchbox::Clock clock;
+        for( size_t i = 0; i < N_COMMANDS; i += N_BATCH )
+        {
+            for( size_t j = 0; j < N_BATCH; ++j )
+            {
+                co::ICommand command( 0, 0, _newCommand( cache ), false );
+                TEST( handler.dispatchCommand( command ));
+            }
+            for( size_t j = 0; j < N_BATCH; ++j )
+            {
+                co::ICommand command = handler.queue.pop();
+                TEST( command( ));
+            }
+        }
+        const float time = clock.getTimef();
+        TEST( handler.nCalls == N_COMMANDS );
+
+        std::cout << N_COMMANDS / time << " commands/ms" << std::endl;
+    }
+    TEST( co::exit( ));
+    return EXIT_SUCCESS;
+}
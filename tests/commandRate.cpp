@@ -0,0 +1,129 @@
+
+/* Copyright (c) 2026, The Collage Authors
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Measures the rate of small commands received by a node over TCP loopback,
+// and tests that commands sliced out of one read, split across reads or bigger
+// than a read arrive complete and in order.
+// Usage: ./commandRate
+
+#include <test.h>
+
+#include <co/commands.h>
+#include <co/connectionDescription.h>
+#include <co/iCommand.h>
+#include <co/init.h>
+#include <co/node.h>
+#include <co/oCommand.h>
+
+#include <lunchbox/clock.h>
+#include <lunchbox/monitor.h>
+#include <lunchbox/rng.h>
+
+#include <iostream>
+
+#define N_COMMANDS 200000
+#define BIG_INTERVAL 10000 // every nth command is bigger than a read
+#define BIG_SIZE ( co::COMMAND_RECVSIZE * 3 / 2 )
+
+namespace
+{
+lunchbox::Monitor< uint32_t > received( 0 );
+
+std::string _getPayload( const uint32_t i )
+{
+    if( i % BIG_INTERVAL == BIG_INTERVAL - 1 )
+        return std::string( BIG_SIZE, char( i ));
+    return std::string( i % 97, char( i )); // vary the command sizes
+}
+
+class Server : public co::LocalNode
+{
+public:
+    virtual bool listen()
+    {
+        if( !co::LocalNode::listen( ))
+            return false;
+
+        // handled by the receiver thread, to measure the receive path only
+        registerCommand( co::CMD_NODE_CUSTOM,
+                         co::CommandFunc< Server >( this, &Server::_cmd ), 0 );
+        return true;
+    }
+
+private:
+    bool _cmd( co::ICommand& command )
+    {
+        const uint32_t i = command.get< uint32_t >();
+        TESTINFO( i == received.get(), i << " != " << received.get( ));
+
+        const std::string& payload = command.get< std::string >();
+        TESTINFO( payload == _getPayload( i ), i );
+        ++received;
+        return true;
+    }
+};
+}
+
+int main( int argc, char **argv )
+{
+    TEST( co::init( argc, argv ));
+
+    lunchbox::RNG rng;
+    co::ConnectionDescriptionPtr desc = new co::ConnectionDescription;
+    desc->type = co::CONNECTIONTYPE_TCPIP;
+    desc->port = (rng.get< uint16_t >() % 60000) + 1024;
+    desc->setHostname( "127.0.0.1" );
+
+    lunchbox::RefPtr< Server > server = new Server;
+    server->addConnectionDescription( desc );
+    TEST( server->listen( ));
+
+    co::NodePtr serverProxy = new co::Node;
+    serverProxy->addConnectionDescription( desc );
+
+    desc = new co::ConnectionDescription;
+    desc->type = co::CONNECTIONTYPE_TCPIP;
+    desc->setHostname( "127.0.0.1" );
+
+    co::LocalNodePtr client = new co::LocalNode;
+    client->addConnectionDescription( desc );
+    TEST( client->listen( ));
+    TEST( client->connect( serverProxy ));
+
+    std::vector< std::string > payloads;
+    for( uint32_t i = 0; i < N_COMMANDS; ++i )
+        payloads.push_back( _getPayload( i ));
+
+    lunchbox::Clock clock;
+    for( uint32_t i = 0; i < N_COMMANDS; ++i )
+        serverProxy->send( co::CMD_NODE_CUSTOM ) << i << payloads[ i ];
+    received.waitEQ( N_COMMANDS );
+    const float time = clock.getTimef();
+
+    std::cout << N_COMMANDS / time << " commands/ms received over TCP"
+              << std::endl;
+
+    TEST( client->disconnect( serverProxy ));
+    TEST( client->close( ));
+    TEST( server->close( ));
+
+    serverProxy = 0;
+    client = 0;
+    server = 0;
+    co::exit();
+    return EXIT_SUCCESS;
+}
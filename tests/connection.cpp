@@ -40,6 +40,10 @@ static co::ConnectionType types[] =
 #endif
 #ifdef EQ_INFINIBAND
     co::CONNECTIONTYPE_IB,
+#endif
+#ifdef __linux__
+    co::CONNECTIONTYPE_SHM,
+    co::CONNECTIONTYPE_STRIPED,
 #endif
     co::CONNECTIONTYPE_NONE // must be last
 };
@@ -81,6 +85,28 @@ int main( int argc, char **argv )
                 writer = listener;
                 reader = listener->acceptSync();
                 break;
+#ifdef __linux__
+            case co::CONNECTIONTYPE_STRIPED:
+            {
+                TESTINFO( listener->listen(), desc );
+                listener->acceptNB();
+
+                writer = co::Connection::create( desc );
+                TEST( writer->connect( ));
+
+                // the handshake of the streams completes over several accepts
+                co::ConnectionSet set;
+                set.addConnection( listener );
+                while( !reader )
+                {
+                    TEST( set.select( 10000 ) ==
+                          co::ConnectionSet::EVENT_CONNECT );
+                    reader = listener->acceptSync();
+                }
+                TEST( set.removeConnection( listener ));
+                break;
+            }
+#endif
             default:
                 TESTINFO( listener->listen(), desc );
                 listener->acceptNB();
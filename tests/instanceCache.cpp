@@ -28,12 +28,21 @@
 #include <co/nodeCommand.h>
 #include <co/localNode.h>
 #include <co/objectDataICommand.h>
+#include <co/objectDataIStream.h>
 #include <co/objectDataOCommand.h>
 #include <co/objectVersion.h>
 
 #include <lunchbox/rng.h>
 #include <lunchbox/thread.h>
 
+#include <cstdio>
+#ifdef _WIN32
+#  include <direct.h>
+#  include <io.h>
+#else
+#  include <unistd.h>
+#endif
+
 
 // Tests the functionality of the instance cache
 
@@ -43,6 +52,29 @@
 
 lunchbox::Clock _clock;
 
+/** @return a new, empty directory for the disk tier, or an empty string. */
+std::string _createTempDirectory()
+{
+#ifdef _WIN32
+    char name[] = "instanceCacheXXXXXX";
+    if( _mktemp_s( name, sizeof( name )) != 0 || _mkdir( name ) != 0 )
+        return std::string();
+    return name;
+#else
+    char name[] = "/tmp/instanceCacheXXXXXX";
+    return ::mkdtemp( name ) ? name : std::string();
+#endif
+}
+
+void _removeTempDirectory( const std::string& directory )
+{
+#ifdef _WIN32
+    _rmdir( directory.c_str( ));
+#else
+    ::rmdir( directory.c_str( ));
+#endif
+}
+
 class Reader : public lunchbox::Thread
 {
 public:
@@ -158,6 +190,38 @@ int main( int argc, char **argv )
     std::cout << cache << std::endl;
 
     TESTINFO( cache.getSize() == 0, cache.getSize( ));
+
+    // persistent disk tier
+    const lunchbox::UUID id( 42, 17 );
+    const std::string directory = _createTempDirectory();
+    TEST( !directory.empty( ));
+    {
+        co::InstanceCache writer( LB_100MB, directory );
+        TEST( writer.add( co::ObjectVersion( id, 1 ), 1, in ));
+    }
+
+    {
+        co::InstanceCache restored( LB_100MB, directory );
+        TEST( restored[ id ] == co::InstanceCache::Data::NONE );
+        TEST( restored.restore( id, node, node ));
+        TEST( !restored.restore( id, node, node )); // already in memory
+
+        const co::InstanceCache::Data& data = restored[ id ];
+        TEST( data != co::InstanceCache::Data::NONE );
+        TEST( data.masterInstanceID == 1 );
+        TEST( data.versions.size() == 1 );
+        TEST( data.versions.front()->isReady( ));
+        TEST( data.versions.front()->getVersion() == 1 );
+        TEST( restored.release( id, 1 ));
+        TEST( restored.erase( id ));
+    } // flushes the removal of the file
+
+    {
+        co::InstanceCache erased( LB_100MB, directory );
+        TEST( !erased.restore( id, node, node ));
+    }
+    _removeTempDirectory( directory );
+
     TEST( co::exit( ));
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,117 @@
+
+/* Copyright (c) 2026, The Collage Authors
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests socket connections receiving through io_uring: notification through a
+// connection set, blocking reads, EOF and closing with a pending read.
+
+#include <test.h>
+
+#include <co/buffer.h>
+#include <co/connection.h>
+#include <co/connectionDescription.h>
+#include <co/connectionSet.h>
+#include <co/global.h>
+#include <co/init.h>
+
+#define PACKETSIZE (2048)
+
+#ifdef CO_USE_LIBURING
+namespace
+{
+void _connect( co::ConnectionPtr& writer, co::ConnectionPtr& reader )
+{
+    co::ConnectionDescriptionPtr desc = new co::ConnectionDescription;
+    desc->type = co::CONNECTIONTYPE_TCPIP;
+    desc->setHostname( "127.0.0.1" );
+
+    co::ConnectionPtr listener = co::Connection::create( desc );
+    TESTINFO( listener->listen(), desc );
+    listener->acceptNB();
+
+    writer = co::Connection::create( desc );
+    TEST( writer->connect( ));
+    reader = listener->acceptSync();
+    TEST( reader );
+    listener->close();
+}
+}
+#endif
+
+int main( int argc, char **argv )
+{
+    TEST( co::init( argc, argv ));
+#ifdef CO_USE_LIBURING
+    co::Global::setIAttribute( co::Global::IATTR_TCPIP_IO_URING, 1 );
+
+    co::ConnectionPtr writer;
+    co::ConnectionPtr reader;
+    _connect( writer, reader );
+
+    co::ConnectionSet set;
+    set.addConnection( reader );
+
+    uint8_t out[ PACKETSIZE ];
+    for( size_t i = 0; i < PACKETSIZE; ++i )
+        out[ i ] = uint8_t( i );
+
+    co::Buffer buffer;
+    co::BufferPtr syncBuffer;
+    for( size_t i = 0; i < 10; ++i )
+    {
+        buffer.setSize( 0 );
+        reader->recvNB( &buffer, PACKETSIZE );
+        TEST( set.select( 100 ) == co::ConnectionSet::EVENT_TIMEOUT );
+
+        TEST( writer->send( out, PACKETSIZE ));
+        TEST( set.select( 1000 ) == co::ConnectionSet::EVENT_DATA );
+        TEST( set.getConnection() == reader );
+        TEST( reader->recvSync( syncBuffer ));
+        TEST( buffer.getSize() == PACKETSIZE );
+        TEST( buffer[ PACKETSIZE - 1 ] == uint8_t( PACKETSIZE - 1 ));
+    }
+
+    // blocking read without connection set
+    buffer.setSize( 0 );
+    reader->recvNB( &buffer, PACKETSIZE );
+    TEST( writer->send( out, PACKETSIZE ));
+    TEST( reader->recvSync( syncBuffer ));
+    TEST( buffer.getSize() == PACKETSIZE );
+
+    // EOF completes the pending read
+    buffer.setSize( 0 );
+    reader->recvNB( &buffer, PACKETSIZE );
+    writer->close();
+    TEST( set.select( 1000 ) == co::ConnectionSet::EVENT_DATA );
+    TEST( !reader->recvSync( syncBuffer ));
+    TEST( reader->isClosed( ));
+    TEST( set.removeConnection( reader ));
+
+    // close with a pending read
+    _connect( writer, reader );
+    buffer.setSize( 0 );
+    reader->recvNB( &buffer, PACKETSIZE );
+    reader->close();
+    TEST( reader->isClosed( ));
+    TEST( !reader->recvSync( syncBuffer ));
+    writer->close();
+
+    TEST( reader->getRefCount() == 1 );
+    TEST( writer->getRefCount() == 1 );
+#endif
+    co::exit();
+    return EXIT_SUCCESS;
+}
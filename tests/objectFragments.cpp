@@ -0,0 +1,128 @@
+
+/* Copyright (c) 2026, The Collage Authors
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests that object data split over several commands arrives intact, with
+// and without fragmenting it.
+
+#include <test.h>
+
+#include <co/connectionDescription.h>
+#include <co/dataIStream.h>
+#include <co/dataOStream.h>
+#include <co/global.h>
+#include <co/init.h>
+#include <co/localNode.h>
+#include <co/node.h>
+#include <co/object.h>
+#include <lunchbox/monitor.h>
+
+#include <vector>
+
+#define OBJECT_SIZE ( 4 * 1024 * 1024 + 13 )
+
+namespace
+{
+lunchbox::Monitor< size_t > _nPushes( 0 );
+
+class Object : public co::Object
+{
+public:
+    Object() : _data( OBJECT_SIZE )
+    {
+        for( size_t i = 0; i < OBJECT_SIZE; ++i )
+            _data[ i ] = uint8_t( i * 7 );
+    }
+
+protected:
+    virtual ChangeType getChangeType() const { return INSTANCE; }
+    virtual void getInstanceData( co::DataOStream& os )
+        { os << co::Array< const uint8_t >( &_data.front(), OBJECT_SIZE ); }
+    virtual void applyInstanceData( co::DataIStream& ) { TEST( false ); }
+
+private:
+    std::vector< uint8_t > _data;
+};
+
+class Client : public co::LocalNode
+{
+protected:
+    virtual void objectPush( const co::uint128_t&, const co::uint128_t&,
+                             const co::uint128_t&, co::DataIStream& istream )
+    {
+        std::vector< uint8_t > data( OBJECT_SIZE );
+        istream >> co::Array< uint8_t >( &data.front(), OBJECT_SIZE );
+        TEST( !istream.hasData( ));
+        for( size_t i = 0; i < OBJECT_SIZE; ++i )
+            TESTINFO( data[ i ] == uint8_t( i * 7 ), i );
+        ++_nPushes;
+    }
+};
+
+void _testPush( co::LocalNodePtr server, co::LocalNodePtr client )
+{
+    Object object;
+    TEST( server->registerObject( &object ));
+    co::NodePtr clientProxy = server->getNode( client->getNodeID( ));
+    TEST( clientProxy );
+
+    _nPushes = 0;
+    object.push( 42, 42, co::Nodes( 1, clientProxy ));
+    _nPushes.waitEQ( 1 );
+
+    server->deregisterObject( &object );
+}
+}
+
+int main( int argc, char **argv )
+{
+    TEST( co::init( argc, argv ));
+
+    co::ConnectionDescriptionPtr desc = new co::ConnectionDescription;
+    desc->type = co::CONNECTIONTYPE_TCPIP;
+    desc->setHostname( "127.0.0.1" );
+
+    co::LocalNodePtr server = new co::LocalNode;
+    server->addConnectionDescription( desc );
+    TEST( server->listen( ));
+
+    co::NodePtr serverProxy = new co::Node;
+    serverProxy->addConnectionDescription( desc );
+
+    desc = new co::ConnectionDescription;
+    desc->type = co::CONNECTIONTYPE_TCPIP;
+    desc->setHostname( "127.0.0.1" );
+
+    co::LocalNodePtr client = new Client;
+    client->addConnectionDescription( desc );
+    TEST( client->listen( ));
+    TEST( client->connect( serverProxy ));
+
+    _testPush( server, client ); // fragmented
+
+    const int32_t size =
+        co::Global::getIAttribute( co::Global::IATTR_OBJECT_FRAGMENT_SIZE );
+    co::Global::setIAttribute( co::Global::IATTR_OBJECT_FRAGMENT_SIZE, 0 );
+    _testPush( server, client );
+    co::Global::setIAttribute( co::Global::IATTR_OBJECT_FRAGMENT_SIZE, size );
+
+    TEST( client->disconnect( serverProxy ));
+    TEST( client->close( ));
+    TEST( server->close( ));
+
+    co::exit();
+    return EXIT_SUCCESS;
+}
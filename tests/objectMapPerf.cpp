@@ -0,0 +1,198 @@
+
+/* Copyright (c) 2026, The Collage Authors
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Compares mapping a large ObjectMap one object at a time against batched
+// mapping using LocalNode::mapObjectsNB and automatic mapping during sync.
+// Usage: ./objectMapPerf
+
+#include <test.h>
+
+#include <co/co.h>
+#include <lunchbox/clock.h>
+
+#include <iostream>
+
+#define N_OBJECTS 2000
+
+namespace
+{
+class TestObject : public co::Object
+{
+public:
+    TestObject() : value( 0 ) {}
+
+    uint64_t value;
+
+protected:
+    virtual void getInstanceData( co::DataOStream& os ) { os << value; }
+    virtual void applyInstanceData( co::DataIStream& is ) { is >> value; }
+    virtual ChangeType getChangeType() const { return INSTANCE; }
+};
+
+enum ObjectType
+{
+    TYPE_OBJECT = co::OBJECTTYPE_CUSTOM
+};
+
+class ObjectFactory : public co::ObjectFactory
+{
+public:
+    virtual co::Object* createObject( const uint32_t type )
+    {
+        TEST( type == TYPE_OBJECT );
+        return new TestObject;
+    }
+
+    virtual void destroyObject( co::Object* object, const uint32_t type )
+    {
+        TEST( type == TYPE_OBJECT );
+        delete object;
+    }
+};
+
+class TestNode : public co::LocalNode
+{
+public:
+#pragma warning( disable: 4355)
+    TestNode() : factory(), objectMap( *this, factory ) {}
+#pragma warning( default: 4355)
+
+    ObjectFactory factory;
+    co::ObjectMap objectMap;
+};
+}
+
+int main( int argc, char **argv )
+{
+    TEST( co::init( argc, argv ));
+
+    lunchbox::RNG rng;
+    const uint16_t port = (rng.get<uint16_t>() % 60000) + 1024;
+
+    lunchbox::RefPtr< TestNode > server = new TestNode;
+    co::ConnectionDescriptionPtr connDesc = new co::ConnectionDescription;
+    connDesc->type = co::CONNECTIONTYPE_TCPIP;
+    connDesc->port = port;
+    connDesc->setHostname( "localhost" );
+
+    server->addConnectionDescription( connDesc );
+    TEST( server->listen( ));
+
+    co::NodePtr serverProxy = new co::Node;
+    serverProxy->addConnectionDescription( connDesc );
+
+    connDesc = new co::ConnectionDescription;
+    connDesc->type = co::CONNECTIONTYPE_TCPIP;
+    connDesc->setHostname( "localhost" );
+
+    lunchbox::RefPtr< TestNode > client = new TestNode;
+    client->addConnectionDescription( connDesc );
+    TEST( client->listen( ));
+    TEST( client->connect( serverProxy ));
+
+    TEST( server->registerObject( &server->objectMap ));
+    TEST( client->mapObject( &client->objectMap, &server->objectMap ));
+
+    std::vector< TestObject* > masters( N_OBJECTS );
+    co::ObjectVersions versions;
+    for( size_t i = 0; i < N_OBJECTS; ++i )
+    {
+        masters[i] = new TestObject;
+        masters[i]->value = i;
+        TEST( server->objectMap.register_( masters[i], TYPE_OBJECT ));
+        versions.push_back( co::ObjectVersion( masters[i] ));
+    }
+    client->objectMap.sync( server->objectMap.commit( ));
+
+    // one round trip per object
+    lunchbox::Clock clock;
+    co::Objects objects;
+    for( size_t i = 0; i < N_OBJECTS; ++i )
+    {
+        co::Object* object = client->objectMap.map( versions[i].identifier );
+        TEST( object );
+        TEST( static_cast< TestObject* >( object )->value == i );
+        objects.push_back( object );
+    }
+    const float mapTime = clock.getTimef();
+
+    for( size_t i = 0; i < N_OBJECTS; ++i )
+        TEST( client->objectMap.unmap( objects[i] ));
+    client->expireInstanceData( 0 ); // don't let the batch hit the cache
+
+    // batched, one request per master node
+    objects.clear();
+    for( size_t i = 0; i < N_OBJECTS; ++i )
+        objects.push_back( new TestObject );
+
+    clock.reset();
+    const co::RequestIDs requests = client->mapObjectsNB( objects, versions );
+    TEST( requests.size() == N_OBJECTS );
+    TEST( client->mapObjectsSync( requests ));
+    const float batchTime = clock.getTimef();
+
+    for( size_t i = 0; i < N_OBJECTS; ++i )
+    {
+        TEST( static_cast< TestObject* >( objects[i] )->value == i );
+        client->unmapObject( objects[i] );
+        delete objects[i];
+    }
+
+    client->expireInstanceData( 0 );
+
+    // automatic, all new entries are mapped in parallel on sync
+    co::ObjectMap autoMap( *client, client->factory );
+    autoMap.setAutoMap( true );
+    TEST( autoMap.isAutoMap( ));
+
+    clock.reset();
+    TEST( client->mapObject( &autoMap, &server->objectMap ));
+    const float autoTime = clock.getTimef();
+
+    for( size_t i = 0; i < N_OBJECTS; ++i )
+    {
+        const co::Object* object = autoMap.map( versions[i].identifier );
+        TEST( object );
+        TEST( static_cast< const TestObject* >( object )->value == i );
+    }
+    autoMap.clear();
+    client->unmapObject( &autoMap );
+
+    std::cout << N_OBJECTS << " objects: ObjectMap::map " << mapTime
+              << " ms, mapObjectsNB " << batchTime << " ms, auto map "
+              << autoTime << " ms" << std::endl;
+
+    client->objectMap.clear();
+    client->unmapObject( &client->objectMap );
+    for( size_t i = 0; i < N_OBJECTS; ++i )
+    {
+        TEST( server->objectMap.deregister( masters[i] ));
+        delete masters[i];
+    }
+    server->deregisterObject( &server->objectMap );
+
+    TEST( client->disconnect( serverProxy ));
+    TEST( client->close( ));
+    TEST( server->close( ));
+
+    serverProxy = 0;
+    client      = 0;
+    server      = 0;
+
+    co::exit();
+    return EXIT_SUCCESS;
+}
@@ -15,7 +15,8 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
-// Tests PipeConnection throughput
+// Tests PipeConnection throughput, and its round-trip latency compared to
+// kernel pipes
 // Usage: ./pipeperf
 
 #define EQ_TEST_RUNTIME 600 // seconds, needed for NighlyMemoryCheck
@@ -31,6 +32,7 @@
 #include <co/pipeConnection.h> // private header
 
 #define MAXPACKETSIZE LB_64MB
+#define N_PINGS 100000
 
 static lunchbox::Monitor< unsigned > _nextStage;
 
@@ -72,6 +74,102 @@ private:
     co::ConnectionPtr _connection;
 };
 
+class Echo : public lunchbox::Thread
+{
+public:
+    Echo( co::ConnectionPtr connection ) : _connection( connection ) {}
+
+protected:
+    virtual void run()
+        {
+            co::Buffer buffer;
+            co::BufferPtr syncBuffer;
+            for( size_t i = 0; i < N_PINGS; ++i )
+            {
+                buffer.setSize( 0 );
+                _connection->recvNB( &buffer, 1 );
+                TEST( _connection->recvSync( syncBuffer ));
+                TEST( _connection->send( buffer.getData(), 1 ));
+            }
+        }
+
+private:
+    co::ConnectionPtr _connection;
+};
+
+static float _measureLatency( co::PipeConnectionPtr connection )
+{
+    Echo echo( connection->acceptSync( ));
+    TEST( echo.start( ));
+
+    co::Buffer buffer;
+    co::BufferPtr syncBuffer;
+    const uint8_t ping = 42;
+
+    lunchbox::Clock clock;
+    for( size_t i = 0; i < N_PINGS; ++i )
+    {
+        TEST( connection->send( &ping, 1 ));
+        buffer.setSize( 0 );
+        connection->recvNB( &buffer, 1 );
+        TEST( connection->recvSync( syncBuffer ));
+    }
+    const float time = clock.getTimef();
+    TEST( echo.join( ));
+    return time * 1000.f / N_PINGS;
+}
+
+#ifndef _WIN32
+class PipeEcho : public lunchbox::Thread
+{
+public:
+    PipeEcho( const int in, const int out ) : _in( in ), _out( out ) {}
+
+protected:
+    virtual void run()
+        {
+            uint8_t byte;
+            for( size_t i = 0; i < N_PINGS; ++i )
+            {
+                TEST( ::read( _in, &byte, 1 ) == 1 );
+                TEST( ::write( _out, &byte, 1 ) == 1 );
+            }
+        }
+
+private:
+    const int _in;
+    const int _out;
+};
+
+static float _measurePipeLatency()
+{
+    int request[2];
+    int reply[2];
+    TEST( ::pipe( request ) == 0 );
+    TEST( ::pipe( reply ) == 0 );
+
+    PipeEcho echo( request[0], reply[1] );
+    TEST( echo.start( ));
+
+    uint8_t byte = 42;
+    lunchbox::Clock clock;
+    for( size_t i = 0; i < N_PINGS; ++i )
+    {
+        TEST( ::write( request[1], &byte, 1 ) == 1 );
+        TEST( ::read( reply[0], &byte, 1 ) == 1 );
+    }
+    const float time = clock.getTimef();
+    TEST( echo.join( ));
+
+    for( size_t i = 0; i < 2; ++i )
+    {
+        ::close( request[i] );
+        ::close( reply[i] );
+    }
+    return time * 1000.f / N_PINGS;
+}
+#endif
+
 int main( int argc, char **argv )
 {
     co::init( argc, argv );
@@ -120,6 +218,14 @@ int main( int argc, char **argv )
     }
 
     TEST( sender.join( ));
+
+    std::cerr << "PipeConnection: " << _measureLatency( connection )
+              << " us round-trip" << std::endl;
+#ifndef _WIN32
+    std::cerr << "pipe(2): " << _measurePipeLatency() << " us round-trip"
+              << std::endl;
+#endif
+
     connection->close();
 
     co::exit();
@@ -66,6 +66,22 @@ int main( int argc, char **argv )
         TEST( !c5.isValid( ));
     }
 
+    qm->push( 0 ) << 0u;
+    qm->push( 2 ) << 2u;
+    qm->push( 1 ) << 1u;
+    qm->push( 2 ) << 3u;
+    qm->push( 42 ) << 4u; // clamped to the highest priority
+    {
+        const uint32_t expected[] = { 4u, 2u, 3u, 1u, 0u };
+        for( size_t i = 0; i < 5; ++i )
+        {
+            co::ObjectICommand c = qs->pop();
+            TEST( c.isValid( ));
+            TEST( c.get< uint32_t >() == expected[i] );
+        }
+        TEST( !qs->pop().isValid( ));
+    }
+
     node->unmapObject( qs );
     node->deregisterObject( qm );
 
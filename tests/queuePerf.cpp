@@ -0,0 +1,135 @@
+
+/* Copyright (c) 2026, The Collage Authors
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Measures the QueueMaster to QueueSlave item throughput between two nodes for
+// item sizes from 8 bytes to 64 KB, using a fixed and an adaptive prefetch.
+// Usage: ./queuePerf
+
+#include <test.h>
+
+#include <co/co.h>
+#include <co/queueItem.h>
+#include <co/queueMaster.h>
+#include <co/queueSlave.h>
+#include <lunchbox/clock.h>
+
+#include <iomanip>
+#include <iostream>
+
+#define MAX_ITEMS 20000
+#define MAX_BYTES (16 * LB_1MB)
+#define PREFETCH_MARK 256
+#define PREFETCH_AMOUNT 1024
+
+namespace
+{
+void _measure( co::QueueMaster& master, co::QueueSlave& slave,
+               const std::string& name )
+{
+    std::vector< uint8_t > data( LB_64KB );
+    for( size_t i = 0; i < data.size(); ++i )
+        data[i] = uint8_t( i );
+
+    for( size_t size = 8; size <= LB_64KB; size <<= 2 )
+    {
+        const size_t nItems = LB_MIN( MAX_ITEMS, MAX_BYTES / size );
+        for( size_t i = 0; i < nItems; ++i )
+            master.push() << uint32_t( i )
+                          << co::Array< const uint8_t >( &data.front(), size );
+
+        lunchbox::Clock clock;
+        for( size_t i = 0; i < nItems; ++i )
+        {
+            co::ObjectICommand item = slave.pop();
+            TEST( item.isValid( ));
+            TEST( item.get< uint32_t >() == i );
+
+            const uint8_t* bytes = static_cast< const uint8_t* >(
+                item.getRemainingBuffer( size ));
+            TEST( bytes );
+            TEST( bytes[ size - 1 ] == uint8_t( size - 1 ));
+        }
+        TEST( !slave.pop().isValid( ));
+        const float time = clock.getTimef();
+
+        std::cout << name << " prefetch, " << std::setw( 5 ) << size
+                  << " byte items: " << std::setw( 8 ) << nItems / time
+                  << " items/ms, " << std::setw( 8 )
+                  << float( nItems * size ) / 1048.576f / time << " MB/s"
+                  << std::endl;
+    }
+}
+}
+
+int main( int argc, char **argv )
+{
+    TEST( co::init( argc, argv ));
+
+    lunchbox::RNG rng;
+    const uint16_t port = (rng.get<uint16_t>() % 60000) + 1024;
+
+    co::LocalNodePtr server = new co::LocalNode;
+    co::ConnectionDescriptionPtr connDesc = new co::ConnectionDescription;
+    connDesc->type = co::CONNECTIONTYPE_TCPIP;
+    connDesc->port = port;
+    connDesc->setHostname( "localhost" );
+
+    server->addConnectionDescription( connDesc );
+    TEST( server->listen( ));
+
+    co::NodePtr serverProxy = new co::Node;
+    serverProxy->addConnectionDescription( connDesc );
+
+    connDesc = new co::ConnectionDescription;
+    connDesc->type = co::CONNECTIONTYPE_TCPIP;
+    connDesc->setHostname( "localhost" );
+
+    co::LocalNodePtr client = new co::LocalNode;
+    client->addConnectionDescription( connDesc );
+    TEST( client->listen( ));
+    TEST( client->connect( serverProxy ));
+
+    co::QueueMaster* master = new co::QueueMaster;
+    co::QueueSlave* slave = new co::QueueSlave( PREFETCH_MARK,
+                                                PREFETCH_AMOUNT );
+    TEST( server->registerObject( master ));
+    TEST( client->mapObject( slave, master->getID(), co::VERSION_FIRST ));
+
+    _measure( *master, *slave, "static" );
+
+    co::QueueSlave* adaptive = new co::QueueSlave;
+    TEST( client->mapObject( adaptive, master->getID(), co::VERSION_FIRST ));
+    _measure( *master, *adaptive, "adaptive" );
+    client->unmapObject( adaptive );
+    delete adaptive;
+
+    client->unmapObject( slave );
+    server->deregisterObject( master );
+    delete slave;
+    delete master;
+
+    TEST( client->disconnect( serverProxy ));
+    TEST( client->close( ));
+    TEST( server->close( ));
+
+    serverProxy = 0;
+    client      = 0;
+    server      = 0;
+
+    co::exit();
+    return EXIT_SUCCESS;
+}
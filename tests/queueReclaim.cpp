@@ -0,0 +1,156 @@
+
+/* Copyright (c) 2026, The Collage Authors
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Simulates one frame of a tile queue consumed by nodes of skewed speed. The
+// slow node prefetches more items than it can process, which the master
+// reclaims for the fast nodes once it runs out of items.
+// Usage: ./queueReclaim
+
+#include <test.h>
+
+#include <co/co.h>
+#include <co/queueItem.h>
+#include <co/queueMaster.h>
+#include <co/queueSlave.h>
+#include <lunchbox/clock.h>
+#include <lunchbox/monitor.h>
+#include <lunchbox/scopedMutex.h>
+#include <lunchbox/sleep.h>
+
+#include <iostream>
+
+#define N_ITEMS 240
+#define N_SLAVES 3
+#define PREFETCH_MARK 4
+#define PREFETCH_AMOUNT 64
+#define FAST_TIME 1 // ms per item
+#define SLOW_TIME 20 // ms per item on the first slave
+
+namespace
+{
+co::ConnectionDescriptionPtr _serverDesc;
+co::UUID _queueID;
+lunchbox::Monitor< uint32_t > _mapped( 0 );
+lunchbox::Monitor< bool > _start( false );
+
+lunchbox::Lock _lock;
+std::vector< uint32_t > _consumed( N_ITEMS, 0 );
+
+class SlaveThread : public lunchbox::Thread
+{
+public:
+    SlaveThread( const uint32_t time ) : nItems( 0 ), _time( time ) {}
+
+    virtual void run()
+    {
+        co::ConnectionDescriptionPtr desc = new co::ConnectionDescription;
+        desc->type = co::CONNECTIONTYPE_TCPIP;
+        desc->setHostname( "localhost" );
+
+        co::LocalNodePtr node = new co::LocalNode;
+        node->addConnectionDescription( desc );
+        TEST( node->listen( ));
+
+        co::NodePtr server = new co::Node;
+        server->addConnectionDescription( _serverDesc );
+        TEST( node->connect( server ));
+
+        co::QueueSlave slave( PREFETCH_MARK, PREFETCH_AMOUNT );
+        TEST( node->mapObject( &slave, _queueID, co::VERSION_FIRST ));
+        ++_mapped;
+        _start.waitEQ( true );
+
+        for( co::ObjectICommand item = slave.pop(); item.isValid();
+             item = slave.pop( ))
+        {
+            const uint32_t index = item.get< uint32_t >();
+            TEST( index < N_ITEMS );
+            lunchbox::sleep( _time );
+            ++nItems;
+
+            lunchbox::ScopedWrite mutex( _lock );
+            ++_consumed[ index ];
+        }
+
+        node->unmapObject( &slave );
+        TEST( node->disconnect( server ));
+        TEST( node->close( ));
+    }
+
+    uint32_t nItems;
+
+private:
+    const uint32_t _time;
+};
+}
+
+int main( int argc, char **argv )
+{
+    TEST( co::init( argc, argv ));
+
+    lunchbox::RNG rng;
+    _serverDesc = new co::ConnectionDescription;
+    _serverDesc->type = co::CONNECTIONTYPE_TCPIP;
+    _serverDesc->port = (rng.get<uint16_t>() % 60000) + 1024;
+    _serverDesc->setHostname( "localhost" );
+
+    co::LocalNodePtr server = new co::LocalNode;
+    server->addConnectionDescription( _serverDesc );
+    TEST( server->listen( ));
+
+    co::QueueMaster master;
+    TEST( server->registerObject( &master ));
+    _queueID = master.getID();
+
+    SlaveThread* slaves[ N_SLAVES ];
+    for( size_t i = 0; i < N_SLAVES; ++i )
+    {
+        slaves[i] = new SlaveThread( i == 0 ? SLOW_TIME : FAST_TIME );
+        slaves[i]->start();
+    }
+    _mapped.waitEQ( N_SLAVES );
+
+    for( uint32_t i = 0; i < N_ITEMS; ++i )
+        master.push() << i;
+
+    lunchbox::Clock clock;
+    _start = true;
+    for( size_t i = 0; i < N_SLAVES; ++i )
+        TEST( slaves[i]->join( ));
+    const float time = clock.getTimef();
+
+    for( size_t i = 0; i < N_ITEMS; ++i )
+        TESTINFO( _consumed[i] == 1, "item " << i << " consumed "
+                  << _consumed[i] << " times" );
+
+    std::cout << "Frame time " << time << " ms, one prefetch of the slow "
+              << "slave takes " << PREFETCH_AMOUNT * SLOW_TIME
+              << " ms. Items per slave:";
+    for( size_t i = 0; i < N_SLAVES; ++i )
+    {
+        std::cout << ' ' << slaves[i]->nItems;
+        delete slaves[i];
+    }
+    std::cout << std::endl;
+
+    server->deregisterObject( &master );
+    TEST( server->close( ));
+    server = 0;
+
+    co::exit();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,204 @@
+
+/* Copyright (c) 2026, The Collage Authors
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Simulates RSP congestion control with one clean and one lossy reader in a
+// loopback multicast group, the loss being injected in software. Prints how
+// much the send rate oscillates with the version 0 rate control, driven by
+// nacks, and with the version 1 control, driven by the loss and round-trip
+// time reported by each reader.
+// Usage: ./rspCongestion
+
+#include <test.h>
+
+#include <co/buffer.h>
+#include <co/connection.h>
+#include <co/connectionDescription.h>
+#include <co/connectionSet.h>
+#include <co/global.h>
+#include <co/init.h>
+#include <co/rspConnection.h> // private header
+#include <lunchbox/clock.h>
+#include <lunchbox/rng.h>
+
+#include <cmath>
+#include <iostream>
+
+#define PACKETSIZE LB_64KB
+#define N_PACKETS 512
+#define N_MEMBERS 3
+#define DROP_INTERVAL 50
+
+namespace
+{
+co::Connections _accept( co::ConnectionPtr listener )
+{
+    co::ConnectionSet set;
+    set.addConnection( listener );
+
+    co::Connections connections;
+    while( connections.size() < N_MEMBERS )
+    {
+        TEST( set.select( 10000 ) == co::ConnectionSet::EVENT_CONNECT );
+        connections.push_back( listener->acceptSync( ));
+        TEST( connections.back( ));
+    }
+    return connections;
+}
+
+co::RSPConnection* _getRSP( co::ConnectionPtr connection )
+{
+    return static_cast< co::RSPConnection* >( connection.get( ));
+}
+
+co::ConnectionPtr _find( const co::Connections& connections, const uint16_t id )
+{
+    for( co::ConnectionsCIter i = connections.begin();
+         i != connections.end(); ++i )
+    {
+        if( _getRSP( *i )->getID() == id )
+            return *i;
+    }
+    TEST( false );
+    return 0;
+}
+
+class Reader : public lunchbox::Thread
+{
+public:
+    explicit Reader( co::ConnectionPtr connection )
+        : _connection( connection ) {}
+
+    virtual void run()
+    {
+        co::Buffer buffer;
+        co::BufferPtr syncBuffer;
+
+        for( size_t i = 0; i < N_PACKETS; ++i )
+        {
+            buffer.setSize( 0 );
+            _connection->recvNB( &buffer, PACKETSIZE );
+            TEST( _connection->recvSync( syncBuffer ));
+            TEST( syncBuffer == &buffer );
+            TEST( buffer.getSize() == PACKETSIZE );
+        }
+    }
+
+private:
+    co::ConnectionPtr _connection;
+};
+
+void _simulate( const uint16_t version, const uint16_t port )
+{
+    co::ConnectionDescriptionPtr desc = new co::ConnectionDescription;
+    desc->type = co::CONNECTIONTYPE_RSP;
+    desc->setHostname( "239.255.12.39" );
+    desc->port = port;
+    desc->bandwidth = 1048576; // KB/s, let RSP find the loopback limit
+
+    co::ConnectionPtr writer = co::Connection::create( desc );
+    co::ConnectionPtr clean = co::Connection::create( desc );
+    co::ConnectionPtr lossy = co::Connection::create( desc );
+    _getRSP( clean )->setProtocolVersion( version );
+    _getRSP( lossy )->setProtocolVersion( version );
+    TESTINFO( writer->listen(), desc );
+    TESTINFO( clean->listen(), desc );
+    TESTINFO( lossy->listen(), desc );
+    writer->acceptNB();
+    clean->acceptNB();
+    lossy->acceptNB();
+    _getRSP( lossy )->setDropInterval( DROP_INTERVAL );
+
+    const co::Connections writers = _accept( writer );
+    const co::Connections cleans = _accept( clean );
+    const co::Connections lossies = _accept( lossy );
+    const uint16_t writerID = _getRSP( writer )->getID();
+    Reader self( _find( writers, writerID ));
+    Reader cleanReader( _find( cleans, writerID ));
+    Reader lossyReader( _find( lossies, writerID ));
+    TEST( self.start( ));
+    TEST( cleanReader.start( ));
+    TEST( lossyReader.start( ));
+
+    // sample the send rate after each write
+    std::vector< uint8_t > data( PACKETSIZE );
+    std::vector< float > rates;
+    lunchbox::Clock clock;
+    for( size_t i = 0; i < N_PACKETS; ++i )
+    {
+        TEST( writer->send( &data.front(), PACKETSIZE ));
+        rates.push_back( float( _getRSP( writer )->getSendRate( )));
+    }
+    TEST( cleanReader.join( ));
+    TEST( lossyReader.join( ));
+    const float time = clock.getTimef();
+    TEST( self.join( ));
+    TEST( _getRSP( writer )->getProtocolVersion() == version );
+
+    float mean = 0.f;
+    for( size_t i = 0; i < rates.size(); ++i )
+        mean += rates[i];
+    mean /= float( rates.size( ));
+    float variance = 0.f;
+    for( size_t i = 0; i < rates.size(); ++i )
+        variance += ( rates[i] - mean ) * ( rates[i] - mean );
+    variance /= float( rates.size( ));
+
+    std::cout << "Version " << version << ": "
+              << float( N_PACKETS ) * PACKETSIZE / 1048.576f / time
+              << " MB/s, send rate " << mean << " KB/s +- "
+              << std::sqrt( variance ) / mean * 100.f << "%" << std::endl;
+
+    const co::RSPConnection* lossyStats =
+        _getRSP( _find( writers, _getRSP( lossy )->getID( )));
+    const co::RSPConnection* cleanStats =
+        _getRSP( _find( writers, _getRSP( clean )->getID( )));
+    std::cout << "  lossy reader: " << lossyStats->getLossRate() * 100.f
+              << "% loss, " << lossyStats->getRoundTripTime() << " ms RTT, "
+              << lossyStats->getFairRate() << " KB/s" << std::endl
+              << "  clean reader: " << cleanStats->getLossRate() * 100.f
+              << "% loss, " << cleanStats->getRoundTripTime() << " ms RTT, "
+              << cleanStats->getFairRate() << " KB/s" << std::endl;
+
+    if( version > 0 ) // version 0 readers do not report their loss
+    {
+        // the writer knows the loss injected on the lossy reader
+        TESTINFO( lossyStats->getLossRate() >= .5f / DROP_INTERVAL,
+                  lossyStats->getLossRate( ));
+        TESTINFO( lossyStats->getRoundTripTime() > 0.f,
+                  lossyStats->getRoundTripTime( ));
+    }
+
+    lossy->close();
+    clean->close();
+    writer->close();
+}
+}
+
+int main( int argc, char **argv )
+{
+    TEST( co::init( argc, argv ));
+    co::Global::setIAttribute( co::Global::IATTR_RSP_MULTICAST_LOOPBACK, 1 );
+    co::Global::setIAttribute( co::Global::IATTR_RSP_FEC_GROUP_SIZE, 0 );
+
+    lunchbox::RNG rng;
+    const uint16_t port = (rng.get<uint16_t>() % 60000) + 1024;
+    _simulate( 0, port );
+    _simulate( 1, port + 1 );
+
+    co::exit();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,170 @@
+
+/* Copyright (c) 2026, The Collage Authors
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests the RSP forward error correction by dropping every nth datagram on a
+// reader in a loopback multicast group. Isolated losses are repaired from the
+// parity by the reader, without any retransmission.
+// Usage: ./rspFEC
+
+#include <test.h>
+
+#include <co/buffer.h>
+#include <co/connection.h>
+#include <co/connectionDescription.h>
+#include <co/connectionSet.h>
+#include <co/global.h>
+#include <co/init.h>
+#include <co/rspConnection.h> // private header
+#include <lunchbox/clock.h>
+#include <lunchbox/rng.h>
+
+#include <iostream>
+
+#define PACKETSIZE LB_64KB
+#define N_PACKETS 256
+#define N_MEMBERS 2
+#define DROP_INTERVAL 50 // larger than the group size: all losses are isolated
+#define GROUP_SIZE 16
+
+namespace
+{
+co::Connections _accept( co::ConnectionPtr listener )
+{
+    co::ConnectionSet set;
+    set.addConnection( listener );
+
+    co::Connections connections;
+    while( connections.size() < N_MEMBERS )
+    {
+        TEST( set.select( 10000 ) == co::ConnectionSet::EVENT_CONNECT );
+        connections.push_back( listener->acceptSync( ));
+        TEST( connections.back( ));
+    }
+    return connections;
+}
+
+co::RSPConnection* _getRSP( co::ConnectionPtr connection )
+{
+    return static_cast< co::RSPConnection* >( connection.get( ));
+}
+
+co::ConnectionPtr _find( const co::Connections& connections, const uint16_t id )
+{
+    for( co::ConnectionsCIter i = connections.begin();
+         i != connections.end(); ++i )
+    {
+        if( _getRSP( *i )->getID() == id )
+            return *i;
+    }
+    TEST( false );
+    return 0;
+}
+
+class Reader : public lunchbox::Thread
+{
+public:
+    explicit Reader( co::ConnectionPtr connection )
+        : _connection( connection ) {}
+
+    virtual void run()
+    {
+        co::Buffer buffer;
+        co::BufferPtr syncBuffer;
+
+        for( size_t i = 0; i < N_PACKETS; ++i )
+        {
+            buffer.setSize( 0 );
+            _connection->recvNB( &buffer, PACKETSIZE );
+            TEST( _connection->recvSync( syncBuffer ));
+            TEST( syncBuffer == &buffer );
+            TEST( buffer.getSize() == PACKETSIZE );
+
+            const uint8_t* data = buffer.getData();
+            for( size_t j = 0; j < PACKETSIZE; j += 997 )
+                TESTINFO( data[ j ] == uint8_t( i + j ),
+                          "packet " << i << " byte " << j );
+        }
+    }
+
+private:
+    co::ConnectionPtr _connection;
+};
+
+void _testDrops( const int32_t groupSize, const uint16_t port )
+{
+    co::Global::setIAttribute( co::Global::IATTR_RSP_FEC_GROUP_SIZE,
+                               groupSize );
+
+    co::ConnectionDescriptionPtr desc = new co::ConnectionDescription;
+    desc->type = co::CONNECTIONTYPE_RSP;
+    desc->setHostname( "239.255.12.37" );
+    desc->port = port;
+
+    co::ConnectionPtr writer = co::Connection::create( desc );
+    co::ConnectionPtr reader = co::Connection::create( desc );
+    TESTINFO( writer->listen(), desc );
+    TESTINFO( reader->listen(), desc );
+    writer->acceptNB();
+    reader->acceptNB();
+    _getRSP( reader )->setDropInterval( DROP_INTERVAL );
+
+    const co::Connections writers = _accept( writer );
+    const co::Connections readers = _accept( reader );
+    const uint16_t writerID = _getRSP( writer )->getID();
+    Reader self( _find( writers, writerID ));
+    Reader remote( _find( readers, writerID ));
+    TEST( self.start( ));
+    TEST( remote.start( ));
+
+    std::vector< uint8_t > data( PACKETSIZE );
+    lunchbox::Clock clock;
+    for( size_t i = 0; i < N_PACKETS; ++i )
+    {
+        for( size_t j = 0; j < PACKETSIZE; ++j )
+            data[ j ] = uint8_t( i + j );
+        TEST( writer->send( &data.front(), PACKETSIZE ));
+    }
+    TEST( remote.join( ));
+    const float time = clock.getTimef();
+    TEST( self.join( ));
+
+    const uint64_t nRecovered = _getRSP( reader )->getNumRecovered();
+    TESTINFO( ( nRecovered > 0 ) == ( groupSize > 0 ), nRecovered );
+
+    std::cout << "Dropping every " << DROP_INTERVAL << "th datagram, "
+              << groupSize << " datagrams per parity: " << nRecovered
+              << " recovered, " << float( N_PACKETS ) * PACKETSIZE /
+                 1048.576f / time << " MB/s" << std::endl;
+
+    reader->close();
+    writer->close();
+}
+}
+
+int main( int argc, char **argv )
+{
+    TEST( co::init( argc, argv ));
+    co::Global::setIAttribute( co::Global::IATTR_RSP_MULTICAST_LOOPBACK, 1 );
+
+    lunchbox::RNG rng;
+    const uint16_t port = (rng.get<uint16_t>() % 60000) + 1024;
+    _testDrops( 0, port );
+    _testDrops( GROUP_SIZE, port + 1 );
+
+    co::exit();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,85 @@
+
+/* Copyright (c) 2026, The Collage Authors
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests that nodes on the same host connect over shared memory, unless
+// disabled using IATTR_SHM_SAME_HOST.
+
+#include <test.h>
+
+#include <co/connection.h>
+#include <co/connectionDescription.h>
+#include <co/global.h>
+#include <co/init.h>
+#include <co/localNode.h>
+
+namespace
+{
+void _testSameHost( const bool shm )
+{
+    co::Global::setIAttribute( co::Global::IATTR_SHM_SAME_HOST, shm );
+
+    co::ConnectionDescriptionPtr desc = new co::ConnectionDescription;
+    desc->type = co::CONNECTIONTYPE_TCPIP;
+    desc->setHostname( "127.0.0.1" );
+
+    co::LocalNodePtr server = new co::LocalNode;
+    server->addConnectionDescription( desc );
+    TEST( server->listen( ));
+
+    desc = new co::ConnectionDescription;
+    desc->type = co::CONNECTIONTYPE_TCPIP;
+    desc->setHostname( "127.0.0.1" );
+
+    co::LocalNodePtr client = new co::LocalNode;
+    client->addConnectionDescription( desc );
+    TEST( client->listen( ));
+
+    // the server's descriptions include its shared memory listener
+    co::NodePtr serverProxy = new co::Node;
+    const co::ConnectionDescriptions& descs =
+        server->getConnectionDescriptions();
+    for( co::ConnectionDescriptionsCIter i = descs.begin();
+         i != descs.end(); ++i )
+    {
+        serverProxy->addConnectionDescription( *i );
+    }
+    TEST( client->connect( serverProxy ));
+
+    const co::ConnectionType type =
+        serverProxy->getConnection()->getDescription()->type;
+    TESTINFO( type == ( shm ? co::CONNECTIONTYPE_SHM :
+                              co::CONNECTIONTYPE_TCPIP ), type );
+
+    TEST( client->disconnect( serverProxy ));
+    TEST( client->close( ));
+    TEST( server->close( ));
+}
+}
+
+int main( int argc, char **argv )
+{
+    TEST( co::init( argc, argv ));
+
+#ifdef __linux__
+    _testSameHost( true );
+    _testSameHost( false );
+    co::Global::setIAttribute( co::Global::IATTR_SHM_SAME_HOST, 1 );
+#endif
+
+    co::exit();
+    return EXIT_SUCCESS;
+}
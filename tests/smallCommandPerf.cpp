@@ -0,0 +1,169 @@
+
+/* Copyright (c) 2026, The Collage Authors
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests that SmallOCommand sends the same bytes as OCommand, and measures the
+// send rate of small commands built with both over a pipe and TCP loopback.
+// Usage: ./smallCommandPerf
+
+#include <test.h>
+
+#include <co/buffer.h>
+#include <co/commands.h>
+#include <co/connection.h>
+#include <co/connectionDescription.h>
+#include <co/init.h>
+#include <co/nodeCommand.h> // private header
+#include <co/oCommand.h>
+#include <co/smallOCommand.h> // private header
+#include <lunchbox/clock.h>
+
+#include <iostream>
+
+#define N_COMMANDS 102400
+#define N_BATCH 64 // commands per receive
+
+namespace
+{
+class Reader : public lunchbox::Thread
+{
+public:
+    explicit Reader( co::ConnectionPtr connection )
+        : _connection( connection ) {}
+
+    virtual void run()
+    {
+        co::Buffer buffer;
+        co::BufferPtr syncBuffer;
+        for( size_t i = 0; i < N_COMMANDS; i += N_BATCH )
+        {
+            buffer.setSize( 0 );
+            _connection->recvNB( &buffer, co::COMMAND_MINSIZE * N_BATCH );
+            TEST( _connection->recvSync( syncBuffer ));
+        }
+    }
+
+private:
+    co::ConnectionPtr _connection;
+};
+
+void _connect( const co::ConnectionType type, co::ConnectionPtr& writer,
+               co::ConnectionPtr& reader )
+{
+    co::ConnectionDescriptionPtr desc = new co::ConnectionDescription;
+    desc->type = type;
+    desc->setHostname( "127.0.0.1" );
+
+    co::ConnectionPtr listener = co::Connection::create( desc );
+    TEST( listener );
+    if( type == co::CONNECTIONTYPE_PIPE )
+    {
+        writer = listener;
+        TEST( writer->connect( ));
+        reader = writer->acceptSync();
+        return;
+    }
+
+    TESTINFO( listener->listen(), desc );
+    listener->acceptNB();
+    writer = co::Connection::create( desc );
+    TEST( writer->connect( ));
+    reader = listener->acceptSync();
+}
+
+co::BufferPtr _receive( co::ConnectionPtr reader, co::Buffer& buffer )
+{
+    co::BufferPtr syncBuffer;
+    buffer.setSize( 0 );
+    reader->recvNB( &buffer, co::COMMAND_MINSIZE );
+    TEST( reader->recvSync( syncBuffer ));
+    TEST( buffer.getSize() == co::COMMAND_MINSIZE );
+    return syncBuffer;
+}
+
+void _testWireBytes( co::ConnectionPtr writer, co::ConnectionPtr reader )
+{
+    const co::uint128_t id( 17, 42 );
+    const std::string name( "small" );
+    {
+        co::OCommand( co::Connections( 1, writer ), co::CMD_NODE_PING )
+            << uint32_t( 7 ) << id << name;
+    }
+    {
+        co::SmallOCommand( writer, co::CMD_NODE_PING )
+            << uint32_t( 7 ) << id << name;
+    }
+
+    co::Buffer expected;
+    co::Buffer actual;
+    _receive( reader, expected );
+    _receive( reader, actual );
+
+    const uint64_t size = *reinterpret_cast< const uint64_t* >(
+        expected.getData( ));
+    TESTINFO( size == co::OCommand::getSize() + sizeof( uint32_t ) +
+                      sizeof( id ) + sizeof( uint64_t ) + name.length(),
+              size );
+    TEST( ::memcmp( expected.getData(), actual.getData(), size ) == 0 );
+}
+
+float _measure( co::ConnectionPtr writer, co::ConnectionPtr reader,
+                const bool small )
+{
+    Reader drain( reader );
+    TEST( drain.start( ));
+
+    lunchbox::Clock clock;
+    for( uint32_t i = 0; i < N_COMMANDS; ++i )
+    {
+        if( small )
+            co::SmallOCommand( writer, co::CMD_NODE_ACK_REQUEST ) << i;
+        else
+            co::OCommand( co::Connections( 1, writer ),
+                          co::CMD_NODE_ACK_REQUEST ) << i;
+    }
+    TEST( drain.join( ));
+    return N_COMMANDS / clock.getTimef();
+}
+}
+
+int main( int argc, char **argv )
+{
+    TEST( co::init( argc, argv ));
+
+    const co::ConnectionType types[] = { co::CONNECTIONTYPE_PIPE,
+                                         co::CONNECTIONTYPE_TCPIP };
+    const char* const names[] = { "pipe", "TCP" };
+    for( size_t i = 0; i < 2; ++i )
+    {
+        co::ConnectionPtr writer;
+        co::ConnectionPtr reader;
+        _connect( types[i], writer, reader );
+        _testWireBytes( writer, reader );
+
+        const float oRate = _measure( writer, reader, false );
+        const float smallRate = _measure( writer, reader, true );
+        std::cout << names[i] << ": OCommand " << oRate
+                  << " commands/ms, SmallOCommand " << smallRate
+                  << " commands/ms" << std::endl;
+
+        writer->close();
+        reader->close();
+    }
+
+    co::exit();
+    return EXIT_SUCCESS;
+}
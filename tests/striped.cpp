@@ -0,0 +1,179 @@
+
+/* Copyright (c) 2026, The Collage Authors
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Tests that striped connections keep the content and order of interleaved
+// large and small writes, and connects two nodes using a striped connection.
+
+#include <test.h>
+
+#include <co/buffer.h>
+#include <co/connection.h>
+#include <co/connectionDescription.h>
+#include <co/connectionSet.h>
+#include <co/global.h>
+#include <co/init.h>
+#include <co/localNode.h>
+
+#include <string.h>
+
+#define N_MIXED 64
+#define SMALL_SIZE 64
+#define LARGE_SIZE 1048576
+
+namespace
+{
+uint64_t _getSize( const size_t i )
+{
+    // odd sizes of large writes leave stripes of different sizes
+    return ( i % 2 ) ? SMALL_SIZE : LARGE_SIZE + i;
+}
+
+void _fill( co::Buffer& buffer, const size_t i )
+{
+    buffer.resize( _getSize( i ));
+    for( uint64_t j = 0; j < buffer.getSize(); ++j )
+        buffer[ j ] = uint8_t( i + j * 7 );
+}
+
+class Reader : public lunchbox::Thread
+{
+public:
+    explicit Reader( co::ConnectionPtr connection )
+        : _connection( connection ) {}
+
+    virtual void run()
+    {
+        co::Buffer buffer;
+        co::Buffer expected;
+        co::BufferPtr syncBuffer;
+        for( size_t i = 0; i < N_MIXED; ++i )
+        {
+            const uint64_t size = _getSize( i );
+            buffer.setSize( 0 );
+            _connection->recvNB( &buffer, size );
+            TEST( _connection->recvSync( syncBuffer ));
+            TEST( buffer.getSize() == size );
+
+            _fill( expected, i );
+            TESTINFO( ::memcmp( buffer.getData(), expected.getData(),
+                                size ) == 0, i );
+        }
+    }
+
+private:
+    co::ConnectionPtr _connection;
+};
+
+void _connect( const co::ConnectionType type, co::ConnectionPtr& writer,
+               co::ConnectionPtr& reader )
+{
+    co::ConnectionDescriptionPtr desc = new co::ConnectionDescription;
+    desc->type = type;
+    desc->setHostname( "127.0.0.1" );
+
+    co::ConnectionPtr listener = co::Connection::create( desc );
+    TEST( listener );
+    TESTINFO( listener->listen(), desc );
+    listener->acceptNB();
+
+    writer = co::Connection::create( desc );
+    TEST( writer->connect( ));
+
+    // striped connections complete their handshake over several accepts
+    co::ConnectionSet set;
+    set.addConnection( listener );
+    while( !reader )
+    {
+        TEST( set.select( 10000 ) == co::ConnectionSet::EVENT_CONNECT );
+        reader = listener->acceptSync();
+    }
+    listener->close();
+}
+
+void _testMixed( const co::ConnectionType type )
+{
+    co::ConnectionPtr writer;
+    co::ConnectionPtr reader;
+    _connect( type, writer, reader );
+
+    Reader thread( reader );
+    TEST( thread.start( ));
+
+    co::Buffer data;
+    for( size_t i = 0; i < N_MIXED; ++i )
+    {
+        _fill( data, i );
+        TEST( writer->send( data.getData(), data.getSize( )));
+    }
+    TEST( thread.join( ));
+
+    writer->close();
+    reader->close();
+}
+
+void _testNodes()
+{
+    co::ConnectionDescriptionPtr desc = new co::ConnectionDescription;
+    desc->type = co::CONNECTIONTYPE_STRIPED;
+    desc->setHostname( "127.0.0.1" );
+
+    co::LocalNodePtr server = new co::LocalNode;
+    server->addConnectionDescription( desc );
+    TEST( server->listen( ));
+
+    co::ConnectionDescriptionPtr clientDesc = new co::ConnectionDescription;
+    clientDesc->type = co::CONNECTIONTYPE_TCPIP;
+    clientDesc->setHostname( "127.0.0.1" );
+
+    co::LocalNodePtr client = new co::LocalNode;
+    client->addConnectionDescription( clientDesc );
+    TEST( client->listen( ));
+
+    co::NodePtr serverProxy = new co::Node;
+    serverProxy->addConnectionDescription( desc );
+    TEST( client->connect( serverProxy ));
+
+    const co::ConnectionType type =
+        serverProxy->getConnection()->getDescription()->type;
+    TESTINFO( type == co::CONNECTIONTYPE_STRIPED, type );
+
+    TEST( client->disconnect( serverProxy ));
+    TEST( client->close( ));
+    TEST( server->close( ));
+}
+}
+
+int main( int argc, char **argv )
+{
+    TEST( co::init( argc, argv ));
+
+#ifdef __linux__
+    _testMixed( co::CONNECTIONTYPE_STRIPED );
+
+    // the threshold is a tuning knob, correctness must not depend on it
+    const int32_t minSize =
+        co::Global::getIAttribute( co::Global::IATTR_STRIPED_MIN_SIZE_KB );
+    co::Global::setIAttribute( co::Global::IATTR_STRIPED_MIN_SIZE_KB, 1 );
+    _testMixed( co::CONNECTIONTYPE_STRIPED );
+    co::Global::setIAttribute( co::Global::IATTR_STRIPED_MIN_SIZE_KB, minSize );
+
+    _testNodes();
+#endif
+
+    co::exit();
+    return EXIT_SUCCESS;
+}
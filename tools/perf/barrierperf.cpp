@@ -0,0 +1,169 @@
+
+/* Copyright (c) 2026, The Collage Authors
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Measures co::Barrier enter latency between multiple processes
+// Usage: see 'coBarrierperf -h'
+//   master: coBarrierperf -n <height> [-t] [--co-listen <desc>]
+//   others: coBarrierperf -c <master IP[:port][:protocol]>
+
+#include <co/co.h>
+#include <tclap/CmdLine.h>
+#include <iostream>
+
+namespace
+{
+static co::uint128_t _barrierID( 0xB4BB1E5A1D6A4C2Bull, 0x9E3779B97F4A7C15ull );
+}
+
+int main( int argc, char **argv )
+{
+    if( !co::init( argc, argv ))
+        return EXIT_FAILURE;
+
+    co::ConnectionDescriptionPtr remote;
+    uint32_t height = 2;
+    uint32_t nRounds = 10000;
+    uint32_t fanout = 4;
+    bool useTree = false;
+
+    try // command line parsing
+    {
+        TCLAP::CmdLine command(
+            "barrierperf - Collage barrier latency benchmark tool", ' ',
+            co::Version::getString( ));
+        TCLAP::ValueArg< std::string > remoteArg( "c", "connect",
+                                         "connect to barrier master node",
+                                                  false, "",
+                                                  "IP[:port][:protocol]",
+                                                  command );
+        TCLAP::ValueArg< uint32_t > heightArg( "n", "height",
+                                      "number of participating processes",
+                                               false, height, "unsigned",
+                                               command );
+        TCLAP::ValueArg< uint32_t > roundsArg( "r", "rounds",
+                                               "number of barrier rounds",
+                                               false, nRounds, "unsigned",
+                                               command );
+        TCLAP::SwitchArg treeArg( "t", "tree",
+                                  "Use the tree instead of the central barrier",
+                                  command, false );
+        TCLAP::ValueArg< uint32_t > fanoutArg( "f", "fanout",
+                                               "tree fanout, implies --tree",
+                                               false, fanout, "unsigned",
+                                               command );
+        command.parse( argc, argv );
+
+        if( remoteArg.isSet( ))
+        {
+            remote = new co::ConnectionDescription;
+            remote->port = 4242;
+            remote->fromString( remoteArg.getValue( ));
+        }
+        if( heightArg.isSet( ))
+            height = heightArg.getValue();
+        if( roundsArg.isSet( ))
+            nRounds = roundsArg.getValue();
+        if( fanoutArg.isSet( ))
+            fanout = fanoutArg.getValue();
+        useTree = treeArg.isSet() || fanoutArg.isSet();
+    }
+    catch( TCLAP::ArgException& exception )
+    {
+        LBERROR << "Command line parse error: " << exception.error()
+                << " for argument " << exception.argId() << std::endl;
+
+        co::exit();
+        return EXIT_FAILURE;
+    }
+
+    co::LocalNodePtr localNode = new co::LocalNode;
+    if( !localNode->initLocal( argc, argv ))
+    {
+        co::exit();
+        return EXIT_FAILURE;
+    }
+
+    // tree nodes connect to each other, so all processes need a listener
+    if( localNode->getConnectionDescriptions().empty( ))
+    {
+        co::ConnectionDescriptionPtr description =
+            new co::ConnectionDescription;
+        if( !remote )
+            description->port = 4242;
+        localNode->addListener( description );
+    }
+
+    co::Barrier* barrier = 0;
+    if( remote )
+    {
+        co::NodePtr master = new co::Node;
+        master->addConnectionDescription( remote );
+        if( !localNode->connect( master ))
+        {
+            LBERROR << "Can't connect barrier master " << remote << std::endl;
+            localNode->exitLocal();
+            co::exit();
+            return EXIT_FAILURE;
+        }
+
+        barrier = new co::Barrier;
+        while( !localNode->mapObject( barrier, _barrierID ))
+            lunchbox::sleep( 100 /*ms*/ ); // master not yet registered
+    }
+    else
+    {
+        barrier = new co::Barrier( localNode, height );
+        if( useTree )
+            barrier->setAlgorithm( co::Barrier::ALGORITHM_TREE, fanout );
+        barrier->setID( _barrierID );
+        LBCHECK( localNode->registerObject( barrier ));
+        std::cerr << "Barrier master, waiting for " << height - 1
+                  << " processes" << std::endl;
+    }
+
+    barrier->enter(); // all processes are up, tree is set up after this round
+
+    lunchbox::Clock clock;
+    for( uint32_t i = 0; i < nRounds; ++i )
+        barrier->enter();
+    const float time = clock.getTimef();
+
+    std::cerr << barrier->getHeight() << " processes, "
+              << ( barrier->getAlgorithm() == co::Barrier::ALGORITHM_TREE ?
+                   "tree" : "central" ) << " barrier: "
+              << time * 1000.f / float( nRounds ) << " us/enter" << std::endl;
+
+    if( remote )
+        localNode->unmapObject( barrier );
+    else
+    {
+        // wait for all others to unmap and disconnect
+        co::Nodes nodes;
+        localNode->getNodes( nodes, false );
+        while( !nodes.empty( ))
+        {
+            lunchbox::sleep( 100 /*ms*/ );
+            localNode->getNodes( nodes, false );
+        }
+        localNode->deregisterObject( barrier );
+    }
+    delete barrier;
+
+    LBCHECK( localNode->exitLocal( ));
+    LBCHECK( co::exit( ));
+    return EXIT_SUCCESS;
+}
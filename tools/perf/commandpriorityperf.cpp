@@ -0,0 +1,194 @@
+
+/* Copyright (c) 2026, The Collage Authors
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Measures the barrier latency while a large object is pushed over the same
+// connection, with and without fragmenting the object data.
+// Usage: coCommandPriorityperf
+
+#include <co/barrier.h>
+#include <co/connectionDescription.h>
+#include <co/dataIStream.h>
+#include <co/dataOStream.h>
+#include <co/global.h>
+#include <co/init.h>
+#include <co/localNode.h>
+#include <co/node.h>
+#include <co/object.h>
+#include <lunchbox/clock.h>
+#include <lunchbox/monitor.h>
+#include <lunchbox/thread.h>
+
+#include <iostream>
+#include <vector>
+
+#define OBJECT_SIZE ( 64 * 1024 * 1024 )
+#define N_PUSHES 4
+#define N_ENTERS 100
+
+namespace
+{
+lunchbox::Monitor< size_t > _nPushes( 0 );
+
+class Object : public co::Object
+{
+public:
+    Object() : _data( OBJECT_SIZE )
+    {
+        for( size_t i = 0; i < OBJECT_SIZE; ++i )
+            _data[ i ] = uint8_t( i * 7 );
+    }
+
+protected:
+    virtual ChangeType getChangeType() const { return INSTANCE; }
+    virtual void getInstanceData( co::DataOStream& os )
+        { os << co::Array< const uint8_t >( &_data.front(), OBJECT_SIZE ); }
+    virtual void applyInstanceData( co::DataIStream& ) { LBUNREACHABLE; }
+
+private:
+    std::vector< uint8_t > _data;
+};
+
+class Client : public co::LocalNode
+{
+protected:
+    virtual void objectPush( const co::uint128_t&, const co::uint128_t&,
+                             const co::uint128_t&, co::DataIStream& istream )
+    {
+        std::vector< uint8_t > data( OBJECT_SIZE );
+        istream >> co::Array< uint8_t >( &data.front(), OBJECT_SIZE );
+        LBCHECK( !istream.hasData( ));
+        for( size_t i = 0; i < OBJECT_SIZE; i += 4093 )
+            LBCHECK( data[ i ] == uint8_t( i * 7 ));
+        ++_nPushes;
+    }
+};
+
+class Pusher : public lunchbox::Thread
+{
+public:
+    Pusher( Object& object, co::NodePtr client )
+        : _object( object )
+    {
+        _nodes.push_back( client );
+    }
+
+    virtual void run()
+    {
+        for( size_t i = 0; i < N_PUSHES; ++i )
+            _object.push( 42, 42, _nodes );
+    }
+
+private:
+    Object& _object;
+    co::Nodes _nodes;
+};
+
+/** @return the time of one barrier enter in ms. */
+float _enter( co::Barrier& barrier )
+{
+    lunchbox::Clock clock;
+    barrier.enter();
+    return clock.getTimef();
+}
+
+void _measure( const std::string& name, co::LocalNodePtr server,
+               co::LocalNodePtr client )
+{
+    co::Barrier master( server, 1 );
+    LBCHECK( server->registerObject( &master ));
+
+    co::Barrier barrier;
+    LBCHECK( client->mapObject( &barrier, master.getID( )));
+
+    float idle = 0.f;
+    for( size_t i = 0; i < N_ENTERS; ++i )
+        idle += _enter( barrier );
+    idle /= float( N_ENTERS );
+
+    Object object;
+    LBCHECK( server->registerObject( &object ));
+    co::NodePtr clientProxy = server->getNode( client->getNodeID( ));
+    LBCHECK( clientProxy );
+
+    _nPushes = 0;
+    Pusher pusher( object, clientProxy );
+    LBCHECK( pusher.start( ));
+
+    size_t nEnters = 0;
+    float average = 0.f;
+    float maximum = 0.f;
+    while( _nPushes < N_PUSHES )
+    {
+        const float time = _enter( barrier );
+        average += time;
+        maximum = LB_MAX( maximum, time );
+        ++nEnters;
+    }
+    LBCHECK( pusher.join( ));
+    if( nEnters > 0 )
+        average /= float( nEnters );
+
+    std::cout << name << ": barrier " << idle << " ms idle, "
+              << average << " ms average, " << maximum
+              << " ms maximum during " << N_PUSHES << " pushes of "
+              << OBJECT_SIZE / 1048576 << " MB" << std::endl;
+
+    server->deregisterObject( &object );
+    client->unmapObject( &barrier );
+    server->deregisterObject( &master );
+}
+}
+
+int main( int argc, char **argv )
+{
+    LBCHECK( co::init( argc, argv ));
+
+    co::ConnectionDescriptionPtr desc = new co::ConnectionDescription;
+    desc->type = co::CONNECTIONTYPE_TCPIP;
+    desc->setHostname( "127.0.0.1" );
+
+    co::LocalNodePtr server = new co::LocalNode;
+    server->addConnectionDescription( desc );
+    LBCHECK( server->listen( ));
+
+    co::NodePtr serverProxy = new co::Node;
+    serverProxy->addConnectionDescription( desc );
+
+    desc = new co::ConnectionDescription;
+    desc->type = co::CONNECTIONTYPE_TCPIP;
+    desc->setHostname( "127.0.0.1" );
+
+    co::LocalNodePtr client = new Client;
+    client->addConnectionDescription( desc );
+    LBCHECK( client->listen( ));
+    LBCHECK( client->connect( serverProxy ));
+
+    _measure( "fragmented", server, client );
+
+    const int32_t size =
+        co::Global::getIAttribute( co::Global::IATTR_OBJECT_FRAGMENT_SIZE );
+    co::Global::setIAttribute( co::Global::IATTR_OBJECT_FRAGMENT_SIZE, 0 );
+    _measure( "unfragmented", server, client );
+    co::Global::setIAttribute( co::Global::IATTR_OBJECT_FRAGMENT_SIZE, size );
+
+    LBCHECK( client->disconnect( serverProxy ));
+    LBCHECK( client->close( ));
+    LBCHECK( server->close( ));
+
+    co::exit();
+    return EXIT_SUCCESS;
+}
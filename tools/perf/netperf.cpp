@@ -313,10 +313,10 @@ int main( int argc, char **argv )
                                 ' ', co::Version::getString( ));
         TCLAP::ValueArg< std::string > clientArg( "c", "client",
                                                   "run as client", true, "",
-                                                  "IP[:port][:protocol]" );
+                                     "IP[:port][:protocol] or name:SHM" );
         TCLAP::ValueArg< std::string > serverArg( "s", "server",
                                                   "run as server", true, "",
-                                                  "IP[:port][:protocol]" );
+                                     "IP[:port][:protocol] or name:SHM" );
         TCLAP::SwitchArg threadedArg( "t", "threaded",
                           "Run each receive in a separate thread (server only)",
                                       command, false );
@@ -333,6 +333,9 @@ int main( int argc, char **argv )
         TCLAP::ValueArg<uint32_t> delayArg( "d", "delay",
                                 "wait time (ms) between receives (server only)",
                                             false, 0, "unsigned", command );
+        TCLAP::SwitchArg uringArg( "u", "ioUring",
+                                   "Receive TCP data using io_uring (Linux)",
+                                   command, false );
 
         command.xorAdd( clientArg, serverArg );
         command.parse( argc, argv );
@@ -355,6 +358,8 @@ int main( int argc, char **argv )
             waitTime = waitArg.getValue();
         if( delayArg.isSet( ))
             _delay = delayArg.getValue();
+        if( uringArg.isSet( ))
+            co::Global::setIAttribute( co::Global::IATTR_TCPIP_IO_URING, 1 );
     }
     catch( TCLAP::ArgException& exception )
     {
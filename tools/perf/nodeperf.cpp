@@ -174,6 +174,9 @@ int main( int argc, char **argv )
         TCLAP::ValueArg<uint32_t> waitArg( "w", "wait",
                                            "wait time (ms) between sends",
                                            false, 0, "unsigned", command );
+        TCLAP::SwitchArg uringArg( "u", "ioUring",
+                                   "Receive TCP data using io_uring (Linux)",
+                                   command, false );
         command.parse( argc, argv );
 
         if( remoteArg.isSet( ))
@@ -191,6 +194,8 @@ int main( int argc, char **argv )
             nPackets = uint32_t( packetsArg.getValue( ));
         if( waitArg.isSet( ))
             waitTime = waitArg.getValue();
+        if( uringArg.isSet( ))
+            co::Global::setIAttribute( co::Global::IATTR_TCPIP_IO_URING, 1 );
     }
     catch( TCLAP::ArgException& exception )
     {
@@ -0,0 +1,109 @@
+
+/* Copyright (c) 2026, The Collage Authors
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Measures QueueMaster::push throughput from multiple producer threads.
+// Usage: coQueuePushperf
+
+#include <co/co.h>
+#include <co/queueItem.h>
+#include <co/queueMaster.h>
+#include <co/queueSlave.h>
+#include <lunchbox/clock.h>
+#include <lunchbox/monitor.h>
+
+#include <iomanip>
+#include <iostream>
+
+#define N_ITEMS 200000
+#define MAX_THREADS 8
+
+namespace
+{
+lunchbox::Monitor< bool > _start( false );
+
+class Producer : public lunchbox::Thread
+{
+public:
+    Producer( co::QueueMaster& master, const uint32_t nItems )
+        : _master( master ), _nItems( nItems ) {}
+
+    virtual void run()
+    {
+        _start.waitEQ( true );
+        for( uint32_t i = 0; i < _nItems; ++i )
+            _master.push( i & 3 ) << i << uint64_t( 0 );
+    }
+
+private:
+    co::QueueMaster& _master;
+    const uint32_t _nItems;
+};
+}
+
+int main( int argc, char **argv )
+{
+    LBCHECK( co::init( argc, argv ));
+
+    co::LocalNodePtr node = new co::LocalNode;
+    LBCHECK( node->initLocal( argc, argv ));
+
+    co::QueueMaster* master = new co::QueueMaster;
+    co::QueueSlave* slave = new co::QueueSlave( 1024, 4096 );
+    LBCHECK( node->registerObject( master ));
+    LBCHECK( node->mapObject( slave, master->getID(), co::VERSION_FIRST ));
+
+    for( size_t nThreads = 1; nThreads <= MAX_THREADS; nThreads <<= 1 )
+    {
+        const uint32_t nItems = N_ITEMS / nThreads;
+        Producer* producers[ MAX_THREADS ];
+        for( size_t i = 0; i < nThreads; ++i )
+        {
+            producers[i] = new Producer( *master, nItems );
+            producers[i]->start();
+        }
+
+        lunchbox::Clock clock;
+        _start = true;
+        for( size_t i = 0; i < nThreads; ++i )
+        {
+            LBCHECK( producers[i]->join( ));
+            delete producers[i];
+        }
+        const float time = clock.getTimef();
+        _start = false;
+
+        size_t nPopped = 0;
+        while( slave->pop().isValid( ))
+            ++nPopped;
+        LBCHECK( nPopped == nItems * nThreads );
+
+        std::cout << std::setw( 2 ) << nThreads << " producers: "
+                  << std::setw( 8 ) << float( nPopped ) / time
+                  << " pushs/ms" << std::endl;
+    }
+
+    node->unmapObject( slave );
+    node->deregisterObject( master );
+    delete slave;
+    delete master;
+
+    LBCHECK( node->exitLocal( ));
+    node = 0;
+
+    co::exit();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,151 @@
+
+/* Copyright (c) 2026, The Collage Authors
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Measures the RSP throughput between two members of a multicast group in one
+// process, using multicast loopback.
+// Usage: coRSPperf
+
+#include <co/buffer.h>
+#include <co/connection.h>
+#include <co/connectionDescription.h>
+#include <co/connectionSet.h>
+#include <co/global.h>
+#include <co/init.h>
+#include <co/rspConnection.h> // private header
+#include <lunchbox/clock.h>
+#include <lunchbox/rng.h>
+#include <lunchbox/thread.h>
+
+#include <ctime>
+#include <iostream>
+
+#define PACKETSIZE LB_64KB
+#define N_PACKETS 1024
+#define N_MEMBERS 2
+
+namespace
+{
+/** @return the connections of all members, once they are known. */
+co::Connections _accept( co::ConnectionPtr listener )
+{
+    co::ConnectionSet set;
+    set.addConnection( listener );
+
+    co::Connections connections;
+    while( connections.size() < N_MEMBERS )
+    {
+        LBCHECK( set.select( 10000 ) == co::ConnectionSet::EVENT_CONNECT );
+        connections.push_back( listener->acceptSync( ));
+        LBCHECK( connections.back( ));
+    }
+    return connections;
+}
+
+co::ConnectionPtr _find( const co::Connections& connections, const uint16_t id )
+{
+    for( co::ConnectionsCIter i = connections.begin();
+         i != connections.end(); ++i )
+    {
+        if( static_cast< const co::RSPConnection* >( i->get( ))->getID() == id )
+            return *i;
+    }
+    LBUNREACHABLE;
+    return 0;
+}
+
+uint16_t _getID( co::ConnectionPtr connection )
+{
+    return static_cast< const co::RSPConnection* >( connection.get( ))->getID();
+}
+
+class Reader : public lunchbox::Thread
+{
+public:
+    explicit Reader( co::ConnectionPtr connection )
+        : _connection( connection ) {}
+
+    virtual void run()
+    {
+        co::Buffer buffer;
+        co::BufferPtr syncBuffer;
+
+        for( size_t i = 0; i < N_PACKETS; ++i )
+        {
+            buffer.setSize( 0 );
+            _connection->recvNB( &buffer, PACKETSIZE );
+            LBCHECK( _connection->recvSync( syncBuffer ));
+            LBCHECK( syncBuffer == &buffer );
+            LBCHECK( buffer.getSize() == PACKETSIZE );
+        }
+    }
+
+private:
+    co::ConnectionPtr _connection;
+};
+}
+
+int main( int argc, char **argv )
+{
+    LBCHECK( co::init( argc, argv ));
+    co::Global::setIAttribute( co::Global::IATTR_RSP_MULTICAST_LOOPBACK, 1 );
+
+    lunchbox::RNG rng;
+    co::ConnectionDescriptionPtr desc = new co::ConnectionDescription;
+    desc->type = co::CONNECTIONTYPE_RSP;
+    desc->setHostname( "239.255.12.36" );
+    desc->port = (rng.get<uint16_t>() % 60000) + 1024;
+    desc->bandwidth = 1048576; // KB/s, let RSP find the loopback limit
+
+    co::ConnectionPtr writer = co::Connection::create( desc );
+    co::ConnectionPtr reader = co::Connection::create( desc );
+    LBCHECK( writer->listen( ));
+    LBCHECK( reader->listen( ));
+    writer->acceptNB();
+    reader->acceptNB();
+
+    // The writer needs to read its own data, and to know the reader before
+    // sending, otherwise it does not wait for its acks.
+    const co::Connections writers = _accept( writer );
+    const co::Connections readers = _accept( reader );
+    Reader self( _find( writers, _getID( writer )));
+    Reader remote( _find( readers, _getID( writer )));
+    LBCHECK( _find( writers, _getID( reader )));
+    LBCHECK( self.start( ));
+    LBCHECK( remote.start( ));
+
+    std::vector< uint8_t > data( PACKETSIZE );
+    const std::clock_t cpuStart = std::clock();
+    lunchbox::Clock clock;
+    for( size_t i = 0; i < N_PACKETS; ++i )
+        LBCHECK( writer->send( &data.front(), PACKETSIZE ));
+    LBCHECK( remote.join( ));
+    const float time = clock.getTimef();
+    LBCHECK( self.join( ));
+    const float cpuTime = float( std::clock() - cpuStart ) * 1000.f /
+                          float( CLOCKS_PER_SEC );
+
+    // CPU time covers all threads, i.e., sender, receiver and applications
+    std::cout << "RSP loopback multicast, " << PACKETSIZE << " byte writes: "
+              << float( N_PACKETS ) * PACKETSIZE / 1048.576f / time
+              << " MB/s, " << cpuTime / time * 100.f << "% CPU" << std::endl;
+
+    reader->close();
+    writer->close();
+
+    co::exit();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,140 @@
+
+/* Copyright (c) 2026, The Collage Authors
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Compares the round-trip latency and bandwidth of shared memory connections
+// with TCP loopback.
+// Usage: coSHMperf
+
+#include <co/buffer.h>
+#include <co/connection.h>
+#include <co/connectionDescription.h>
+#include <co/init.h>
+#include <lunchbox/clock.h>
+#include <lunchbox/thread.h>
+
+#include <iostream>
+
+#define N_PINGS 10000
+#define PING_SIZE 8
+#define BULK_SIZE 1048576
+#define N_BULK 256
+
+namespace
+{
+class Echo : public lunchbox::Thread
+{
+public:
+    explicit Echo( co::ConnectionPtr connection )
+        : _connection( connection ) {}
+
+    virtual void run()
+    {
+        co::Buffer buffer;
+        co::BufferPtr syncBuffer;
+        for( size_t i = 0; i < N_PINGS; ++i )
+        {
+            buffer.setSize( 0 );
+            _connection->recvNB( &buffer, PING_SIZE );
+            LBCHECK( _connection->recvSync( syncBuffer ));
+            LBCHECK( _connection->send( buffer.getData(), PING_SIZE ));
+        }
+
+        for( size_t i = 0; i < N_BULK; ++i )
+        {
+            buffer.setSize( 0 );
+            _connection->recvNB( &buffer, BULK_SIZE );
+            LBCHECK( _connection->recvSync( syncBuffer ));
+            LBCHECK( buffer[ 0 ] == uint8_t( i ));
+        }
+    }
+
+private:
+    co::ConnectionPtr _connection;
+};
+
+void _connect( const co::ConnectionType type, co::ConnectionPtr& writer,
+               co::ConnectionPtr& reader )
+{
+    co::ConnectionDescriptionPtr desc = new co::ConnectionDescription;
+    desc->type = type;
+    desc->setHostname( "127.0.0.1" );
+
+    co::ConnectionPtr listener = co::Connection::create( desc );
+    LBCHECK( listener );
+    LBCHECK( listener->listen( ));
+    listener->acceptNB();
+
+    writer = co::Connection::create( desc );
+    LBCHECK( writer->connect( ));
+    reader = listener->acceptSync();
+    LBCHECK( reader );
+}
+
+void _measure( const co::ConnectionType type )
+{
+    co::ConnectionPtr writer;
+    co::ConnectionPtr reader;
+    _connect( type, writer, reader );
+
+    Echo echo( reader );
+    LBCHECK( echo.start( ));
+
+    co::Buffer buffer;
+    co::BufferPtr syncBuffer;
+    const uint8_t ping[ PING_SIZE ] = { 0 };
+
+    lunchbox::Clock clock;
+    for( size_t i = 0; i < N_PINGS; ++i )
+    {
+        LBCHECK( writer->send( ping, PING_SIZE ));
+        buffer.setSize( 0 );
+        writer->recvNB( &buffer, PING_SIZE );
+        LBCHECK( writer->recvSync( syncBuffer ));
+    }
+    const float latency = clock.getTimef() * 1000.f / N_PINGS;
+
+    co::Buffer data;
+    data.resize( BULK_SIZE );
+    clock.reset();
+    for( size_t i = 0; i < N_BULK; ++i )
+    {
+        data[ 0 ] = uint8_t( i );
+        LBCHECK( writer->send( data.getData(), BULK_SIZE ));
+    }
+    LBCHECK( echo.join( ));
+    const float bandwidth = N_BULK * 1000.f / clock.getTimef();
+
+    std::cout << type << ": " << latency << " us round-trip, " << bandwidth
+              << " MB/s" << std::endl;
+
+    writer->close();
+    reader->close();
+}
+}
+
+int main( int argc, char **argv )
+{
+    LBCHECK( co::init( argc, argv ));
+
+    _measure( co::CONNECTIONTYPE_TCPIP );
+#ifdef __linux__
+    _measure( co::CONNECTIONTYPE_SHM );
+#endif
+
+    co::exit();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,185 @@
+
+/* Copyright (c) 2026, The Collage Authors
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Compares the socket tuning attributes using traffic shaped like object
+// commits: small synchronous request-reply round trips, and streams of 64 KB
+// and 1 MB data commands.
+// Usage: coSocketTuningperf
+
+#include <co/buffer.h>
+#include <co/connection.h>
+#include <co/connectionDescription.h>
+#include <co/global.h>
+#include <co/init.h>
+#include <lunchbox/clock.h>
+#include <lunchbox/thread.h>
+
+#include <iostream>
+
+#define N_PINGS 10000
+#define PING_SIZE 64
+#define N_SMALL 4096
+#define SMALL_SIZE 65536
+#define N_LARGE 256
+#define LARGE_SIZE 1048576
+
+namespace
+{
+class Echo : public lunchbox::Thread
+{
+public:
+    explicit Echo( co::ConnectionPtr connection )
+        : _connection( connection ) {}
+
+    virtual void run()
+    {
+        co::Buffer buffer;
+        co::BufferPtr syncBuffer;
+        for( size_t i = 0; i < N_PINGS; ++i )
+        {
+            buffer.setSize( 0 );
+            _connection->recvNB( &buffer, PING_SIZE );
+            LBCHECK( _connection->recvSync( syncBuffer ));
+            LBCHECK( _connection->send( buffer.getData(), PING_SIZE ));
+        }
+
+        _receive( N_SMALL, SMALL_SIZE );
+        _receive( N_LARGE, LARGE_SIZE );
+    }
+
+private:
+    co::ConnectionPtr _connection;
+
+    void _receive( const size_t nPackets, const uint64_t size )
+    {
+        co::Buffer buffer;
+        co::BufferPtr syncBuffer;
+        for( size_t i = 0; i < nPackets; ++i )
+        {
+            buffer.setSize( 0 );
+            _connection->recvNB( &buffer, size );
+            LBCHECK( _connection->recvSync( syncBuffer ));
+            LBCHECK( buffer[ 0 ] == uint8_t( i ));
+        }
+        // ack the stream, so the sender measures until all data arrived
+        LBCHECK( _connection->send( buffer.getData(), 1 ));
+    }
+};
+
+float _stream( co::ConnectionPtr writer, const size_t nPackets,
+               const uint64_t size )
+{
+    co::Buffer data;
+    data.resize( size );
+
+    lunchbox::Clock clock;
+    for( size_t i = 0; i < nPackets; ++i )
+    {
+        data[ 0 ] = uint8_t( i );
+        LBCHECK( writer->send( data.getData(), size ));
+    }
+
+    co::Buffer buffer;
+    co::BufferPtr syncBuffer;
+    writer->recvNB( &buffer, 1 );
+    LBCHECK( writer->recvSync( syncBuffer ));
+    return float( nPackets * size ) / 1048.576f / clock.getTimef();
+}
+
+void _measure( const std::string& name )
+{
+    co::ConnectionDescriptionPtr desc = new co::ConnectionDescription;
+    desc->type = co::CONNECTIONTYPE_TCPIP;
+    desc->setHostname( "127.0.0.1" );
+
+    co::ConnectionPtr listener = co::Connection::create( desc );
+    LBCHECK( listener->listen( ));
+    listener->acceptNB();
+
+    co::ConnectionPtr writer = co::Connection::create( desc );
+    LBCHECK( writer->connect( ));
+    co::ConnectionPtr reader = listener->acceptSync();
+    LBCHECK( reader );
+    listener->close();
+
+    Echo echo( reader );
+    LBCHECK( echo.start( ));
+
+    co::Buffer buffer;
+    co::BufferPtr syncBuffer;
+    const uint8_t ping[ PING_SIZE ] = { 0 };
+
+    lunchbox::Clock clock;
+    for( size_t i = 0; i < N_PINGS; ++i )
+    {
+        LBCHECK( writer->send( ping, PING_SIZE ));
+        buffer.setSize( 0 );
+        writer->recvNB( &buffer, PING_SIZE );
+        LBCHECK( writer->recvSync( syncBuffer ));
+    }
+    const float latency = clock.getTimef() * 1000.f / N_PINGS;
+    const float small = _stream( writer, N_SMALL, SMALL_SIZE );
+    const float large = _stream( writer, N_LARGE, LARGE_SIZE );
+    LBCHECK( echo.join( ));
+
+    std::cout << name << ": " << latency << " us round-trip, " << small
+              << " MB/s in 64 KB, " << large << " MB/s in 1 MB" << std::endl;
+
+    writer->close();
+    reader->close();
+}
+
+struct Profile
+{
+    const char* name;
+    co::Global::IAttribute attribute;
+    int32_t value;
+};
+
+const Profile _profiles[] =
+{
+    { "default", co::Global::IATTR_ALL, 0 },
+    { "buffers for 1 ms RTT", co::Global::IATTR_TCPIP_BUFFER_RTT_US, 1000 },
+    { "busy poll 50 us", co::Global::IATTR_TCPIP_BUSY_POLL_US, 50 },
+    { "quick ack", co::Global::IATTR_TCPIP_QUICKACK, 1 },
+    { "zero copy from 64 KB", co::Global::IATTR_TCPIP_ZEROCOPY_SIZE, 65536 }
+};
+}
+
+int main( int argc, char **argv )
+{
+    LBCHECK( co::init( argc, argv ));
+
+    const size_t nProfiles = sizeof( _profiles ) / sizeof( Profile );
+    for( size_t i = 0; i < nProfiles; ++i )
+    {
+        const Profile& profile = _profiles[ i ];
+        if( profile.attribute == co::Global::IATTR_ALL )
+        {
+            _measure( profile.name );
+            continue;
+        }
+
+        const int32_t old = co::Global::getIAttribute( profile.attribute );
+        co::Global::setIAttribute( profile.attribute, profile.value );
+        _measure( profile.name );
+        co::Global::setIAttribute( profile.attribute, old );
+    }
+
+    co::exit();
+    return EXIT_SUCCESS;
+}
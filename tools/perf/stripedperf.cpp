@@ -0,0 +1,123 @@
+
+/* Copyright (c) 2026, The Collage Authors
+ *
+ * This library is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU Lesser General Public License version 2.1 as published
+ * by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Compares the bandwidth of striped connections with TCP loopback.
+// Usage: coStripedperf
+
+#include <co/buffer.h>
+#include <co/connection.h>
+#include <co/connectionDescription.h>
+#include <co/connectionSet.h>
+#include <co/init.h>
+#include <lunchbox/clock.h>
+#include <lunchbox/thread.h>
+
+#include <iostream>
+
+#define LARGE_SIZE 1048576
+#define N_BULK 1024
+
+namespace
+{
+class Reader : public lunchbox::Thread
+{
+public:
+    explicit Reader( co::ConnectionPtr connection )
+        : _connection( connection ) {}
+
+    virtual void run()
+    {
+        co::Buffer buffer;
+        co::BufferPtr syncBuffer;
+        for( size_t i = 0; i < N_BULK; ++i )
+        {
+            buffer.setSize( 0 );
+            _connection->recvNB( &buffer, LARGE_SIZE );
+            LBCHECK( _connection->recvSync( syncBuffer ));
+            LBCHECK( buffer[ 0 ] == uint8_t( i ));
+        }
+    }
+
+private:
+    co::ConnectionPtr _connection;
+};
+
+void _connect( const co::ConnectionType type, co::ConnectionPtr& writer,
+               co::ConnectionPtr& reader )
+{
+    co::ConnectionDescriptionPtr desc = new co::ConnectionDescription;
+    desc->type = type;
+    desc->setHostname( "127.0.0.1" );
+
+    co::ConnectionPtr listener = co::Connection::create( desc );
+    LBCHECK( listener );
+    LBCHECK( listener->listen( ));
+    listener->acceptNB();
+
+    writer = co::Connection::create( desc );
+    LBCHECK( writer->connect( ));
+
+    // striped connections complete their handshake over several accepts
+    co::ConnectionSet set;
+    set.addConnection( listener );
+    while( !reader )
+    {
+        LBCHECK( set.select( 10000 ) == co::ConnectionSet::EVENT_CONNECT );
+        reader = listener->acceptSync();
+    }
+    listener->close();
+}
+
+void _measure( const co::ConnectionType type )
+{
+    co::ConnectionPtr writer;
+    co::ConnectionPtr reader;
+    _connect( type, writer, reader );
+
+    Reader thread( reader );
+    LBCHECK( thread.start( ));
+
+    co::Buffer data;
+    data.resize( LARGE_SIZE );
+    lunchbox::Clock clock;
+    for( size_t i = 0; i < N_BULK; ++i )
+    {
+        data[ 0 ] = uint8_t( i );
+        LBCHECK( writer->send( data.getData(), LARGE_SIZE ));
+    }
+    LBCHECK( thread.join( ));
+    const float bandwidth = N_BULK * 1000.f / clock.getTimef();
+
+    std::cout << type << ": " << bandwidth << " MB/s" << std::endl;
+
+    writer->close();
+    reader->close();
+}
+}
+
+int main( int argc, char **argv )
+{
+    LBCHECK( co::init( argc, argv ));
+
+    _measure( co::CONNECTIONTYPE_TCPIP );
+#ifdef __linux__
+    _measure( co::CONNECTIONTYPE_STRIPED );
+#endif
+
+    co::exit();
+    return EXIT_SUCCESS;
+}